@@ -0,0 +1,127 @@
+// Measures the parser throughput on the adversarial inputs (deeply nested
+// syntax, thousands of unmatched delimiters, long link-like runs and so on)
+// that used to make the parser quadratic or worse. The throughput of every
+// input must stay in the same order as the plain text.
+//
+// Usage : md2bench [input size in bytes] [directory of markdown files]
+//
+// Markdown files in the directory are measured as well.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+#include "parser.h"
+
+namespace {
+
+constexpr size_t kDefaultInputSize = 1 << 20;
+constexpr int kNumRuns = 5;
+
+struct BenchInput {
+  std::string name;
+  std::string content;
+};
+
+// Repeats the unit until the content reaches the size.
+std::string Repeat(std::string_view unit, size_t size) {
+  std::string content;
+  content.reserve(size + unit.size());
+  while (content.size() < size) {
+    content.append(unit);
+  }
+  return content;
+}
+
+std::vector<BenchInput> BuildAdversarialInputs(size_t size) {
+  std::vector<BenchInput> inputs = {
+      {"plain_text", Repeat("가나다라 마바사 abc def.\n", size)},
+      {"unclosed_math", Repeat("\\[ x ", size)},
+      {"unclosed_math_in_link", Repeat("[$$ x ", size)},
+      {"unmatched_brackets", Repeat("[ x ", size)},
+      {"link_like_runs", Repeat("[a](b ", size)},
+      {"unclosed_code_boxes", Repeat("```cpp\nint a;\n", size)},
+      {"unclosed_boxes", Repeat("```note\na\n", size)},
+      {"nested_images", Repeat("![", size)},
+      {"nested_commands", Repeat("\\sidenote{", size)},
+      {"nested_emphasis", Repeat("**a *b ~~c ", size)},
+      {"image_description", "![" + std::string(size, 'a') + "=](x)"},
+      {"many_lists", Repeat("* a\n* b\n\n", size)},
+      {"many_headers", Repeat("# header\n\n", size)},
+      {"many_boxes", Repeat("```cpp\nint a;\n```\n\n", size)},
+  };
+
+  return inputs;
+}
+
+void AddMarkdownFiles(const std::filesystem::path& dir,
+                      std::vector<BenchInput>* inputs) {
+  for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+    if (entry.path().extension() != ".md") {
+      continue;
+    }
+
+    std::ifstream in(entry.path());
+    std::stringstream ss;
+    ss << in.rdbuf();
+    inputs->push_back({entry.path().filename().string(), ss.str()});
+  }
+}
+
+// Returns the best parsing time in ms.
+double MeasureParse(std::string_view content) {
+  double best_ms = 0;
+  for (int run = 0; run < kNumRuns; run++) {
+    const auto start = std::chrono::steady_clock::now();
+    md2::Parser parser;
+    md2::ParseTree tree = parser.GenerateParseTree(content);
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    if (run == 0 || elapsed.count() < best_ms) {
+      best_ms = elapsed.count();
+    }
+  }
+
+  return best_ms;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t size = kDefaultInputSize;
+  if (argc > 1) {
+    size = std::strtoull(argv[1], nullptr, 10);
+  }
+
+  std::vector<BenchInput> inputs = BuildAdversarialInputs(size);
+  if (argc > 2) {
+    AddMarkdownFiles(argv[2], &inputs);
+  }
+
+  std::string worst_input;
+  double worst_throughput = 0;
+  for (const auto& input : inputs) {
+    const double ms = MeasureParse(input.content);
+    const double throughput = input.content.size() / ms / 1000;
+    std::cout << fmt::format("{:<25} {:>10} bytes {:>10.2f} ms {:>10.2f} MB/s",
+                             input.name, input.content.size(), ms, throughput)
+              << std::endl;
+
+    if (worst_input.empty() || throughput < worst_throughput) {
+      worst_input = input.name;
+      worst_throughput = throughput;
+    }
+  }
+
+  std::cout << fmt::format("Worst : {} ({:.2f} MB/s)", worst_input,
+                           worst_throughput)
+            << std::endl;
+}
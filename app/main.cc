@@ -10,4 +10,8 @@ int main(int argc, char* argv[]) {
   std::cout << "Output :" << option.output_dir << std::endl;
   md2::Driver driver(option);
   driver.Run();
+
+  if (option.watch) {
+    driver.Watch();
+  }
 }
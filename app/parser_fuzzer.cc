@@ -0,0 +1,43 @@
+// libFuzzer target of the parser. Besides the crashes, it reports the inputs
+// that take longer than the time budget that is linear to the input size, so
+// that the parser stays linear on whatever the fuzzer comes up with.
+//
+// Build with -DMD2_BUILD_FUZZER=ON (requires clang) and run
+//   md2fuzzer [corpus directory]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+#include "parser.h"
+
+namespace {
+
+// Generous enough for the sanitizer builds.
+constexpr int64_t kBaseBudgetUs = 50'000;
+constexpr int64_t kBudgetUsPerByte = 20;
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  std::string_view content(reinterpret_cast<const char*>(data), size);
+
+  const auto start = std::chrono::steady_clock::now();
+  md2::Parser parser;
+  md2::ParseTree tree = parser.GenerateParseTree(content);
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  const int64_t budget =
+      kBaseBudgetUs + kBudgetUsPerByte * static_cast<int64_t>(size);
+  if (elapsed.count() > budget) {
+    std::fprintf(stderr, "Parsing %zu bytes took %lld us (budget : %lld us)\n",
+                 size, static_cast<long long>(elapsed.count()),
+                 static_cast<long long>(budget));
+    std::abort();
+  }
+
+  return 0;
+}
@@ -0,0 +1,113 @@
+// Measures the throughput of the generators (HTML and LaTeX) on the parsed
+// trees. Parsing is not included. The LaTeX escaper alone is measured on the
+// whole text as well.
+//
+// Usage : md2renderbench [directory of markdown files]
+//
+// The markdown files under the directory are read recursively (e.g. the book
+// chapters). Without the directory, a synthetic document that is mostly the
+// text with a few inline nodes per paragraph is measured.
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+#include "generators/html_generator.h"
+#include "generators/latex_escape.h"
+#include "generators/latex_generator.h"
+#include "parser.h"
+
+namespace {
+
+constexpr size_t kSyntheticSize = 4 << 20;
+constexpr int kNumRuns = 5;
+
+std::string BuildSyntheticDocument() {
+  constexpr std::string_view kParagraph =
+      "Some text with **bold** and *italic* words, `code` and a [link](url) "
+      "with special characters like <, > & _ % $ # and ~ that must be "
+      "escaped.\n\n";
+
+  std::string content;
+  while (content.size() < kSyntheticSize) {
+    content.append(kParagraph);
+  }
+  return content;
+}
+
+std::string ReadMarkdownFiles(const std::filesystem::path& dir) {
+  std::string content;
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator(dir)) {
+    if (entry.path().extension() != ".md") {
+      continue;
+    }
+
+    std::ifstream in(entry.path());
+    std::stringstream ss;
+    ss << in.rdbuf();
+    content.append(ss.str());
+    content.append("\n\n");
+  }
+  return content;
+}
+
+// Returns the best time of the generate in ms.
+double Measure(const std::function<void()>& generate) {
+  double best_ms = 0;
+  for (int run = 0; run < kNumRuns; run++) {
+    const auto start = std::chrono::steady_clock::now();
+    generate();
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    if (run == 0 || elapsed.count() < best_ms) {
+      best_ms = elapsed.count();
+    }
+  }
+
+  return best_ms;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::string content =
+      argc > 1 ? ReadMarkdownFiles(argv[1]) : BuildSyntheticDocument();
+
+  md2::Parser parser;
+  md2::ParseTree tree = parser.GenerateParseTree(content);
+
+  md2::MetadataRepo repo;
+  md2::GeneratorContext context(repo, /*image_path=*/"",
+                                /*use_clang_server=*/false,
+                                /*clang_server_port=*/0, nullptr);
+
+  const double html_ms = Measure([&] {
+    md2::HTMLGenerator generator("bench.md", content, context, tree);
+    generator.Generate();
+  });
+  const double latex_ms = Measure([&] {
+    md2::LatexGenerator generator("bench.md", content, context, tree);
+    generator.Generate();
+  });
+  const double escape_ms = Measure([&] {
+    std::string escaped;
+    md2::AppendEscapedLatex(content, &escaped);
+  });
+
+  for (const auto& [name, ms] :
+       {std::pair{"html", html_ms}, std::pair{"latex", latex_ms},
+        std::pair{"escape", escape_ms}}) {
+    std::cout << fmt::format("{:<6} {:>10} bytes {:>10.2f} ms {:>10.2f} MB/s",
+                             name, content.size(), ms,
+                             content.size() / ms / 1000)
+              << std::endl;
+  }
+}
@@ -23,7 +23,7 @@ int main(int argc, char* argv[]) {
   std::cout << "*********************************" << std::endl;
   socket.bind(connection_str);
 
-  md2::MarkdownServer server;
+  md2::MarkdownServer server(option.parse_tree_cache_dir);
   while (true) {
     zmq::message_t request_message;
     auto received_size = socket.recv(request_message);
@@ -38,7 +38,12 @@ int main(int argc, char* argv[]) {
 
     try {
       json request = json::parse(request_message.to_string_view());
-      socket.send(server.HandleRequest(request), zmq::send_flags::none);
+      std::vector<zmq::message_t> frames = server.HandleRequest(request);
+      for (size_t i = 0; i < frames.size(); i++) {
+        socket.send(std::move(frames[i]), i + 1 < frames.size()
+                                              ? zmq::send_flags::sndmore
+                                              : zmq::send_flags::none);
+      }
     } catch (std::exception& e) {
       socket.send(md2::CreateError(e.what()), zmq::send_flags::none);
     }
@@ -12,29 +12,93 @@ namespace {
 static const std::unordered_set<std::string> kSupportedServices = {
     "ConvertMarkdownToHtml"};
 
+// Parse from scratch once the arena is this many times larger than the tree.
+constexpr size_t kMaxArenaGrowth = 4;
+
+// The edit is given as {"start", "old_end", "new_end"} (see TextEdit).
+std::optional<TextEdit> GetEdit(const json& request) {
+  if (!request.count("edit")) {
+    return std::nullopt;
+  }
+
+  const json& edit = request["edit"];
+  if (!edit.count("start") || !edit.count("old_end") ||
+      !edit.count("new_end")) {
+    return std::nullopt;
+  }
+
+  return TextEdit{.start = edit["start"].get<int>(),
+                  .old_end = edit["old_end"].get<int>(),
+                  .new_end = edit["new_end"].get<int>()};
+}
+
+std::vector<zmq::message_t> SingleFrame(zmq::message_t message) {
+  std::vector<zmq::message_t> frames;
+  frames.push_back(std::move(message));
+  return frames;
+}
+
+void DeleteChunk(void* /*data*/, void* hint) {
+  delete static_cast<std::string*>(hint);
+}
+
+// ZMQ frees the chunk once it is sent.
+zmq::message_t ChunkFrame(std::string chunk) {
+  auto* owned = new std::string(std::move(chunk));
+  return zmq::message_t(owned->data(), owned->size(), DeleteChunk, owned);
+}
+
+// Returns true if the edit turns old_markdown into new_markdown; The text
+// outside of the edit must be the same. Otherwise (e.g the client sent a
+// stale or a wrong range), applying the edit silently builds a wrong tree.
+bool IsValidEdit(const TextEdit& edit, std::string_view old_markdown,
+                 std::string_view new_markdown) {
+  const size_t old_size = old_markdown.size();
+  const size_t new_size = new_markdown.size();
+  if (!(0 <= edit.start && edit.start <= edit.old_end &&
+        edit.start <= edit.new_end &&
+        static_cast<size_t>(edit.old_end) <= old_size &&
+        static_cast<size_t>(edit.new_end) <= new_size &&
+        old_size - edit.old_end == new_size - edit.new_end)) {
+    return false;
+  }
+
+  return old_markdown.substr(0, edit.start) ==
+             new_markdown.substr(0, edit.start) &&
+         old_markdown.substr(edit.old_end) == new_markdown.substr(edit.new_end);
 }
 
-zmq::message_t MarkdownServer::HandleRequest(const json& request) {
+}  // namespace
+
+std::vector<zmq::message_t> MarkdownServer::HandleRequest(
+    const json& request) {
   if (!request.count("request_name")) {
-    return CreateError("Request name is missing.");
+    return SingleFrame(CreateError("Request name is missing."));
   }
 
   std::string request_name = request["request_name"].get<std::string>();
   if (!IsSupportedServce(request_name)) {
-    return CreateError("Unsupported service : " + request_name);
+    return SingleFrame(CreateError("Unsupported service : " + request_name));
   }
 
   md2::ConvertMarkdownToHtmlResponse response = ConvertMarkdownToHtml(request);
+  if (!response.is_ok) {
+    return SingleFrame(CreateError(response.error_msg));
+  }
 
-  if (response.is_ok) {
-    json rep;
-    rep["result"] = true;
-    rep["payload"] = response.html;
+  json rep;
+  rep["result"] = true;
+  if (!request.value("multipart", false)) {
+    rep["payload"] = std::move(response.html).ToString();
+    return SingleFrame(zmq::message_t(rep.dump()));
+  }
 
-    return zmq::message_t(rep.dump());
-  } else {
-    return CreateError(response.error_msg);
+  rep["payload_size"] = response.html.Size();
+  std::vector<zmq::message_t> frames = SingleFrame(zmq::message_t(rep.dump()));
+  for (std::string& chunk : std::move(response.html).ReleaseChunks()) {
+    frames.push_back(ChunkFrame(std::move(chunk)));
   }
+  return frames;
 }
 
 bool MarkdownServer::IsSupportedServce(const std::string& service_name) const {
@@ -51,16 +115,50 @@ ConvertMarkdownToHtmlResponse MarkdownServer::ConvertMarkdownToHtml(
     return response;
   }
 
-  const std::string md = request["markdown"].get<std::string>();
-  const ParseTree tree = parser_.GenerateParseTree(md);
-
-  HTMLGenerator generator("", md, generator_context_, tree);
+  UpdateParseTree(request["markdown"].get<std::string>(), GetEdit(request));
 
   ConvertMarkdownToHtmlResponse response;
-  response.html = generator.Generate();
-  response.is_ok = true;
+  {
+    HTMLGenerator generator("", markdown_, generator_context_, *tree_);
+    generator.Generate(&response.html);
+    response.is_ok = true;
+  }
 
   return response;
 }
 
+void MarkdownServer::UpdateParseTree(std::string markdown,
+                                     const std::optional<TextEdit>& edit) {
+  const bool apply_edit =
+      tree_.has_value() && edit.has_value() &&
+      IsValidEdit(*edit, markdown_, markdown) &&
+      tree_->GetArena()->BytesUsed() <= kMaxArenaGrowth * full_parse_bytes_;
+
+  markdown_ = std::move(markdown);
+  if (apply_edit) {
+    tree_->ApplyEdit(*edit, markdown_, &parser_);
+    return;
+  }
+
+  std::unique_ptr<Arena> arena = tree_.has_value()
+                                     ? std::move(*tree_).ReleaseArena()
+                                     : std::make_unique<Arena>();
+  std::string cache_key;
+  std::optional<ParseTree> cached;
+  if (parse_tree_cache_) {
+    cache_key = ParseTreeCache::Key(markdown_);
+    cached = parse_tree_cache_->Load(cache_key, &arena);
+  }
+
+  if (cached) {
+    tree_ = std::move(cached);
+  } else {
+    tree_ = parser_.GenerateParseTree(markdown_, std::move(arena));
+    if (parse_tree_cache_) {
+      parse_tree_cache_->Store(cache_key, *tree_);
+    }
+  }
+  full_parse_bytes_ = tree_->GetArena()->BytesUsed();
+}
+
 }  // namespace md2
@@ -2,9 +2,14 @@
 #define SERVER_SERVER_H
 
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include "generators/generator_context.h"
+#include "output_sink.h"
+#include "parse_tree_cache.h"
 #include "parser.h"
 
 namespace md2 {
@@ -12,7 +17,7 @@ namespace md2 {
 using json = nlohmann::json;
 
 struct ConvertMarkdownToHtmlResponse {
-  std::string html;
+  OutputSink html;
 
   bool is_ok;
   std::string error_msg;
@@ -20,21 +25,50 @@ struct ConvertMarkdownToHtmlResponse {
 
 class MarkdownServer {
  public:
-  MarkdownServer()
+  // If parse_tree_cache_dir is not empty, the trees of the full parses are
+  // cached there (see ParseTreeCache).
+  explicit MarkdownServer(const std::string& parse_tree_cache_dir = "")
       : generator_context_(metadata_repo_, image_dir_path_,
                            /*use_clang_server=*/false,
                            /*clang_server_port=*/-1,
                            /*context=*/nullptr,
-                           GeneratorOptions{.server_mode = true}) {}
+                           GeneratorOptions{.server_mode = true}) {
+    if (!parse_tree_cache_dir.empty()) {
+      parse_tree_cache_.emplace(parse_tree_cache_dir);
+    }
+  }
 
-  // Handles the request.
-  zmq::message_t HandleRequest(const json& request);
+  // Handles the request and returns the frames of the reply.
+  //
+  // The reply is a single JSON frame with the html in "payload". If the
+  // request sets "multipart", the JSON frame has "payload_size" instead, and
+  // the html follows as the frames of its chunks; They are handed to ZMQ
+  // without the copy.
+  std::vector<zmq::message_t> HandleRequest(const json& request);
 
  private:
   bool IsSupportedServce(const std::string& service_name) const;
   ConvertMarkdownToHtmlResponse ConvertMarkdownToHtml(const json& request);
 
+  // Updates the parse tree to the markdown. If the edit from the markdown of
+  // the previous request is given, only the edited blocks are parsed again.
+  void UpdateParseTree(std::string markdown,
+                       const std::optional<TextEdit>& edit);
+
   Parser parser_;
+
+  // Markdown of the last request and its parse tree. The arena of the tree is
+  // reused by every request.
+  std::string markdown_;
+  std::optional<ParseTree> tree_;
+
+  // Bytes used by the tree right after it is parsed from scratch. ApplyEdit
+  // leaves the replaced nodes in the arena, so the tree is parsed from scratch
+  // again once the arena grows too much.
+  size_t full_parse_bytes_ = 0;
+
+  std::optional<ParseTreeCache> parse_tree_cache_;
+
   MetadataRepo metadata_repo_;
 
   const std::string image_dir_path_ = "";
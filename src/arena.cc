@@ -0,0 +1,88 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace md2 {
+
+Arena::Arena(size_t block_size) : block_size_(block_size) {}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+  size_t space = end_ - current_;
+  void* ptr = current_;
+  if (current_ == nullptr || !std::align(alignment, size, ptr, space)) {
+    // Enough room for the worst case padding.
+    AddBlock(size + alignment);
+
+    space = end_ - current_;
+    ptr = current_;
+    std::align(alignment, size, ptr, space);
+  }
+
+  current_ = static_cast<char*>(ptr) + size;
+  bytes_used_ += size;
+  return ptr;
+}
+
+void Arena::AddBlock(size_t min_size) {
+  const size_t size = std::max(min_size, block_size_);
+  blocks_.push_back(Block{
+      .data = std::make_unique_for_overwrite<char[]>(size), .size = size});
+
+  current_ = blocks_.back().data.get();
+  end_ = current_ + size;
+  capacity_ += size;
+}
+
+void Arena::Adopt(std::unique_ptr<Arena> other) {
+  // The current block must stay at the back.
+  auto pos = blocks_.empty() ? blocks_.end() : blocks_.end() - 1;
+  blocks_.insert(pos, std::make_move_iterator(other->blocks_.begin()),
+                 std::make_move_iterator(other->blocks_.end()));
+
+  capacity_ += other->capacity_;
+  bytes_used_ += other->bytes_used_;
+
+  other->blocks_.clear();
+  other->current_ = other->end_ = nullptr;
+  other->capacity_ = other->bytes_used_ = 0;
+}
+
+void Arena::Reset() {
+  if (blocks_.size() > 1) {
+    // Next document is likely to be of the similar size.
+    const size_t total_size = capacity_;
+    blocks_.clear();
+    capacity_ = 0;
+    AddBlock(total_size);
+  } else if (!blocks_.empty()) {
+    current_ = blocks_.back().data.get();
+    end_ = current_ + blocks_.back().size;
+  }
+
+  bytes_used_ = 0;
+}
+
+std::unique_ptr<Arena> ArenaPool::Acquire() {
+  std::lock_guard<std::mutex> lk(m_);
+  if (arenas_.empty()) {
+    return std::make_unique<Arena>();
+  }
+
+  std::unique_ptr<Arena> arena = std::move(arenas_.back());
+  arenas_.pop_back();
+  return arena;
+}
+
+void ArenaPool::Release(std::unique_ptr<Arena> arena) {
+  if (arena == nullptr) {
+    return;
+  }
+
+  arena->Reset();
+
+  std::lock_guard<std::mutex> lk(m_);
+  arenas_.push_back(std::move(arena));
+}
+
+}  // namespace md2
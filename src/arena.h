@@ -0,0 +1,102 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace md2 {
+
+// Monotonic bump allocator. Memory is only released all at once by Reset() or
+// when the arena is destroyed; Destructors of the objects that are created in
+// the arena are never run, so those objects must not own any memory outside
+// of the arena.
+//
+// The arena is also a memory_resource so that the std::pmr containers can
+// allocate from it. Not thread safe.
+class Arena : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  void* Allocate(size_t size, size_t alignment);
+
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  // Frees every allocation at once. The memory is kept for the next use; If
+  // the arena grew to multiple blocks, they are merged into one block that is
+  // large enough to hold everything that was allocated.
+  void Reset();
+
+  // Takes the blocks of the other arena, so that the objects that were created
+  // in it live as long as this arena does. E.g the trees that are built in
+  // parallel (each in its own arena) are merged into one tree.
+  void Adopt(std::unique_ptr<Arena> other);
+
+  // Total size of the blocks that are owned by the arena.
+  size_t Capacity() const { return capacity_; }
+
+  // Number of bytes that are allocated since the last Reset().
+  size_t BytesUsed() const { return bytes_used_; }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    return Allocate(bytes, alignment);
+  }
+
+  // Individual deallocation is a no-op.
+  void do_deallocate(void*, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+      noexcept override {
+    return this == &other;
+  }
+
+  // Adds a new block that can hold at least min_size bytes.
+  void AddBlock(size_t min_size);
+
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+  std::vector<Block> blocks_;
+
+  size_t block_size_;
+
+  // Free region of the current (last) block.
+  char* current_ = nullptr;
+  char* end_ = nullptr;
+
+  size_t capacity_ = 0;
+  size_t bytes_used_ = 0;
+};
+
+// Thread safe pool of the arenas, so that the memory of the arena can be
+// reused by the next document once the previous document is done.
+class ArenaPool {
+ public:
+  // Returns a reset arena.
+  std::unique_ptr<Arena> Acquire();
+
+  // Resets the arena and returns it to the pool.
+  void Release(std::unique_ptr<Arena> arena);
+
+ private:
+  std::mutex m_;
+  std::vector<std::unique_ptr<Arena>> arenas_;
+};
+
+}  // namespace md2
+
+#endif
@@ -61,6 +61,15 @@ std::optional<size_t> HandleSingleOption(std::string_view arg,
   return end;
 }
 
+std::optional<size_t> HandleSingleOption(std::string_view arg,
+                                         size_t option_detail_start,
+                                         size_t* option) {
+  auto [parsed_option, end] = GetOption(arg, option_detail_start);
+  *option = std::strtoull(parsed_option.data(), nullptr, 10);
+
+  return end;
+}
+
 template <typename T, typename Transformer>
 std::optional<size_t> HandleVectorOption(std::string_view arg,
                                          size_t option_detail_start,
@@ -161,6 +170,28 @@ std::optional<size_t> ReadFromJson(std::string_view arg,
     option->update_database = option_data["update_database"].get<bool>();
   }
 
+  if (option_data.count("incremental")) {
+    option->incremental = option_data["incremental"].get<bool>();
+  }
+
+  if (option_data.count("watch")) {
+    option->watch = option_data["watch"].get<bool>();
+  }
+
+  if (option_data.count("trace")) {
+    option->trace_path = option_data["trace"].get<std::string>();
+  }
+
+  if (option_data.count("parallel_parse_min_size")) {
+    option->parallel_parse_min_size =
+        option_data["parallel_parse_min_size"].get<size_t>();
+  }
+
+  if (option_data.count("parse_tree_cache_dir")) {
+    option->parse_tree_cache_dir =
+        option_data["parse_tree_cache_dir"].get<std::string>();
+  }
+
   if (option_data.count("update_database")) {
     option->use_new_schema = option_data["use_new_schema"].get<bool>();
   }
@@ -224,6 +255,34 @@ std::optional<size_t> HandleDriverOption(
     option.generate_latex = false;
 
     return option_detail_start;
+  } else if (option_name == "incremental") {
+    option.incremental = true;
+
+    return option_detail_start;
+  } else if (option_name == "watch") {
+    option.watch = true;
+
+    return option_detail_start;
+  } else if (option_name == "trace") {
+    if (!option_detail_start) {
+      return std::nullopt;
+    }
+
+    return HandleSingleOption(arg, *option_detail_start, &option.trace_path);
+  } else if (option_name == "parallel_parse_min_size") {
+    if (!option_detail_start) {
+      return std::nullopt;
+    }
+
+    return HandleSingleOption(arg, *option_detail_start,
+                              &option.parallel_parse_min_size);
+  } else if (option_name == "parse_tree_cache_dir") {
+    if (!option_detail_start) {
+      return std::nullopt;
+    }
+
+    return HandleSingleOption(arg, *option_detail_start,
+                              &option.parse_tree_cache_dir);
   } else if (option_name == "md2_server_port") {
     if (!option_detail_start) {
       return std::nullopt;
@@ -0,0 +1,74 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <queue>
+
+namespace md2 {
+
+// Multi producer, multi consumer queue that holds at most "capacity" items.
+// Push blocks while the queue is full, and Pop blocks while the queue is
+// empty. Once Close() is called, Pop returns the remaining items and then
+// nullopt.
+template <typename T>
+class BoundedQueue {
+ public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  // Returns false if the queue is closed (the item is dropped).
+  bool Push(T item) {
+    std::unique_lock<std::mutex> lk(m_);
+    not_full_.wait(lk, [this] { return closed_ || queue_.size() < capacity_; });
+    if (closed_) {
+      return false;
+    }
+
+    queue_.push(std::move(item));
+    lk.unlock();
+
+    not_empty_.notify_one();
+    return true;
+  }
+
+  // Returns nullopt if the queue is closed and there is no remaining item.
+  std::optional<T> Pop() {
+    std::unique_lock<std::mutex> lk(m_);
+    not_empty_.wait(lk, [this] { return closed_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return std::nullopt;
+    }
+
+    T item = std::move(queue_.front());
+    queue_.pop();
+    lk.unlock();
+
+    not_full_.notify_one();
+    return item;
+  }
+
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      closed_ = true;
+    }
+
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+ private:
+  const size_t capacity_;
+
+  std::mutex m_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+
+  std::queue<T> queue_;
+  bool closed_ = false;
+};
+
+}  // namespace md2
+
+#endif
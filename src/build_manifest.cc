@@ -0,0 +1,146 @@
+#include "build_manifest.h"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+
+#include "logger.h"
+
+namespace md2 {
+namespace {
+
+using json = nlohmann::json;
+
+// Bump this when the format of the manifest is changed.
+constexpr int kManifestVersion = 1;
+
+json EntryToJson(const BuildManifest::Entry& entry) {
+  json entry_json;
+  entry_json["content_hash"] = entry.content_hash;
+  entry_json["metadata_hash"] = entry.metadata_hash;
+  entry_json["book_dir"] = entry.book_dir;
+  entry_json["refs"] = entry.dependencies.refs;
+  entry_json["html_images"] = entry.dependencies.html_images;
+  entry_json["latex_images"] = entry.dependencies.latex_images;
+
+  return entry_json;
+}
+
+BuildManifest::Entry JsonToEntry(const json& entry_json) {
+  BuildManifest::Entry entry;
+  entry.content_hash = entry_json.at("content_hash").get<std::string>();
+  entry.metadata_hash = entry_json.at("metadata_hash").get<std::string>();
+  entry.book_dir = entry_json.at("book_dir").get<std::string>();
+  entry.dependencies.refs =
+      entry_json.at("refs").get<std::map<std::string, std::string>>();
+  entry.dependencies.html_images =
+      entry_json.at("html_images").get<std::map<std::string, std::string>>();
+  entry.dependencies.latex_images =
+      entry_json.at("latex_images").get<std::map<std::string, std::string>>();
+
+  return entry;
+}
+
+}  // namespace
+
+BuildManifest BuildManifest::Load(const std::string& path) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    return BuildManifest();
+  }
+
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+
+  std::optional<BuildManifest> manifest = ParseFromJson(buffer.str());
+  if (!manifest) {
+    LOG(0) << "Malformed build manifest " << path << "; Doing a full build.";
+    return BuildManifest();
+  }
+
+  return std::move(*manifest);
+}
+
+bool BuildManifest::Save(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    LOG(0) << "Unable to write the build manifest to " << path;
+    return false;
+  }
+
+  out << DumpAsJson();
+  return out.good();
+}
+
+std::optional<BuildManifest> BuildManifest::ParseFromJson(
+    std::string_view json_str) {
+  json manifest_json = json::parse(json_str, /*cb=*/nullptr,
+                                   /*allow_exceptions=*/false);
+  if (manifest_json.is_discarded() || !manifest_json.is_object()) {
+    return std::nullopt;
+  }
+
+  if (manifest_json.value("version", 0) != kManifestVersion) {
+    return std::nullopt;
+  }
+
+  BuildManifest manifest;
+  try {
+    manifest.options_fingerprint_ =
+        manifest_json.at("options").get<std::string>();
+    for (const auto& [file_name, entry_json] :
+         manifest_json.at("files").items()) {
+      manifest.entries_[file_name] = JsonToEntry(entry_json);
+    }
+  } catch (json::exception& e) {
+    return std::nullopt;
+  }
+
+  return manifest;
+}
+
+std::string BuildManifest::DumpAsJson() const {
+  json manifest_json;
+  manifest_json["version"] = kManifestVersion;
+  manifest_json["options"] = options_fingerprint_;
+
+  json files = json::object();
+  for (const auto& [file_name, entry] : entries_) {
+    files[file_name] = EntryToJson(entry);
+  }
+  manifest_json["files"] = std::move(files);
+
+  return manifest_json.dump();
+}
+
+const BuildManifest::Entry* BuildManifest::FindEntry(
+    std::string_view file_name) const {
+  auto itr = entries_.find(file_name);
+  if (itr == entries_.end()) {
+    return nullptr;
+  }
+
+  return &itr->second;
+}
+
+void BuildManifest::SetEntry(std::string_view file_name, Entry entry) {
+  entries_[std::string(file_name)] = std::move(entry);
+}
+
+bool BuildManifest::AddDependencies(
+    std::string_view file_name, const GeneratorDependencies& dependencies) {
+  auto itr = entries_.find(file_name);
+  if (itr == entries_.end()) {
+    return false;
+  }
+
+  GeneratorDependencies& deps = itr->second.dependencies;
+  deps.refs.insert(dependencies.refs.begin(), dependencies.refs.end());
+  deps.html_images.insert(dependencies.html_images.begin(),
+                          dependencies.html_images.end());
+  deps.latex_images.insert(dependencies.latex_images.begin(),
+                           dependencies.latex_images.end());
+  return true;
+}
+
+}  // namespace md2
@@ -0,0 +1,70 @@
+#ifndef BUILD_MANIFEST_H
+#define BUILD_MANIFEST_H
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "generators/generator_context.h"
+
+namespace md2 {
+
+// Records the state of every input file as of the last build. The driver uses
+// this in the incremental mode to skip the files that are not changed since
+// the last run.
+class BuildManifest {
+ public:
+  struct Entry {
+    // Sha256 of the entire file content.
+    std::string content_hash;
+
+    // Sha256 of the metadata section of the file.
+    std::string metadata_hash;
+
+    // Book directory that the tex file was emitted to (empty if none).
+    std::string book_dir;
+
+    // References and images that were resolved while generating the file.
+    GeneratorDependencies dependencies;
+  };
+
+  // Name of the manifest file under the output directory.
+  static constexpr std::string_view kManifestFileName = ".md2_manifest.json";
+
+  // Returns an empty manifest if the file does not exist or is malformed.
+  static BuildManifest Load(const std::string& path);
+  bool Save(const std::string& path) const;
+
+  static std::optional<BuildManifest> ParseFromJson(std::string_view json);
+  std::string DumpAsJson() const;
+
+  const Entry* FindEntry(std::string_view file_name) const;
+  void SetEntry(std::string_view file_name, Entry entry);
+
+  // Adds the dependencies to the existing entry. Returns false if the entry
+  // does not exist.
+  bool AddDependencies(std::string_view file_name,
+                       const GeneratorDependencies& dependencies);
+
+  const std::map<std::string, Entry, std::less<>>& GetEntries() const {
+    return entries_;
+  }
+
+  // Fingerprint of the driver options that affect the generated outputs. If
+  // it does not match, the entire manifest should be discarded.
+  std::string_view GetOptionsFingerprint() const {
+    return options_fingerprint_;
+  }
+  void SetOptionsFingerprint(std::string_view fingerprint) {
+    options_fingerprint_ = fingerprint;
+  }
+
+ private:
+  std::map<std::string, Entry, std::less<>> entries_;
+  std::string options_fingerprint_;
+};
+
+}  // namespace md2
+
+#endif
@@ -1,13 +1,47 @@
+#include "c_api.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "generators/generator_context.h"
 #include "generators/html_generator.h"
 #include "generators/hwp_generator.h"
 #include "generators/hwp_state.h"
 #include "generators/latex_generator.h"
 #include "metadata_repo.h"
+#include "output_sink.h"
 #include "parser.h"
 
+namespace {
+
+// Joins the chunks into the null terminated string (freed by deallocate()).
+const char* ToCString(const std::vector<std::string>& chunks) {
+  size_t size = 0;
+  for (const std::string& chunk : chunks) {
+    size += chunk.size();
+  }
+
+  char* c_str = new char[size + 1];
+  char* current = c_str;
+  for (const std::string& chunk : chunks) {
+    memcpy(current, chunk.data(), chunk.size());
+    current += chunk.size();
+  }
+  *current = '\0';
+
+  return c_str;
+}
+
+}  // namespace
+
 extern "C" {
 
+typedef struct OutputChunks {
+  std::vector<std::string> chunks;
+  size_t next = 0;
+} OutputChunks;
+
 typedef struct HtmlGenerateConfig {
   int inline_image_max_height;
 
@@ -15,8 +49,8 @@ typedef struct HtmlGenerateConfig {
   bool use_absolute_image_path = false;
 } HtmlGenerateConfig;
 
-const char* convert_markdown_to_html(const char* md,
-                                     HtmlGenerateConfig* render_config) {
+OutputChunks* convert_markdown_to_html_chunks(
+    const char* md, HtmlGenerateConfig* render_config) {
   md2::Parser parser;
   const md2::ParseTree tree = parser.GenerateParseTree(md);
 
@@ -35,12 +69,17 @@ const char* convert_markdown_to_html(const char* md,
           .inline_image_max_height = render_config->inline_image_max_height,
           .use_absolute_image_path = render_config->use_absolute_image_path});
 
-  generator.Generate();
+  md2::OutputSink html;
+  generator.Generate(&html);
 
-  std::string html = std::move(generator).ReleaseGeneratedTarget();
+  return new OutputChunks{.chunks = std::move(html).ReleaseChunks()};
+}
 
-  char* c_html = new char[html.length() + 1];
-  memcpy(c_html, html.c_str(), html.length() + 1);
+const char* convert_markdown_to_html(const char* md,
+                                     HtmlGenerateConfig* render_config) {
+  OutputChunks* html = convert_markdown_to_html_chunks(md, render_config);
+  const char* c_html = ToCString(html->chunks);
+  deallocate_output_chunks(html);
 
   return c_html;
 }
@@ -116,9 +155,9 @@ const char* convert_markdown_to_hwp(const char* md,
   return c_html;
 }
 
-const char* convert_markdown_to_latex(const char* md,
-                                      const char* image_dir_path,
-                                      bool no_latex_image) {
+OutputChunks* convert_markdown_to_latex_chunks(const char* md,
+                                               const char* image_dir_path,
+                                               bool no_latex_image) {
   md2::Parser parser;
   const md2::ParseTree tree = parser.GenerateParseTree(md);
 
@@ -133,15 +172,35 @@ const char* convert_markdown_to_latex(const char* md,
                                 /*context=*/nullptr, options);
 
   md2::LatexGenerator generator("", md, context, tree);
-  generator.Generate();
+  md2::OutputSink tex;
+  generator.Generate(&tex);
 
-  std::string tex = std::move(generator).ReleaseGeneratedTarget();
+  return new OutputChunks{.chunks = std::move(tex).ReleaseChunks()};
+}
 
-  char* c_html = new char[tex.length() + 1];
-  memcpy(c_html, tex.c_str(), tex.length() + 1);
+const char* convert_markdown_to_latex(const char* md,
+                                      const char* image_dir_path,
+                                      bool no_latex_image) {
+  OutputChunks* tex =
+      convert_markdown_to_latex_chunks(md, image_dir_path, no_latex_image);
+  const char* c_tex = ToCString(tex->chunks);
+  deallocate_output_chunks(tex);
 
-  return c_html;
+  return c_tex;
+}
+
+bool next_output_chunk(OutputChunks* chunks, const char** data, size_t* size) {
+  if (chunks->next == chunks->chunks.size()) {
+    return false;
+  }
+
+  const std::string& chunk = chunks->chunks[chunks->next++];
+  *data = chunk.data();
+  *size = chunk.size();
+  return true;
 }
 
 void deallocate(const char* s) { delete[] s; }
+
+void deallocate_output_chunks(OutputChunks* chunks) { delete chunks; }
 }
@@ -1,11 +1,14 @@
 #ifndef C_API_H
 #define C_API_H
 
+#include <stddef.h>
+
 extern "C" {
 
 struct HtmlGenerateConfig;
 struct HwpGenerateConfig;
 struct HwpConversionStatus;
+struct OutputChunks;
 
 // Convert markdown to html.
 const char* convert_markdown_to_html(const char* md,
@@ -24,8 +27,23 @@ const char* convert_markdown_to_latex(const char* md,
                                       const char* image_dir_path,
                                       bool no_latex_image);
 
+// Same as above, but the output is returned as the chunks that the generator
+// produced, without copying them into a single string. Iterate them with
+// next_output_chunk() and free with deallocate_output_chunks().
+OutputChunks* convert_markdown_to_html_chunks(
+    const char* md, HtmlGenerateConfig* render_config);
+OutputChunks* convert_markdown_to_latex_chunks(const char* md,
+                                               const char* image_dir_path,
+                                               bool no_latex_image);
+
+// Sets the next chunk (not null terminated) to data and size. Returns false if
+// there is no more chunk.
+bool next_output_chunk(OutputChunks* chunks, const char** data, size_t* size);
+
 // Custom deallocator for const char*.
 void deallocate(const char* s);
+
+void deallocate_output_chunks(OutputChunks* chunks);
 }
 
 #endif
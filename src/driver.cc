@@ -6,38 +6,45 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <optional>
+#include <utility>
 
+#include "bounded_queue.h"
 #include "db.h"
+#include "file_watcher.h"
 #include "generators/book.h"
 #include "generators/html_generator.h"
 #include "generators/latex_generator.h"
+#include "hash.h"
 #include "logger.h"
+#include "output_sink.h"
+#include "output_writer.h"
+#include "parallel_parser.h"
 #include "parse_tree.h"
 #include "parser.h"
 #include "thread_pool.h"
+#include "trace.h"
 
 namespace md2 {
 namespace {
 
 namespace fs = std::filesystem;
 
-std::string ReadFileContent(const std::string& file_path) {
-  std::ifstream in(file_path);
+// Editors often write a file multiple times on save.
+constexpr int kWatchDebounceMs = 50;
 
-  in.seekg(0, std::ios::end);
+// Number of files that are shown in the trace summary.
+constexpr size_t kNumSlowestFiles = 10;
 
-  std::string file_content;
-  file_content.reserve(in.tellg());
-
-  in.seekg(0, std::ios::beg);
-  file_content.assign(std::istreambuf_iterator<char>(in),
-                      std::istreambuf_iterator<char>());
-
-  return file_content;
-}
+// Input file to read.
+struct InputFile {
+  std::string path;
+  std::string file_name;
+  std::string rel_path;
+};
 
 std::string GenerateOutputPath(std::string_view file_name,
                                std::string_view output_dir,
@@ -46,6 +53,16 @@ std::string GenerateOutputPath(std::string_view file_name,
   return StrCat(output_dir, "/", p.stem().c_str(), ".", ext);
 }
 
+std::string GetFileHash(std::string_view content) {
+  return GenerateSha256Hash(content).value_or("");
+}
+
+void ReportTaskErrors(const std::vector<TaskError>& errors) {
+  for (const auto& error : errors) {
+    fmt::print(fmt::fg(fmt::color::red), "Task failed : {}\n", error.message);
+  }
+}
+
 // If the file_name is not a number then this will return nullopt.
 std::optional<std::string> NextPageToActualFileName(
     const std::string& file_name) {
@@ -58,24 +75,207 @@ std::optional<std::string> NextPageToActualFileName(
   return StrCat(file_name, ".md");
 }
 
+// In the watch mode, the input files can be rewritten in place while their
+// contents are in use (which changes the mapped pages or raises SIGBUS), so
+// they are copied instead of being mapped.
+std::unique_ptr<MappedFile> OpenInputFile(const std::string& path,
+                                          bool watch) {
+  return watch ? MappedFile::Read(path) : MappedFile::Open(path);
+}
+
+// Returns true if the path is under the dir.
+bool IsUnder(const fs::path& path, const fs::path& dir) {
+  fs::path rel = path.lexically_normal().lexically_relative(
+      dir.lexically_normal());
+  return !rel.empty() && *rel.begin() != "..";
+}
+
 }  // namespace
 
 void Driver::Run() {
   fmt::print(fmt::fg(fmt::color::red), "Starting driver \n");
+  if (!options_.trace_path.empty()) {
+    Tracer::GetTracer().Enable();
+  }
+
   ReadFilesInDirectory();
   BuildFileMetadataRepo();
   BuildBookFilesMap();
 
-  DoParse();
-  GenerateJSONFiles();
+  // Shared by every generator in this build.
+  generator_context_ = std::make_unique<GeneratorContext>(
+      repo_, options_.image_path, options_.use_clang_format_server,
+      options_.clang_format_server_port, zmq_context_.get());
 
-  if (options_.generate_latex) {
-    GenerateBookMainPage();
+  BuildManifest prev_manifest;
+  if (options_.incremental) {
+    prev_manifest = BuildManifest::Load(GetManifestPath());
   }
+  GenerateOutputs(FindFilesToParse(prev_manifest, /*changed_files=*/nullptr));
 
   if (options_.update_database) {
     UpdateDatabase();
   }
+
+  if (!options_.trace_path.empty()) {
+    WriteTrace();
+  }
+}
+
+void Driver::WriteTrace() const {
+  const Tracer& tracer = Tracer::GetTracer();
+  if (tracer.WriteChromeTrace(options_.trace_path)) {
+    fmt::print(fmt::fg(fmt::color::green), "Trace is written to {} \n",
+               options_.trace_path);
+  }
+
+  fmt::print("Slowest files : \n");
+  for (const auto& [file, duration] :
+       tracer.GetSlowestFiles(kNumSlowestFiles)) {
+    fmt::print(
+        "  {:>10.3f} ms  {} \n",
+        std::chrono::duration<double, std::milli>(duration).count(), file);
+  }
+}
+
+void Driver::Watch() {
+  FileWatcher watcher;
+  for (const auto& dir : options_.input_dirs) {
+    watcher.AddDirectory(dir);
+  }
+
+  // inotify can only watch the directories. Events of other files in the
+  // directory are filtered out at ReloadInputFile.
+  std::unordered_set<std::string> input_file_dirs;
+  for (const auto& file : options_.input_files) {
+    fs::path dir = fs::path(file).parent_path();
+    input_file_dirs.insert(dir.empty() ? "." : dir.string());
+  }
+  for (const auto& dir : input_file_dirs) {
+    watcher.AddDirectory(dir);
+  }
+
+  if (!options_.image_path.empty()) {
+    watcher.AddDirectory(options_.image_path);
+  }
+
+  while (true) {
+    fmt::print(fmt::fg(fmt::color::green), "Watching for changes ... \n");
+    std::vector<std::string> changed_paths =
+        watcher.WaitForChanges(kWatchDebounceMs);
+    if (changed_paths.empty()) {
+      LOG(0) << "Unable to watch the input files.";
+      return;
+    }
+
+    Rebuild(changed_paths);
+  }
+}
+
+void Driver::Rebuild(const std::vector<std::string>& changed_paths) {
+  auto start = std::chrono::steady_clock::now();
+
+  std::unordered_set<std::string> changed_files;
+  bool image_changed = false;
+  for (const auto& path : changed_paths) {
+    if (fs::path(path).extension() == ".md") {
+      if (ReloadInputFile(path)) {
+        changed_files.insert(fs::path(path).filename());
+      }
+    } else if (!options_.image_path.empty() &&
+               IsUnder(path, options_.image_path)) {
+      image_changed = true;
+    }
+  }
+
+  if (changed_files.empty() && !image_changed) {
+    return;
+  }
+
+  if (image_changed) {
+    // Safe since no generator is running; DoParse of the last build waits for
+    // every render worker, and nothing keeps the found images across builds.
+    generator_context_->ClearImageCache();
+  }
+
+  // Metadata of any file can change the references and the books so they are
+  // rebuilt from scratch; It is cheap since only the headers are parsed.
+  repo_.Clear();
+  BuildFileMetadataRepo();
+
+  book_dir_to_files_.clear();
+  book_start_to_remaining_.clear();
+  BuildBookFilesMap();
+
+  BuildManifest prev_manifest = std::exchange(manifest_, BuildManifest());
+  GenerateOutputs(FindFilesToParse(prev_manifest, &changed_files));
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  fmt::print(fmt::fg(fmt::color::green), "Rebuilt in {} ms \n",
+             elapsed.count());
+}
+
+bool Driver::ReloadInputFile(const std::string& path) {
+  std::string rel_path;
+  for (const auto& dir : options_.input_dirs) {
+    if (IsUnder(path, dir)) {
+      rel_path = fs::path(path).lexically_relative(dir);
+      break;
+    }
+  }
+
+  if (rel_path.empty()) {
+    for (const auto& file : options_.input_files) {
+      if (fs::path(file).lexically_normal() ==
+          fs::path(path).lexically_normal()) {
+        rel_path = fs::path(file).filename();
+        break;
+      }
+    }
+  }
+
+  if (rel_path.empty()) {
+    return false;
+  }
+
+  const std::string file_name = fs::path(path).filename();
+  if (!fs::exists(path)) {
+    file_contents_.erase(file_name);
+    mapped_files_.erase(file_name);
+    return true;
+  }
+
+  std::unique_ptr<MappedFile> mapped_file = OpenInputFile(path, options_.watch);
+  if (mapped_file == nullptr) {
+    return false;
+  }
+
+  file_contents_[file_name] =
+      std::make_tuple(mapped_file->Content(), 0, std::move(rel_path));
+  mapped_files_[file_name] = std::move(mapped_file);
+  return true;
+}
+
+void Driver::GenerateOutputs(const std::vector<std::string>& files_to_parse) {
+  DoParse(files_to_parse);
+
+  // Page list and the book main page only depend on the metadata.
+  if (metadata_changed_) {
+    GenerateJSONFiles();
+
+    if (options_.generate_latex) {
+      GenerateBookMainPage();
+    }
+  }
+
+  if (options_.incremental) {
+    manifest_.Save(GetManifestPath());
+  }
+}
+
+std::string Driver::GetManifestPath() const {
+  return StrCat(options_.output_dir, "/", BuildManifest::kManifestFileName);
 }
 
 void Driver::ReadFilesInDirectory() {
@@ -88,13 +288,8 @@ void Driver::ReadFilesInDirectory() {
 
   fmt::print("Start reading files -- \n");
 
-  int total_files = 0;
-  for (const auto& dir : options_.input_dirs) {
-    total_files += std::distance(fs::recursive_directory_iterator(dir),
-                                 fs::recursive_directory_iterator());
-  }
-
-  int num_read = 0;
+  // Walk the directories first; The actual reading is done in parallel.
+  std::vector<InputFile> input_files;
   for (const auto& dir : options_.input_dirs) {
     for (const auto& entry : fs::recursive_directory_iterator(dir)) {
       const fs::path& path = entry.path();
@@ -104,83 +299,394 @@ void Driver::ReadFilesInDirectory() {
         continue;
       }
 
-      file_contents_[path.filename()] = std::make_tuple(
-          ReadFileContent(path), 0, fs::relative(path, dir).c_str());
-
-      fmt::print(fmt::fg(fmt::color::green), "Reading files... [{}/{}]\n",
-                 ++num_read, total_files);
-      // Erase the previous line.
-      fmt::print("\033[A\33[2KT\r");
+      input_files.push_back(InputFile{.path = path,
+                                      .file_name = path.filename(),
+                                      .rel_path = fs::relative(path, dir)});
     }
   }
 
   for (const auto& file : options_.input_files) {
     const fs::path path(file);
-    file_contents_[path.filename()] =
-        std::make_tuple(ReadFileContent(path), 0, path.filename());
+    input_files.push_back(InputFile{.path = path,
+                                    .file_name = path.filename(),
+                                    .rel_path = path.filename()});
+  }
+
+  std::vector<std::unique_ptr<MappedFile>> mapped_files(input_files.size());
+  {
+    ThreadPool pool(options_.num_threads);
+    for (size_t i = 0; i < input_files.size(); i++) {
+      pool.Submit([&mapped_files, &input_files, i, watch = options_.watch]() {
+        TRACE_SCOPE("read", input_files[i].file_name);
+        mapped_files[i] = OpenInputFile(input_files[i].path, watch);
+      });
+    }
+    ReportTaskErrors(pool.WaitAll());
+  }
+
+  // Insert in the walking order so that the later file with the same name
+  // overrides the earlier one.
+  for (size_t i = 0; i < input_files.size(); i++) {
+    if (mapped_files[i] == nullptr) {
+      continue;
+    }
+
+    const std::string& file_name = input_files[i].file_name;
+    file_contents_[file_name] =
+        std::make_tuple(mapped_files[i]->Content(), 0,
+                        std::move(input_files[i].rel_path));
+    mapped_files_[file_name] = std::move(mapped_files[i]);
   }
+
+  fmt::print(fmt::fg(fmt::color::green), "Read {} files \n",
+             file_contents_.size());
 }
 
 void Driver::BuildFileMetadataRepo() {
+  std::vector<std::pair<const std::string*, FileInfo*>> files;
+  files.reserve(file_contents_.size());
   for (auto& [file_name, file_data] : file_contents_) {
-    auto& [content, read_pos, rel_path] = file_data;
-    auto metadata =
-        MetadataFactory::ParseMetadata(file_name, content, read_pos);
-    if (metadata) {
-      repo_.RegisterMetadata(file_name, std::move(metadata));
+    files.emplace_back(&file_name, &file_data);
+  }
+
+  // Metadata are parsed in parallel.
+  std::vector<std::unique_ptr<Metadata>> metadatas(files.size());
+  {
+    ThreadPool pool(options_.num_threads);
+    for (size_t i = 0; i < files.size(); i++) {
+      pool.Submit([&files, &metadatas, i]() {
+        TRACE_SCOPE("metadata", *files[i].first);
+        auto& [content, read_pos, rel_path] = *files[i].second;
+        metadatas[i] =
+            MetadataFactory::ParseMetadata(*files[i].first, content, read_pos);
+      });
+    }
+    ReportTaskErrors(pool.WaitAll());
+  }
+
+  // Registration is done in the iteration order of file_contents_ (which is
+  // the same as before) so that the order of the metadata that share the same
+  // reference does not depend on the thread scheduling.
+  for (size_t i = 0; i < files.size(); i++) {
+    if (metadatas[i]) {
+      repo_.RegisterMetadata(*files[i].first, std::move(metadatas[i]));
     }
   }
 }
 
-void Driver::DoParse() {
-  fmt::print(fmt::fg(fmt::color::green), "Start parsing ... \n");
-  ThreadPool pool(options_.num_threads);
+std::vector<std::string> Driver::FindFilesToParse(
+    const BuildManifest& prev_manifest,
+    const std::unordered_set<std::string>* changed_files) {
+  std::vector<std::string> files_to_parse;
+  if (!TracksManifest()) {
+    for (const auto& [file_name, file_info] : file_contents_) {
+      files_to_parse.push_back(file_name);
+    }
+
+    num_to_parse_ = files_to_parse.size();
+    return files_to_parse;
+  }
+
+  // If the options are changed, then every output is invalid.
+  const bool options_changed =
+      prev_manifest.GetOptionsFingerprint() != GetOptionsFingerprint();
+  manifest_.SetOptionsFingerprint(GetOptionsFingerprint());
+
+  metadata_changed_ = options_changed;
+  for (const auto& [file_name, file_info] : file_contents_) {
+    auto& [content, read_pos, rel_path] = file_info;
+
+    const BuildManifest::Entry* prev_entry =
+        options_changed ? nullptr : prev_manifest.FindEntry(file_name);
+
+    BuildManifest::Entry entry;
+    if (prev_entry != nullptr && changed_files != nullptr &&
+        changed_files->count(file_name) == 0) {
+      // The file is not touched since the last build.
+      entry.content_hash = prev_entry->content_hash;
+      entry.metadata_hash = prev_entry->metadata_hash;
+    } else {
+      entry.content_hash = GetFileHash(content);
+      entry.metadata_hash = GetFileHash(content.substr(0, read_pos));
+    }
+
+    if (auto itr = book_dir_to_files_.find(file_name);
+        itr != book_dir_to_files_.end()) {
+      entry.book_dir = itr->second;
+    }
+
+    if (prev_entry == nullptr ||
+        prev_entry->metadata_hash != entry.metadata_hash) {
+      metadata_changed_ = true;
+    }
+
+    if (prev_entry == nullptr || IsOutdated(file_name, *prev_entry, entry)) {
+      files_to_parse.push_back(file_name);
+    } else {
+      // The outputs are not regenerated so the dependencies remain the same.
+      entry.dependencies = prev_entry->dependencies;
+    }
 
-  for (auto& [file_name, content_and_pos] : file_contents_) {
-    auto& [file_content, pos, rel_path] = content_and_pos;
-    std::string_view content(file_content.c_str() + pos);
+    manifest_.SetEntry(file_name, std::move(entry));
+  }
+
+  // Check whether any file is removed.
+  for (const auto& [file_name, entry] : prev_manifest.GetEntries()) {
+    if (file_contents_.find(file_name) == file_contents_.end()) {
+      metadata_changed_ = true;
+      break;
+    }
+  }
+
+  fmt::print("{} out of {} files need to be regenerated. \n",
+             files_to_parse.size(), file_contents_.size());
+
+  num_to_parse_ = files_to_parse.size();
+  return files_to_parse;
+}
+
+bool Driver::IsOutdated(std::string_view file_name,
+                        const BuildManifest::Entry& prev_entry,
+                        const BuildManifest::Entry& entry) const {
+  GeneratorContext& context = *generator_context_;
+
+  if (prev_entry.content_hash != entry.content_hash ||
+      prev_entry.book_dir != entry.book_dir) {
+    return true;
+  }
+
+  if (options_.generate_html &&
+      !fs::exists(GenerateOutputPath(file_name, options_.output_dir, "html"))) {
+    return true;
+  }
+
+  if (!entry.book_dir.empty() &&
+      !fs::exists(GenerateOutputPath(file_name, entry.book_dir, "tex"))) {
+    return true;
+  }
+
+  const GeneratorDependencies& deps = prev_entry.dependencies;
+  for (const auto& [ref, resolved_file] : deps.refs) {
+    if (context.FindReference(ref).first != resolved_file) {
+      return true;
+    }
+  }
+
+  for (const auto& [image_url, resolved_image] : deps.html_images) {
+    if (context.FindImageForHtml(image_url) != resolved_image) {
+      return true;
+    }
+  }
+
+  for (const auto& [image_url, resolved_image] : deps.latex_images) {
+    if (context.FindImageForLatex(image_url) != resolved_image) {
+      return true;
+    }
+  }
 
-    pool.enqueue(
-        [this, content](std::string rel_path) {
-          size_t last_slash = rel_path.find_last_of('/');
-          if (last_slash != std::string::npos) {
-            rel_path = rel_path.substr(last_slash + 1);
+  return false;
+}
+
+std::string Driver::GetOptionsFingerprint() const {
+  return StrCat(options_.generate_html ? "html" : "no_html", ":",
+                options_.generate_latex ? "latex" : "no_latex", ":",
+                options_.output_dir, ":", options_.image_path);
+}
+
+struct Driver::ParsedFile {
+  ~ParsedFile() {
+    if (arena_pool != nullptr) {
+      arena_pool->Release(std::move(tree).ReleaseArena());
+    }
+  }
+
+  std::string file_name;
+  std::string_view content;
+  ParseTree tree;
+
+  // Pool that the arena of the tree is returned to.
+  ArenaPool* arena_pool = nullptr;
+};
+
+struct Driver::RenderTask {
+  enum Target { HTML, LATEX };
+
+  std::shared_ptr<ParsedFile> file;
+  Target target;
+  std::string output_path;
+};
+
+struct Driver::OutputFile {
+  std::string path;
+  OutputSink content;
+};
+
+void Driver::DoParse(const std::vector<std::string>& files_to_parse) {
+  fmt::print(fmt::fg(fmt::color::green), "Start parsing ... \n");
+  num_parsed_ = 0;
+
+  // Parse --> Render --> Write. Each stage is connected by the bounded queue
+  // so that at most few documents are in flight between the stages.
+  const size_t queue_size = 2 * options_.num_threads;
+  BoundedQueue<RenderTask> render_queue(queue_size);
+  OutputWriter writer(queue_size);
+
+  // Number of outputs that are failed to be rendered.
+  std::atomic<size_t> num_render_failed = 0;
+
+  {
+    ThreadPool render_pool(options_.num_threads);
+    for (size_t i = 0; i < options_.num_threads; i++) {
+      render_pool.Submit([this, &render_queue, &writer, &num_render_failed]() {
+        while (auto task = render_queue.Pop()) {
+          // Keep draining the queue even if one document fails; Otherwise
+          // the parse stage would block on the full queue.
+          try {
+            OutputFile output = Render(*task);
+            writer.Write(std::move(output.path), std::move(output.content));
+          } catch (const std::exception& e) {
+            LOG(0) << "Failed to generate " << task->output_path << " : "
+                   << e.what();
+            num_render_failed++;
+          } catch (...) {
+            LOG(0) << "Failed to generate " << task->output_path;
+            num_render_failed++;
           }
-          DoParse(content, rel_path);
-        },
-        rel_path);
+        }
+      });
+    }
+
+    {
+      // Larger documents are scheduled first so that the build does not end
+      // up waiting for a single huge document at the end.
+      ThreadPool parse_pool(options_.num_threads);
+      std::vector<size_t> task_ids = parse_pool.SubmitByCost(
+          files_to_parse,
+          [this, &render_queue, &parse_pool](const std::string& file_name) {
+            ParseAndEnqueueRenderTasks(file_name, render_queue, &parse_pool);
+          },
+          [this](const std::string& file_name) {
+            return std::get<0>(file_contents_.at(file_name)).size();
+          });
+
+      std::vector<TaskError> errors = parse_pool.WaitAll();
+      for (auto& error : errors) {
+        auto itr = std::find(task_ids.begin(), task_ids.end(), error.task_id);
+        error.message = StrCat(files_to_parse[itr - task_ids.begin()], " : ",
+                               error.message);
+      }
+      ReportTaskErrors(errors);
+    }
+
+    // Every file is parsed. Render workers finish once the queue is drained.
+    render_queue.Close();
+    ReportTaskErrors(render_pool.WaitAll());
+  }
+
+  writer.Finish();
+  fmt::print(fmt::fg(fmt::color::green),
+             "{} files are changed, {} files are unchanged. \n",
+             writer.NumWritten(), writer.NumUnchanged());
+  if (num_render_failed > 0) {
+    fmt::print(fmt::fg(fmt::color::red), "Failed to generate {} files. \n",
+               num_render_failed.load());
+  }
+  if (writer.NumFailed() > 0) {
+    fmt::print(fmt::fg(fmt::color::red), "Failed to write {} files. \n",
+               writer.NumFailed());
   }
 }
 
-void Driver::DoParse(std::string_view content, std::string_view file_name) {
+ParseTree Driver::ParseContent(std::string_view content,
+                               ThreadPool* parse_pool) {
+  std::string cache_key;
+  if (parse_tree_cache_) {
+    cache_key = ParseTreeCache::Key(content);
+    std::unique_ptr<Arena> arena = arena_pool_.Acquire();
+    if (std::optional<ParseTree> cached =
+            parse_tree_cache_->Load(cache_key, &arena)) {
+      return std::move(*cached);
+    }
+    arena_pool_.Release(std::move(arena));
+  }
+
+  const bool parse_in_parallel =
+      options_.parallel_parse_min_size > 0 &&
+      content.size() >= options_.parallel_parse_min_size;
+  ParseTree tree =
+      parse_in_parallel
+          ? ParallelParser(parse_pool).GenerateParseTree(content,
+                                                         arena_pool_.Acquire())
+          : Parser().GenerateParseTree(content, arena_pool_.Acquire());
+
+  if (parse_tree_cache_ && !parse_tree_cache_->Store(cache_key, tree)) {
+    LOG(0) << "Unable to cache the parse tree";
+  }
+  return tree;
+}
+
+void Driver::ParseAndEnqueueRenderTasks(const std::string& file_name,
+                                        BoundedQueue<RenderTask>& queue,
+                                        ThreadPool* parse_pool) {
+  auto& [file_content, pos, rel_path] = file_contents_.at(file_name);
+  std::string_view content = file_content.substr(pos);
+
   std::string output_file_name =
       GenerateOutputPath(file_name, options_.output_dir, "html");
 
   fmt::print("[{}/{}] Generating [{}] to [{}] \n", ++num_parsed_,
-             file_contents_.size(), file_name, output_file_name);
-
-  Parser parser;
-  const ParseTree tree = parser.GenerateParseTree(content);
+             num_to_parse_, file_name, output_file_name);
+
+  std::shared_ptr<ParsedFile> parsed;
+  {
+    TRACE_SCOPE("parse", file_name);
+    parsed.reset(new ParsedFile{.file_name = file_name,
+                                .content = content,
+                                .tree = ParseContent(content, parse_pool),
+                                .arena_pool = &arena_pool_});
+  }
 
-  GeneratorContext context(
-      repo_, options_.image_path, options_.use_clang_format_server,
-      options_.clang_format_server_port, zmq_context_.get());
   if (options_.generate_html) {
-    HTMLGenerator generator(file_name, content, context, tree);
-    generator.Generate();
-
-    std::ofstream out(output_file_name);
-    out << generator.ShowOutput();
+    queue.Push(RenderTask{.file = parsed,
+                          .target = RenderTask::HTML,
+                          .output_path = std::move(output_file_name)});
   }
 
-  if (auto itr = book_dir_to_files_.find(std::string(file_name));
+  if (auto itr = book_dir_to_files_.find(file_name);
       itr != book_dir_to_files_.end()) {
-    LatexGenerator generator(file_name, content, context, tree);
-    generator.Generate();
+    queue.Push(RenderTask{
+        .file = parsed,
+        .target = RenderTask::LATEX,
+        .output_path = GenerateOutputPath(file_name, itr->second, "tex")});
+  }
+}
+
+Driver::OutputFile Driver::Render(const RenderTask& task) {
+  const ParsedFile& file = *task.file;
+  TRACE_SCOPE(task.target == RenderTask::HTML ? "html" : "latex",
+              file.file_name);
+
+  // Records every reference and image that are resolved by the generator.
+  GeneratorDependencies dependencies;
+  ScopedDependencyRecorder recorder(&dependencies);
+
+  OutputSink content;
+  if (task.target == RenderTask::HTML) {
+    HTMLGenerator generator(file.file_name, file.content, *generator_context_,
+                            file.tree);
+    generator.Generate(&content);
+  } else {
+    LatexGenerator generator(file.file_name, file.content,
+                             *generator_context_, file.tree);
+    generator.Generate(&content);
+  }
 
-    std::ofstream out(GenerateOutputPath(file_name, itr->second, "tex"));
-    out << generator.ShowOutput();
+  if (TracksManifest()) {
+    std::lock_guard<std::mutex> lk(m_manifest_);
+    manifest_.AddDependencies(file.file_name, dependencies);
   }
+
+  return OutputFile{.path = task.output_path, .content = std::move(content)};
 }
 
 void Driver::BuildBookFilesMap() {
@@ -219,18 +725,18 @@ void Driver::GenerateBookMainPage() const {
       std::string tex =
           gen.GenerateMainTex(start_file_number, itr->second, repo_);
 
-      std::ofstream out(GenerateOutputPath("main", path, "tex"));
-      out << tex;
+      OutputWriter::WriteFileIfChanged(GenerateOutputPath("main", path, "tex"),
+                                       tex);
     }
   }
 }
 
 void Driver::GenerateJSONFiles() const {
-  std::ofstream out_path(options_.json_output_dir + "/page_path.json");
-  out_path << repo_.DumpPathAsJson();
-
-  std::ofstream out_header(options_.json_output_dir + "/file_headers.json");
-  out_header << repo_.DumpFileHeaderAsJson();
+  OutputWriter::WriteFileIfChanged(
+      options_.json_output_dir + "/page_path.json", repo_.DumpPathAsJson());
+  OutputWriter::WriteFileIfChanged(
+      options_.json_output_dir + "/file_headers.json",
+      repo_.DumpFileHeaderAsJson());
 }
 
 void Driver::StartClangFormatServer(const std::string& server_location) {
@@ -268,7 +774,14 @@ void Driver::UpdateDatabase() const {
   for (const auto& [file_name, file_info] : file_contents_) {
     auto& [content, read_pos, rel_path] = file_info;
     database.TryUpdateFileToDatabase(
-        std::string(MetadataRepo::NormalizeFileName(file_name)), content);
+        std::string(MetadataRepo::NormalizeFileName(file_name)),
+        std::string(content));
+  }
+}
+
+Driver::Driver(const DriverOptions& options) : options_(options) {
+  if (!options_.parse_tree_cache_dir.empty()) {
+    parse_tree_cache_.emplace(options_.parse_tree_cache_dir);
   }
 }
 
@@ -2,12 +2,22 @@
 #define DRIVER_H
 
 #include <atomic>
+#include <mutex>
+#include <optional>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <zmq.hpp>
 
+#include "arena.h"
+#include "bounded_queue.h"
+#include "build_manifest.h"
+#include "mapped_file.h"
 #include "metadata_repo.h"
+#include "parse_tree.h"
+#include "parse_tree_cache.h"
+#include "thread_pool.h"
 
 namespace md2 {
 
@@ -45,18 +55,46 @@ struct DriverOptions {
 
   // If true, then new schema will be used for the database.
   bool use_new_schema = false;
+
+  // If true, only the files that are changed (or depend on the changed files)
+  // since the last run are regenerated. The state of the last run is stored
+  // at output_dir/.md2_manifest.json
+  bool incremental = false;
+
+  // If true, the driver keeps watching the input files after the first build
+  // and regenerates the outputs of the changed files.
+  bool watch = false;
+
+  // If not empty, the time spent on each stage of each file is written to
+  // this path in the Chrome trace event format.
+  std::string trace_path;
+
+  // Documents that are at least this large are split into the chunks that are
+  // parsed in parallel. 0 disables it.
+  size_t parallel_parse_min_size = 1 << 20;
+
+  // If not empty, the parse trees are cached in this directory (keyed by the
+  // hash of the content), and the content that is parsed before is loaded
+  // from there instead of being parsed again.
+  std::string parse_tree_cache_dir;
 };
 
 class Driver {
  public:
-  // string file content, pos, rel_path
-  using FileInfo = std::tuple<std::string, size_t, std::string>;
+  // file content, pos, rel_path. The file content points into the memory
+  // mapped file that is owned by the driver.
+  using FileInfo = std::tuple<std::string_view, size_t, std::string>;
 
-  Driver(const DriverOptions& options) : options_(options) {}
+  Driver(const DriverOptions& options);
 
   // Run the driver.
   void Run();
 
+  // Watches the input directories and the image directory and rebuilds the
+  // affected files on every change. Must be called after Run(). Never returns
+  // unless the watch fails.
+  void Watch();
+
   ~Driver();
 
  private:
@@ -66,10 +104,57 @@ class Driver {
   // Build the file metadata repository.
   void BuildFileMetadataRepo();
 
-  void DoParse();
+  // Returns the list of files that should be parsed. In the incremental (or
+  // watch) mode, this only returns the files that are out of date with the
+  // prev_manifest. If changed_files is given, the hashes of the files that are
+  // not in it are reused from the prev_manifest.
+  std::vector<std::string> FindFilesToParse(
+      const BuildManifest& prev_manifest,
+      const std::unordered_set<std::string>* changed_files);
+
+  // Parses the files and generates every output that depends on them.
+  void GenerateOutputs(const std::vector<std::string>& files_to_parse);
+
+  // Rebuilds the outputs that are affected by the changed paths.
+  void Rebuild(const std::vector<std::string>& changed_paths);
+
+  // Reads the file again (or removes it if the file is deleted). Returns
+  // false if the file is not an input file.
+  bool ReloadInputFile(const std::string& path);
+
+  // True if the manifest of the current build should be maintained.
+  bool TracksManifest() const { return options_.incremental || options_.watch; }
+
+  std::string GetManifestPath() const;
+
+  // Parses the files and generates the outputs. Parsing, rendering and
+  // writing the outputs are run as separate stages.
+  void DoParse(const std::vector<std::string>& files_to_parse);
 
+  struct ParsedFile;
+  struct RenderTask;
+  struct OutputFile;
+
+  // Parse the file and enqueue the HTML and LaTeX render tasks.
   // Note that file_name is not a full path (e.g 251.md)
-  void DoParse(std::string_view content, std::string_view file_name);
+  // The large file is parsed on the threads of the parse pool.
+  void ParseAndEnqueueRenderTasks(const std::string& file_name,
+                                  BoundedQueue<RenderTask>& queue,
+                                  ThreadPool* parse_pool);
+
+  // Loads the tree from the parse tree cache if it is there. Otherwise parses
+  // the content (and stores the tree to the cache).
+  ParseTree ParseContent(std::string_view content, ThreadPool* parse_pool);
+
+  OutputFile Render(const RenderTask& task);
+
+  // Returns true if the outputs of the file with the given new manifest entry
+  // is not up to date with the previous manifest entry.
+  bool IsOutdated(std::string_view file_name,
+                  const BuildManifest::Entry& prev_entry,
+                  const BuildManifest::Entry& entry) const;
+
+  std::string GetOptionsFingerprint() const;
 
   // Figure out md files that needed to be parsed for book.
   void BuildBookFilesMap();
@@ -86,14 +171,33 @@ class Driver {
   // Update articles to the database.
   void UpdateDatabase() const;
 
+  // Write the trace file and print the slowest files.
+  void WriteTrace() const;
+
   DriverOptions options_;
 
   // Map between file name to the file content and the current reading position.
   std::unordered_map<std::string, FileInfo> file_contents_;
 
+  // Memory mapped input files that back the contents in file_contents_ (they
+  // are copied instead in the watch mode). Keyed by the file name.
+  std::unordered_map<std::string, std::unique_ptr<MappedFile>> mapped_files_;
+
   MetadataRepo repo_;
 
+  // Context that is shared by every generator.
+  std::unique_ptr<GeneratorContext> generator_context_;
+
   std::atomic<int> num_parsed_ = 0;
+  size_t num_to_parse_ = 0;
+
+  // Manifest of the current build. Only used in the incremental or watch mode.
+  BuildManifest manifest_;
+  std::mutex m_manifest_;
+
+  // True if the metadata of any file is changed (or file is added/removed)
+  // since the last run.
+  bool metadata_changed_ = true;
 
   // Map between the file name to the book directory.
   std::unordered_map<std::string, std::string> book_dir_to_files_;
@@ -105,6 +209,13 @@ class Driver {
   bool clang_format_server_spanwed_ = false;
   int clang_format_pid_ = 0;
   std::unique_ptr<zmq::context_t> zmq_context_;
+
+  // Arenas of the parse trees. The arena of a document is returned to the pool
+  // once every render task of the document is done.
+  ArenaPool arena_pool_;
+
+  // Set if DriverOptions::parse_tree_cache_dir is given.
+  std::optional<ParseTreeCache> parse_tree_cache_;
 };
 
 }  // namespace md2
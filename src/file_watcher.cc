@@ -0,0 +1,145 @@
+#include "file_watcher.h"
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <unordered_set>
+
+#include "logger.h"
+#include "string_util.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF;
+
+}  // namespace
+
+FileWatcher::FileWatcher() : inotify_fd_(inotify_init1(IN_CLOEXEC)) {
+  if (inotify_fd_ < 0) {
+    LOG(0) << "Unable to initialize inotify.";
+  }
+}
+
+FileWatcher::~FileWatcher() {
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+}
+
+bool FileWatcher::AddDirectory(const std::string& dir) {
+  if (inotify_fd_ < 0) {
+    return false;
+  }
+
+  int wd = inotify_add_watch(inotify_fd_, dir.c_str(), kWatchMask);
+  if (wd < 0) {
+    LOG(0) << "Unable to watch " << dir;
+    return false;
+  }
+  watched_dirs_[wd] = dir;
+
+  // inotify is not recursive.
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator(dir, ec)) {
+    if (entry.is_directory(ec)) {
+      AddDirectory(entry.path());
+    }
+  }
+
+  return true;
+}
+
+std::vector<std::string> FileWatcher::WaitForChanges(int debounce_ms) {
+  std::vector<std::string> changed_files;
+  if (inotify_fd_ < 0) {
+    return changed_files;
+  }
+
+  pollfd pfd = {.fd = inotify_fd_, .events = POLLIN, .revents = 0};
+
+  // Block until the first event.
+  while (changed_files.empty()) {
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR) {
+      return {};
+    }
+
+    if (!ReadEvents(&changed_files)) {
+      return {};
+    }
+  }
+
+  // Then collect until it is quiet.
+  while (true) {
+    int ret = poll(&pfd, 1, debounce_ms);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (ret <= 0 || !ReadEvents(&changed_files)) {
+      break;
+    }
+  }
+
+  // Remove the duplicates.
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> unique_files;
+  for (auto& file : changed_files) {
+    if (seen.insert(file).second) {
+      unique_files.push_back(std::move(file));
+    }
+  }
+
+  return unique_files;
+}
+
+bool FileWatcher::ReadEvents(std::vector<std::string>* changed_files) {
+  alignas(inotify_event) char buf[4096];
+  ssize_t len = read(inotify_fd_, buf, sizeof(buf));
+  if (len < 0) {
+    return errno == EINTR;
+  }
+
+  for (char* ptr = buf; ptr < buf + len;) {
+    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+    ptr += sizeof(inotify_event) + event->len;
+
+    auto itr = watched_dirs_.find(event->wd);
+    if (itr == watched_dirs_.end()) {
+      continue;
+    }
+
+    if (event->mask & (IN_IGNORED | IN_DELETE_SELF)) {
+      watched_dirs_.erase(itr);
+      continue;
+    }
+
+    if (event->len == 0) {
+      continue;
+    }
+
+    std::string path = StrCat(itr->second, "/", event->name);
+
+    // Newly created directories should be watched as well.
+    if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+      AddDirectory(path);
+      continue;
+    }
+
+    if (event->mask & IN_ISDIR) {
+      continue;
+    }
+
+    changed_files->push_back(std::move(path));
+  }
+
+  return true;
+}
+
+}  // namespace md2
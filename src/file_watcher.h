@@ -0,0 +1,42 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace md2 {
+
+// Watches the changes of the files under the directories (recursively) using
+// inotify.
+class FileWatcher {
+ public:
+  FileWatcher();
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+
+  // Returns false if the directory cannot be watched.
+  bool AddDirectory(const std::string& dir);
+
+  // Blocks until some file is created, modified, moved or deleted and returns
+  // the paths of the changed files. Once the first event arrives, it keeps
+  // collecting the events until nothing happens for debounce_ms (editors
+  // usually touch a file several times on save). Each changed path is
+  // reported once. Returns an empty list on error.
+  std::vector<std::string> WaitForChanges(int debounce_ms);
+
+ private:
+  // Reads the pending events. Returns false on error.
+  bool ReadEvents(std::vector<std::string>* changed_files);
+
+  int inotify_fd_;
+
+  // Map between the watch descriptor and the watched directory.
+  std::unordered_map<int, std::string> watched_dirs_;
+};
+
+}  // namespace md2
+
+#endif
@@ -0,0 +1,641 @@
+#include "flat_parse_tree.h"
+
+#include <cstring>
+#include <optional>
+
+#include "parse_tree_nodes/box.h"
+#include "parse_tree_nodes/command.h"
+#include "parse_tree_nodes/escape.h"
+#include "parse_tree_nodes/header.h"
+#include "parse_tree_nodes/image.h"
+#include "parse_tree_nodes/link.h"
+#include "parse_tree_nodes/list.h"
+#include "parse_tree_nodes/paragraph.h"
+#include "parse_tree_nodes/quote.h"
+#include "parse_tree_nodes/table.h"
+#include "parse_tree_nodes/text_decoration.h"
+#include "parse_tree_nodes/verbatim.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+// Binary format of the tree. Every integer is in the native byte order (the
+// magic does not match on the machine of the other byte order).
+//
+//   Header
+//   NodeRecord     * num_nodes
+//   NodeDataRecord * num_node_data
+//   RefRecord      * num_refs
+//   SyncPoint      * num_sync_points
+//   Names of the commands and the references (strings_size bytes)
+constexpr char kMagic[4] = {'M', 'D', '2', 'T'};
+
+struct Header {
+  char magic[4] = {};
+  uint32_t version;
+  uint32_t num_nodes;
+  uint32_t num_node_data;
+  uint32_t num_refs;
+  uint32_t num_sync_points;
+  uint32_t strings_size = 0;
+};
+
+struct NodeRecord {
+  int32_t start;
+  int32_t end;
+  int32_t first_child;
+  int32_t next_sibling;
+  int32_t data;
+  uint32_t type;
+};
+
+// Strings are (offset, size) in the strings section.
+struct NodeDataRecord {
+  int32_t list_depth;
+  int32_t list_index;
+  int32_t col_size;
+  uint32_t command_name_offset;
+  uint32_t command_name_size;
+  int32_t keyword_index[FlatParseTree::kImageKeywords.size()] = {};
+};
+
+struct RefRecord {
+  uint32_t name_offset;
+  uint32_t name_size;
+  int32_t node;
+};
+
+template <typename Record>
+void AppendRecord(const Record& record, std::string* data) {
+  data->append(reinterpret_cast<const char*>(&record), sizeof(Record));
+}
+
+// Reads the record at the offset and advances it. Returns false if the data is
+// too short.
+template <typename Record>
+bool ReadRecord(std::string_view data, size_t* offset, Record* record) {
+  if (data.size() - *offset < sizeof(Record)) {
+    return false;
+  }
+
+  std::memcpy(record, data.data() + *offset, sizeof(Record));
+  *offset += sizeof(Record);
+  return true;
+}
+
+// Sections of the serialized tree. The records are read from the data (e.g the
+// memory mapped file) one at a time, without copying the sections first.
+struct Sections {
+  Header header;
+  std::string_view nodes;
+  std::string_view node_data;
+  std::string_view refs;
+  std::string_view sync_points;
+  std::string_view strings;
+};
+
+// Returns the index-th record of the section.
+template <typename Record>
+Record GetRecord(std::string_view section, size_t index) {
+  Record record;
+  std::memcpy(&record, section.data() + index * sizeof(Record),
+              sizeof(Record));
+  return record;
+}
+
+// Returns nullopt if the string is out of the strings section.
+std::optional<std::string_view> GetString(const Sections& sections,
+                                          uint32_t offset, uint32_t size) {
+  const std::string_view strings = sections.strings;
+  if (offset > strings.size() || size > strings.size() - offset) {
+    return std::nullopt;
+  }
+  return strings.substr(offset, size);
+}
+
+// Returns nullopt if the header is invalid or the sections do not add up to
+// the size of the data.
+std::optional<Sections> GetSections(std::string_view data) {
+  Sections sections;
+  size_t offset = 0;
+  Header& header = sections.header;
+  if (!ReadRecord(data, &offset, &header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != FlatParseTree::kBinaryVersion) {
+    return std::nullopt;
+  }
+
+  // Every section must fit in the data before anything is read.
+  const uint64_t expected_size =
+      sizeof(Header) + uint64_t{header.num_nodes} * sizeof(NodeRecord) +
+      uint64_t{header.num_node_data} * sizeof(NodeDataRecord) +
+      uint64_t{header.num_refs} * sizeof(RefRecord) +
+      uint64_t{header.num_sync_points} * sizeof(SyncPoint) +
+      header.strings_size;
+  if (expected_size != data.size() || header.num_nodes == 0) {
+    return std::nullopt;
+  }
+
+  auto next_section = [&data, &offset](size_t size) {
+    const std::string_view section = data.substr(offset, size);
+    offset += size;
+    return section;
+  };
+  sections.nodes = next_section(header.num_nodes * sizeof(NodeRecord));
+  sections.node_data =
+      next_section(header.num_node_data * sizeof(NodeDataRecord));
+  sections.refs = next_section(header.num_refs * sizeof(RefRecord));
+  sections.sync_points =
+      next_section(header.num_sync_points * sizeof(SyncPoint));
+  sections.strings = next_section(header.strings_size);
+  return sections;
+}
+
+// Index of the node that must come after the current one in the pre-order
+// (or kNoNode).
+bool IsValidLaterNode(int index, int current, size_t num_nodes) {
+  return index == FlatParseTree::kNoNode ||
+         (current < index && static_cast<size_t>(index) < num_nodes);
+}
+
+// Returns nullopt if the node is corrupted.
+std::optional<FlatParseTree::Node> ReadNode(const Sections& sections,
+                                            size_t index) {
+  const auto record = GetRecord<NodeRecord>(sections.nodes, index);
+  const size_t num_nodes = sections.header.num_nodes;
+  const int current = index;
+  if (record.type > ParseTreeNode::QUOTE ||
+      !IsValidLaterNode(record.first_child, current, num_nodes) ||
+      !IsValidLaterNode(record.next_sibling, current, num_nodes) ||
+      (index == 0 && record.next_sibling != FlatParseTree::kNoNode) ||
+      (record.data != FlatParseTree::kNoNode &&
+       (record.data < 0 || static_cast<uint32_t>(record.data) >=
+                               sections.header.num_node_data))) {
+    return std::nullopt;
+  }
+
+  return FlatParseTree::Node{
+      .start = record.start,
+      .end = record.end,
+      .first_child = record.first_child,
+      .next_sibling = record.next_sibling,
+      .data = record.data,
+      .type = static_cast<ParseTreeNode::NodeType>(record.type)};
+}
+
+// Returns nullopt if the data is corrupted.
+std::optional<FlatParseTree::NodeData> ReadNodeData(const Sections& sections,
+                                                    size_t index) {
+  const auto record = GetRecord<NodeDataRecord>(sections.node_data, index);
+
+  FlatParseTree::NodeData node_data;
+  node_data.list_depth = record.list_depth;
+  node_data.list_index = record.list_index;
+  node_data.col_size = record.col_size;
+  for (size_t i = 0; i < node_data.keyword_index.size(); i++) {
+    if (record.keyword_index[i] < FlatParseTree::kNoNode) {
+      return std::nullopt;
+    }
+    node_data.keyword_index[i] = record.keyword_index[i];
+  }
+
+  // The command name must point to the static command table.
+  const std::optional<std::string_view> command_name = GetString(
+      sections, record.command_name_offset, record.command_name_size);
+  if (!command_name) {
+    return std::nullopt;
+  }
+  if (!command_name->empty()) {
+    node_data.command_name = Parser::FindCommandName(*command_name);
+    if (node_data.command_name.empty()) {
+      return std::nullopt;
+    }
+  }
+  return node_data;
+}
+
+// Returns the map between the reference name and the index of the node.
+std::optional<std::unordered_map<std::string, int>> ReadRefs(
+    const Sections& sections) {
+  std::unordered_map<std::string, int> refs;
+  for (size_t i = 0; i < sections.header.num_refs; i++) {
+    const auto record = GetRecord<RefRecord>(sections.refs, i);
+
+    const std::optional<std::string_view> name =
+        GetString(sections, record.name_offset, record.name_size);
+    if (!name || record.node < 0 ||
+        static_cast<size_t>(record.node) >= sections.header.num_nodes) {
+      return std::nullopt;
+    }
+    refs[std::string(*name)] = record.node;
+  }
+  return refs;
+}
+
+std::optional<std::vector<SyncPoint>> ReadSyncPoints(
+    const Sections& sections) {
+  // ApplyEdit relies on the sync points being sorted, starting from the
+  // beginning of the content.
+  std::vector<SyncPoint> sync_points(sections.header.num_sync_points);
+  for (size_t i = 0; i < sync_points.size(); i++) {
+    sync_points[i] = GetRecord<SyncPoint>(sections.sync_points, i);
+
+    const SyncPoint& sync_point = sync_points[i];
+    const bool is_valid =
+        i == 0 ? sync_point.position == 0 && sync_point.read_end >= 0
+               : sync_point.position > sync_points[i - 1].position &&
+                     sync_point.read_end >= sync_points[i - 1].read_end;
+    if (!is_valid) {
+      return std::nullopt;
+    }
+  }
+  return sync_points;
+}
+
+// Creates the (empty) node of the given type.
+ParseTreeNode* CreateNode(Arena* arena, const FlatParseTree::Node& node,
+                          ParseTreeNode* parent) {
+  switch (node.type) {
+    case ParseTreeNode::NODE:
+      return ParseTreeNode::Create<ParseTreeNode>(arena, parent, node.start);
+    case ParseTreeNode::PARAGRAPH:
+      return ParseTreeNode::Create<ParseTreeParagraphNode>(arena, parent,
+                                                           node.start);
+    case ParseTreeNode::TEXT:
+      return ParseTreeNode::Create<ParseTreeTextNode>(arena, parent,
+                                                      node.start);
+    case ParseTreeNode::VERBATIM:
+      return ParseTreeNode::Create<ParseTreeVerbatimNode>(arena, parent,
+                                                          node.start);
+    case ParseTreeNode::BOLD:
+      return ParseTreeNode::Create<ParseTreeBoldNode>(arena, parent,
+                                                      node.start);
+    case ParseTreeNode::ITALIC:
+      return ParseTreeNode::Create<ParseTreeItalicNode>(arena, parent,
+                                                        node.start);
+    case ParseTreeNode::ESCAPE:
+      return ParseTreeNode::Create<ParseTreeEscapeNode>(arena, parent,
+                                                        node.start);
+    case ParseTreeNode::LINK:
+      return ParseTreeNode::Create<ParseTreeLinkNode>(arena, parent,
+                                                      node.start);
+    case ParseTreeNode::IMAGE:
+      return ParseTreeNode::Create<ParseTreeImageNode>(arena, parent,
+                                                       node.start);
+    case ParseTreeNode::HEADER:
+      return ParseTreeNode::Create<ParseTreeHeaderNode>(arena, parent,
+                                                        node.start);
+    case ParseTreeNode::BOX:
+      return ParseTreeNode::Create<ParseTreeBoxNode>(arena, parent,
+                                                     node.start);
+    case ParseTreeNode::TABLE:
+      return ParseTreeNode::Create<ParseTreeTableNode>(arena, parent,
+                                                       node.start);
+    case ParseTreeNode::LIST:
+    case ParseTreeNode::ORDERED_LIST:
+      return ParseTreeNode::Create<ParseTreeListNode>(
+          arena, parent, node.start,
+          /*is_ordered=*/node.type == ParseTreeNode::ORDERED_LIST);
+    case ParseTreeNode::LIST_ITEM:
+    case ParseTreeNode::ORDERED_LIST_ITEM:
+      return ParseTreeNode::Create<ParseTreeListItemNode>(
+          arena, parent, node.start,
+          /*is_ordered=*/node.type == ParseTreeNode::ORDERED_LIST_ITEM);
+    case ParseTreeNode::COMMAND:
+      return ParseTreeNode::Create<ParseTreeCommandNode>(arena, parent,
+                                                         node.start);
+    case ParseTreeNode::STRIKE_THROUGH:
+      return ParseTreeNode::Create<ParseTreeStrikeThroughNode>(arena, parent,
+                                                               node.start);
+    case ParseTreeNode::MATH:
+      return ParseTreeNode::Create<ParseTreeMathNode>(arena, parent,
+                                                      node.start);
+    case ParseTreeNode::MATH_NEWLINE:
+      return ParseTreeNode::Create<ParseTreeNewlineMathNode>(arena, parent,
+                                                             node.start);
+    case ParseTreeNode::QUOTE:
+      return ParseTreeNode::Create<ParseTreeQuoteNode>(arena, parent,
+                                                       node.start);
+  }
+
+  MD2_ASSERT(false, "Unknown node type");
+  return nullptr;
+}
+
+// Copies the node type specific data to the node.
+void SetNodeData(const FlatParseTree::NodeData& data, ParseTreeNode* node) {
+  switch (node->GetNodeType()) {
+    case ParseTreeNode::LIST_ITEM:
+    case ParseTreeNode::ORDERED_LIST_ITEM: {
+      auto* list_item = static_cast<ParseTreeListItemNode*>(node);
+      list_item->SetListDepth(data.list_depth);
+      list_item->SetListIndex(data.list_index);
+      break;
+    }
+    case ParseTreeNode::TABLE:
+      static_cast<ParseTreeTableNode*>(node)->SetColSize(data.col_size);
+      break;
+    case ParseTreeNode::COMMAND:
+      static_cast<ParseTreeCommandNode*>(node)->SetCommandName(
+          data.command_name);
+      break;
+    case ParseTreeNode::IMAGE:
+      for (size_t i = 0; i < FlatParseTree::kImageKeywords.size(); i++) {
+        if (data.keyword_index[i] != FlatParseTree::kNoNode) {
+          static_cast<ParseTreeImageNode*>(node)->AddKeywordIndex(
+              FlatParseTree::kImageKeywords[i], data.keyword_index[i]);
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Builds the pointer based tree from the nodes in the pre-order, where
+// get_node(index) and get_node_data(data) return the node and its data.
+template <typename GetNode, typename GetNodeData>
+ParseTree BuildParseTree(
+    size_t num_nodes, GetNode&& get_node, GetNodeData&& get_node_data,
+    const std::unordered_map<std::string, int>& ref_indexes,
+    std::vector<SyncPoint> sync_points, std::unique_ptr<Arena> arena) {
+  std::vector<ParseTreeNode*> created(num_nodes, nullptr);
+
+  // Since the nodes are in the pre-order, the parent (or the previous
+  // sibling) is always visited before the node.
+  std::vector<int> parent_index(num_nodes, FlatParseTree::kNoNode);
+  for (size_t index = 0; index < num_nodes; index++) {
+    const FlatParseTree::Node node = get_node(index);
+
+    ParseTreeNode* parent = parent_index[index] == FlatParseTree::kNoNode
+                                ? nullptr
+                                : created[parent_index[index]];
+    ParseTreeNode* created_node = CreateNode(arena.get(), node, parent);
+    created_node->SetEnd(node.end);
+    if (node.data != FlatParseTree::kNoNode) {
+      SetNodeData(get_node_data(node.data), created_node);
+    }
+
+    if (parent != nullptr) {
+      parent->AddChildren(created_node);
+    }
+
+    if (node.first_child != FlatParseTree::kNoNode) {
+      parent_index[node.first_child] = index;
+    }
+    if (node.next_sibling != FlatParseTree::kNoNode) {
+      parent_index[node.next_sibling] = parent_index[index];
+    }
+    created[index] = created_node;
+  }
+
+  std::unordered_map<std::string, ParseTreeNode*> refs;
+  for (const auto& [name, index] : ref_indexes) {
+    refs[name] = created[index];
+  }
+
+  ParseTreeNode* root = created.empty() ? nullptr : created[0];
+  return ParseTree(std::move(arena), root, std::move(refs),
+                   std::move(sync_points));
+}
+
+}  // namespace
+
+FlatParseTree::FlatParseTree(const ParseTree& tree) {
+  RefNames ref_names;
+  for (const auto& [name, node] : tree.GetReferences()) {
+    ref_names[node] = name;
+  }
+
+  AddNode(*tree.GetRoot(), ref_names);
+  sync_points_ = tree.GetSyncPoints();
+
+  nodes_.shrink_to_fit();
+  node_data_.shrink_to_fit();
+}
+
+int FlatParseTree::AddNode(const ParseTreeNode& node,
+                           const RefNames& ref_names) {
+  const int index = nodes_.size();
+  nodes_.push_back(Node{
+      .start = node.Start(), .end = node.End(), .type = node.GetNodeType()});
+
+  std::optional<NodeData> data;
+  switch (node.GetNodeType()) {
+    case ParseTreeNode::LIST_ITEM:
+    case ParseTreeNode::ORDERED_LIST_ITEM: {
+      const auto& list_item = static_cast<const ParseTreeListItemNode&>(node);
+      data = NodeData();
+      data->list_depth = list_item.GetListDepth();
+      data->list_index = list_item.ListIndex();
+      break;
+    }
+    case ParseTreeNode::TABLE: {
+      const auto& table = static_cast<const ParseTreeTableNode&>(node);
+      data = NodeData();
+      data->col_size = table.GetColSize();
+      break;
+    }
+    case ParseTreeNode::COMMAND: {
+      const auto& command = static_cast<const ParseTreeCommandNode&>(node);
+      data = NodeData();
+      data->command_name = command.GetCommandName();
+      break;
+    }
+    case ParseTreeNode::IMAGE: {
+      const auto& image = static_cast<const ParseTreeImageNode&>(node);
+      data = NodeData();
+      for (size_t i = 0; i < kImageKeywords.size(); i++) {
+        data->keyword_index[i] =
+            image.GetKeywordIndex(kImageKeywords[i]).value_or(kNoNode);
+      }
+      break;
+    }
+    case ParseTreeNode::BOX:
+      if (auto itr = ref_names.find(&node); itr != ref_names.end()) {
+        refs_[std::string(itr->second)] = index;
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (data) {
+    nodes_[index].data = node_data_.size();
+    node_data_.push_back(*data);
+  }
+
+  int prev_child = kNoNode;
+  for (const ParseTreeNode* child : node.GetChildren()) {
+    const int child_index = AddNode(*child, ref_names);
+    if (prev_child == kNoNode) {
+      nodes_[index].first_child = child_index;
+    } else {
+      nodes_[prev_child].next_sibling = child_index;
+    }
+    prev_child = child_index;
+  }
+
+  return index;
+}
+
+int FlatParseTree::FindReferenceNode(std::string_view name) const {
+  if (auto itr = refs_.find(std::string(name)); itr != refs_.end()) {
+    return itr->second;
+  }
+
+  return kNoNode;
+}
+
+ParseTree FlatParseTree::ToParseTree(std::unique_ptr<Arena> arena) const {
+  return BuildParseTree(
+      nodes_.size(), [this](int index) { return nodes_[index]; },
+      [this](int data) { return node_data_[data]; }, refs_, sync_points_,
+      std::move(arena));
+}
+
+size_t FlatParseTree::MemoryUsage() const {
+  return nodes_.capacity() * sizeof(Node) +
+         node_data_.capacity() * sizeof(NodeData);
+}
+
+std::string FlatParseTree::Serialize() const {
+  std::string strings;
+  auto add_string = [&strings](std::string_view s) {
+    const uint32_t offset = strings.size();
+    strings.append(s);
+    return offset;
+  };
+
+  std::string data;
+  data.reserve(sizeof(Header) + nodes_.size() * sizeof(NodeRecord) +
+               node_data_.size() * sizeof(NodeDataRecord));
+
+  Header header = {.version = kBinaryVersion,
+                   .num_nodes = static_cast<uint32_t>(nodes_.size()),
+                   .num_node_data = static_cast<uint32_t>(node_data_.size()),
+                   .num_refs = static_cast<uint32_t>(refs_.size()),
+                   .num_sync_points =
+                       static_cast<uint32_t>(sync_points_.size())};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+
+  // The header is written last since the size of the strings is not known
+  // yet.
+  data.resize(sizeof(Header));
+
+  for (const Node& node : nodes_) {
+    AppendRecord(NodeRecord{.start = node.start,
+                            .end = node.end,
+                            .first_child = node.first_child,
+                            .next_sibling = node.next_sibling,
+                            .data = node.data,
+                            .type = node.type},
+                 &data);
+  }
+
+  for (const NodeData& node_data : node_data_) {
+    NodeDataRecord record = {
+        .list_depth = node_data.list_depth,
+        .list_index = node_data.list_index,
+        .col_size = node_data.col_size,
+        .command_name_offset = add_string(node_data.command_name),
+        .command_name_size =
+            static_cast<uint32_t>(node_data.command_name.size())};
+    std::copy(node_data.keyword_index.begin(), node_data.keyword_index.end(),
+              record.keyword_index);
+    AppendRecord(record, &data);
+  }
+
+  for (const auto& [name, index] : refs_) {
+    AppendRecord(RefRecord{.name_offset = add_string(name),
+                           .name_size = static_cast<uint32_t>(name.size()),
+                           .node = index},
+                 &data);
+  }
+
+  for (const SyncPoint& sync_point : sync_points_) {
+    AppendRecord(sync_point, &data);
+  }
+
+  header.strings_size = strings.size();
+  std::memcpy(data.data(), &header, sizeof(Header));
+  data.append(strings);
+
+  return data;
+}
+
+std::optional<FlatParseTree> FlatParseTree::Deserialize(
+    std::string_view data) {
+  const std::optional<Sections> sections = GetSections(data);
+  if (!sections) {
+    return std::nullopt;
+  }
+
+  FlatParseTree tree;
+  tree.nodes_.reserve(sections->header.num_nodes);
+  for (size_t i = 0; i < sections->header.num_nodes; i++) {
+    std::optional<Node> node = ReadNode(*sections, i);
+    if (!node) {
+      return std::nullopt;
+    }
+    tree.nodes_.push_back(*node);
+  }
+
+  tree.node_data_.reserve(sections->header.num_node_data);
+  for (size_t i = 0; i < sections->header.num_node_data; i++) {
+    std::optional<NodeData> node_data = ReadNodeData(*sections, i);
+    if (!node_data) {
+      return std::nullopt;
+    }
+    tree.node_data_.push_back(*node_data);
+  }
+
+  std::optional<std::unordered_map<std::string, int>> refs =
+      ReadRefs(*sections);
+  std::optional<std::vector<SyncPoint>> sync_points =
+      ReadSyncPoints(*sections);
+  if (!refs || !sync_points) {
+    return std::nullopt;
+  }
+  tree.refs_ = std::move(*refs);
+  tree.sync_points_ = std::move(*sync_points);
+
+  return tree;
+}
+
+std::optional<ParseTree> FlatParseTree::DeserializeParseTree(
+    std::string_view data, std::unique_ptr<Arena>* arena) {
+  const std::optional<Sections> sections = GetSections(data);
+  if (!sections) {
+    return std::nullopt;
+  }
+
+  // Everything is checked before the first node is created, so that the
+  // arena is left untouched if the data is corrupted.
+  for (size_t i = 0; i < sections->header.num_nodes; i++) {
+    if (!ReadNode(*sections, i)) {
+      return std::nullopt;
+    }
+  }
+  for (size_t i = 0; i < sections->header.num_node_data; i++) {
+    if (!ReadNodeData(*sections, i)) {
+      return std::nullopt;
+    }
+  }
+  std::optional<std::unordered_map<std::string, int>> refs =
+      ReadRefs(*sections);
+  std::optional<std::vector<SyncPoint>> sync_points =
+      ReadSyncPoints(*sections);
+  if (!refs || !sync_points) {
+    return std::nullopt;
+  }
+
+  return BuildParseTree(
+      sections->header.num_nodes,
+      [&sections](int index) { return *ReadNode(*sections, index); },
+      [&sections](int data) { return *ReadNodeData(*sections, data); },
+      *refs, std::move(*sync_points), std::move(*arena));
+}
+
+}  // namespace md2
@@ -0,0 +1,143 @@
+#ifndef FLAT_PARSE_TREE_H
+#define FLAT_PARSE_TREE_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+#include "parse_tree.h"
+#include "parse_tree_nodes/node.h"
+
+namespace md2 {
+
+// Compact representation of the parse tree. Nodes are stored contiguously in
+// the DFS pre-order (so the root is always at 0 and the subtree of a node is
+// the range right after the node) and refer to each other by the index
+// instead of the pointer.
+//
+// The data that only a few types of the nodes have (e.g the depth of the list
+// item or the name of the command) lives in a separate side table, so that
+// every node record is of the same small size.
+//
+// It is the storage and serialization layout of the tree (see ParseTreeCache)
+// only. The generators do not walk it; They render from the pointer based tree
+// that ToParseTree() rebuilds, so the rendering does not get faster from the
+// flat layout.
+class FlatParseTree {
+ public:
+  static constexpr int kNoNode = -1;
+
+  // Version of the binary format. Must be bumped whenever the format or the
+  // tree that the parser builds changes, so that the stale trees (e.g in
+  // ParseTreeCache) are not used.
+  static constexpr uint32_t kBinaryVersion = 1;
+
+  struct Node {
+    int start;
+    int end;
+
+    int first_child = kNoNode;
+    int next_sibling = kNoNode;
+
+    // Index to the side table. kNoNode if the node has no extra data.
+    int data = kNoNode;
+
+    ParseTreeNode::NodeType type;
+  };
+
+  // Keywords of the image description.
+  static constexpr std::array<std::string_view, 3> kImageKeywords = {
+      "alt", "caption", "size"};
+
+  // Node type specific data.
+  struct NodeData {
+    // LIST_ITEM and ORDERED_LIST_ITEM.
+    int list_depth = 0;
+    int list_index = 0;
+
+    // TABLE.
+    int col_size = 0;
+
+    // COMMAND. Points to the static command table in the parser.
+    std::string_view command_name;
+
+    // IMAGE. Index of the node of each kImageKeywords in the image
+    // description (kNoNode if the keyword is not specified).
+    std::array<int, kImageKeywords.size()> keyword_index = {kNoNode, kNoNode,
+                                                            kNoNode};
+  };
+
+  FlatParseTree() = default;
+  explicit FlatParseTree(const ParseTree& tree);
+
+  const Node& GetNode(int index) const { return nodes_[index]; }
+  const NodeData& GetNodeData(const Node& node) const {
+    return node_data_[node.data];
+  }
+
+  // Number of nodes in the tree (including the root).
+  size_t Size() const { return nodes_.size(); }
+  bool Empty() const { return nodes_.empty(); }
+
+  // Calls fn(child_index) for every child of the node in order.
+  template <typename Fn>
+  void ForEachChild(int index, Fn&& fn) const {
+    for (int child = nodes_[index].first_child; child != kNoNode;
+         child = nodes_[child].next_sibling) {
+      fn(child);
+    }
+  }
+
+  // Returns kNoNode if not found.
+  int FindReferenceNode(std::string_view name) const;
+
+  // Rebuilds the pointer based parse tree (which the generators work on) in
+  // the given arena. Nodes are created in the pre-order so the tree is laid
+  // out sequentially in the arena.
+  ParseTree ToParseTree(std::unique_ptr<Arena> arena) const;
+
+  // Bytes that are used by the node records and the side table.
+  size_t MemoryUsage() const;
+
+  // Serializes the tree (including the references and the sync points) to the
+  // binary format. The format is made of fixed size records, so loading it is
+  // mostly copying.
+  std::string Serialize() const;
+
+  // Loads the tree that is serialized by Serialize(). Returns nullopt if the
+  // data is corrupted or of the other version.
+  static std::optional<FlatParseTree> Deserialize(std::string_view data);
+
+  // Same as Deserialize(data)->ToParseTree(arena), but the nodes are created
+  // straight from the records in the data (e.g the memory mapped file) without
+  // the intermediate FlatParseTree. The arena is taken only if the tree is
+  // loaded.
+  static std::optional<ParseTree> DeserializeParseTree(
+      std::string_view data, std::unique_ptr<Arena>* arena);
+
+ private:
+  // Map between the referenced node and its reference name.
+  using RefNames = std::unordered_map<const ParseTreeNode*, std::string_view>;
+
+  // Adds the node and its subtree. Returns the index of the node.
+  int AddNode(const ParseTreeNode& node, const RefNames& ref_names);
+
+  std::vector<Node> nodes_;
+  std::vector<NodeData> node_data_;
+
+  // Map between the reference name and the index of the node.
+  std::unordered_map<std::string, int> refs_;
+
+  // Sync points of the tree (see ParseTree::ApplyEdit).
+  std::vector<SyncPoint> sync_points_;
+};
+
+}  // namespace md2
+
+#endif
@@ -1,21 +1,18 @@
 #include "asm_syntax_highlighter.h"
 
-#include <unordered_set>
-
-#include "container_util.h"
 #include "logger.h"
+#include "static_set.h"
 #include "string_util.h"
 
 namespace md2 {
 namespace {
 
-std::unordered_set<std::string_view> kIntelAsmKeywords = {"section", "dd",
-                                                          "dw"};
-std::unordered_set<std::string_view> kRegisterNames = {
+constexpr auto kIntelAsmKeywords = MakeStaticStringSet({"section", "dd", "dw"});
+constexpr auto kRegisterNames = MakeStaticStringSet({
     "rax", "eax", "ah",  "al",  "rcx", "ecx", "cx",  "ch", "cl",  "rdx", "edx",
     "dx",  "dh",  "dl",  "rbx", "ebx", "bx",  "bh",  "bl", "rsp", "esp", "sp",
     "spl", "rbp", "ebp", "bp",  "bpl", "rsi", "esi", "si", "sil", "rdi", "edi",
-    "di",  "dil", "ss",  "cs",  "ds",  "es",  "fs",  "gs", "eip", "rip"};
+    "di",  "dil", "ss",  "cs",  "ds",  "es",  "fs",  "gs", "eip", "rip"});
 
 bool IsWhiteSpace(char c) {
   if (c == '\t' || c == ' ' || c == '\n') {
@@ -105,9 +102,9 @@ bool IsRegisterName(std::string_view token) {
     return false;
   }
 
-  if (token[0] == '%' && SetContains(kRegisterNames, token.substr(1))) {
+  if (token[0] == '%' && kRegisterNames.Contains(token.substr(1))) {
     return true;
-  } else if (SetContains(kRegisterNames, token)) {
+  } else if (kRegisterNames.Contains(token)) {
     return true;
   }
 
@@ -1,8 +1,6 @@
 #include "cpp_syntax_highlighter.h"
 
-#include <unordered_set>
-
-#include "container_util.h"
+#include "static_set.h"
 #include "string_util.h"
 
 namespace md2 {
@@ -10,7 +8,7 @@ namespace {
 
 char kWhiteSpaces[] = " \t\n";
 
-std::unordered_set<std::string_view> kCppKeywords = {
+constexpr auto kCppKeywords = MakeStaticStringSet({
     /* C++ specific */
     "class", "catch", "const_cast", "delete", "dynamic_cast", "explicit",
     "export", "friend", "mutable", "namespace", "new", "operator", "private",
@@ -22,17 +20,17 @@ std::unordered_set<std::string_view> kCppKeywords = {
     "asm", "auto", "break", "case", "const", "continue", "default", "do",
     "else", "enum", "extern", "for", "goto", "if", "register", "restricted",
     "return", "sizeof", "static", "struct", "switch", "typedef", "union",
-    "volatile", "while"};
+    "volatile", "while"});
 
-std::unordered_set<std::string_view> kCppTypeKeywords = {
+constexpr auto kCppTypeKeywords = MakeStaticStringSet({
     "bool",   "int",  "long", "float", "short", "double", "char",    "unsigned",
-    "signed", "void", "int8", "int16", "int32", "int64",  "wchar_t", "string"};
+    "signed", "void", "int8", "int16", "int32", "int64",  "wchar_t", "string"});
 
-std::unordered_set<std::string_view> kMacroWithOneExpression = {
-    "#if", "#ifdef", "#ifndef", "#elif"};
+constexpr auto kMacroWithOneExpression =
+    MakeStaticStringSet({"#if", "#ifdef", "#ifndef", "#elif"});
 
-std::unordered_set<std::string_view> kMacroWithNoExpression = {"#else",
-                                                               "#endif"};
+constexpr auto kMacroWithNoExpression =
+    MakeStaticStringSet({"#else", "#endif"});
 
 // Check whether the character is allowed in the identifier.
 bool IsIdenfierAllowedChar(char c) {
@@ -299,7 +297,7 @@ size_t CppSyntaxHighlighter::HandleMacro(size_t macro_start) {
   // Check the macro token.
   std::string_view macro =
       code_.substr(macro_start, header_token_end - macro_start);
-  if (SetContains(kMacroWithNoExpression, macro)) {
+  if (kMacroWithNoExpression.Contains(macro)) {
     return delimiter_pos;
   }
 
@@ -337,9 +335,9 @@ void CppSyntaxHighlighter::AppendCurrentToken(SyntaxTokenType current_token,
   if (current_token == IDENTIFIER) {
     // Check whether it matches one of our keyword set.
     std::string_view token = code_.substr(token_start, token_end - token_start);
-    if (SetContains(kCppTypeKeywords, token)) {
+    if (kCppTypeKeywords.Contains(token)) {
       current_token = TYPE_KEYWORD;
-    } else if (SetContains(kCppKeywords, token)) {
+    } else if (kCppKeywords.Contains(token)) {
       current_token = KEYWORD;
     } else if (IsNumericLiteral(token)) {
       current_token = NUMERIC_LITERAL;
@@ -5,48 +5,60 @@
 #include "logger.h"
 
 namespace md2 {
-namespace {
-
-ParseTreeNode* GetNext(const ParseTreeNode* node, int pos) {
-  for (auto& child : node->GetChildren()) {
-    if (pos <= child->Start()) {
-      return child.get();
-    }
-  }
-
-  return nullptr;
-}
-
-}  // namespace
 
 std::string_view Generator::Generate() {
   HandleParseTreeNode(*parse_tree_.GetRoot());
   return target_;
 }
 
-void Generator::GenerateWithDefaultAction(
-    const ParseTreeNode& node, std::function<void(int index)> default_action) {
-  GenerateWithDefaultActionSpan(node, default_action, node.Start(), node.End());
+void Generator::Generate(OutputSink* sink) {
+  sink_ = sink;
+  target_.reserve(OutputSink::kChunkSize);
+  HandleParseTreeNode(*parse_tree_.GetRoot());
+
+  sink_->Append(std::move(target_));
+  target_.clear();
+  sink_ = nullptr;
+}
+
+void Generator::GenerateWithDefaultAction(const ParseTreeNode& node,
+                                          const TextAction& text_action) {
+  GenerateWithDefaultActionSpan(node, text_action, node.Start(), node.End());
 }
 
-void Generator::GenerateWithDefaultActionSpan(
-    const ParseTreeNode& node, std::function<void(int index)> default_action,
-    int start, int end) {
-  ParseTreeNode* next = nullptr;
+void Generator::GenerateWithDefaultActionSpan(const ParseTreeNode& node,
+                                              const TextAction& text_action,
+                                              int start, int end) {
+  const ParseTreeNode::Children& children = node.GetChildren();
+
+  // Children are sorted by the position, so the cursor only moves forward.
+  size_t next = node.GetNextChildIndex(start);
   int current = start;
   while (current < end) {
-    next = GetNext(&node, current);
-    if (next == nullptr) {
-      while (current < end) {
-        default_action(current++);
-      }
-    } else {
-      // Print until it sees the next child.
-      while (current < next->Start()) {
-        default_action(current++);
-      }
-      HandleParseTreeNode(*next);
-      current = next->End();
+    while (next < children.size() && children[next]->Start() < current) {
+      next++;
+    }
+
+    if (next == children.size()) {
+      text_action(current, end);
+      break;
+    }
+
+    // Print until it sees the next child.
+    const ParseTreeNode& child = *children[next++];
+    if (current < child.Start()) {
+      text_action(current, child.Start());
+    }
+    HandleParseTreeNode(child);
+    current = child.End();
+
+    // Only the top most target is handed over; The others are merged into it
+    // later.
+    if (sink_ != nullptr && targets_.size() == 1 &&
+        target_.size() >= OutputSink::kChunkSize) {
+      sink_->Append(std::move(target_));
+      target_.clear();
+      target_.reserve(OutputSink::kChunkSize);
     }
   }
 }
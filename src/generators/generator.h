@@ -4,6 +4,7 @@
 #include <string>
 
 #include "generator_context.h"
+#include "output_sink.h"
 #include "parse_tree.h"
 
 namespace md2 {
@@ -24,6 +25,10 @@ class Generator {
 
   std::string_view Generate();
 
+  // Generates into the sink. The output is handed to the sink in chunks while
+  // it is generated (see OutputSink), so ShowOutput() is not the full output.
+  void Generate(OutputSink* sink);
+
   // Release the generated target.
   std::string&& ReleaseGeneratedTarget() && { return std::move(target_); }
 
@@ -34,15 +39,18 @@ class Generator {
  protected:
   virtual void HandleParseTreeNode(const ParseTreeNode& node) = 0;
 
-  // For the elements that are not part of the child nodes, it runs the
-  // default_action(g, index); Otherwise, it just calls the HandleParseTreeNode
-  // of the child node.
+  // Handles the text [start, end) that is not part of any child node.
+  using TextAction = std::function<void(int start, int end)>;
+
+  // For each run of the text between the child nodes, it runs the
+  // text_action(start, end) once; Otherwise, it just calls the
+  // HandleParseTreeNode of the child node.
   void GenerateWithDefaultAction(const ParseTreeNode& node,
-                                 std::function<void(int index)> default_action);
+                                 const TextAction& text_action);
 
-  void GenerateWithDefaultActionSpan(
-      const ParseTreeNode& node, std::function<void(int index)> default_action,
-      int start, int end);
+  void GenerateWithDefaultActionSpan(const ParseTreeNode& node,
+                                     const TextAction& text_action, int start,
+                                     int end);
 
   std::string_view GetReferenceNodeGeneratedOutput(const std::string& ref_name);
 
@@ -69,6 +77,10 @@ class Generator {
   // on. It will be merged into the top most target (=target_) in the end.
   std::vector<std::string*> targets_;
 
+  // If set, target_ is moved to the sink whenever it grows past the chunk
+  // size.
+  OutputSink* sink_ = nullptr;
+
   GeneratorContext* context_;
 
   const ParseTree& parse_tree_;
@@ -1,5 +1,7 @@
 #include "generator_context.h"
 
+#include <fcntl.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <fstream>
@@ -10,7 +12,9 @@
 #include <utility>
 
 #include "logger.h"
+#include "static_set.h"
 #include "string_util.h"
+#include "trace.h"
 
 namespace md2 {
 namespace {
@@ -24,12 +28,14 @@ constexpr std::string_view kDaumImageURL = "http://img1.daumcdn.net";
 static std::vector<std::string_view> kImageFileExtCandidate{
     "png", "jpg", "jpeg", "gif", "svg", "webp"};
 
-static std::unordered_set<std::string_view> kLatexNotAllowedFileExt{
-    "gif", "svg", "webp"};
+constexpr auto kLatexNotAllowedFileExt =
+    MakeStaticStringSet({"gif", "svg", "webp"});
 
 std::vector<std::unordered_set<std::string_view>> kPreferredExtOrdering = {
     {"gif"}, {"webp"}, {"png"}, {"jpg", "jpeg"}};
 
+thread_local GeneratorDependencies* current_dependencies = nullptr;
+
 bool IsFileExist(const std::string& file_name) {
   std::ifstream in(file_name);
   return in.good();
@@ -60,8 +66,11 @@ void ReadFromPipe(int pipe, std::string* formatted_code) {
 }
 
 void DoClangFormat(std::string_view code, std::string* formatted_code) {
+  // Pipes are created with O_CLOEXEC; Otherwise clang-format processes that
+  // are forked concurrently from other threads inherit the write end of the
+  // pipes and the reader never sees EOF.
   int pipe_p2c[2], pipe_c2p[2];
-  if (pipe(pipe_p2c) != 0 || pipe(pipe_c2p) != 0) {
+  if (pipe2(pipe_p2c, O_CLOEXEC) != 0 || pipe2(pipe_c2p, O_CLOEXEC) != 0) {
     LOG(0) << "Pipe error!";
     return;
   }
@@ -82,12 +91,14 @@ void DoClangFormat(std::string_view code, std::string* formatted_code) {
     int result = write(pipe_p2c[1], code.data(), code.size());
     if (result == -1 || static_cast<size_t>(result) != code.size()) {
       LOG(0) << "Error; STDOUT to clang format has not completed succesfully";
-      return;
     }
     close(pipe_p2c[1]);
 
     // Retrieve the formatted code from the child process.
     ReadFromPipe(pipe_c2p[0], formatted_code);
+
+    int status;
+    waitpid(pid, &status, 0);
   } else {
     // In child process, call execve into the clang format.
 
@@ -100,12 +111,15 @@ void DoClangFormat(std::string_view code, std::string* formatted_code) {
     dup2(pipe_c2p[1], STDOUT_FILENO);
 
     close(pipe_p2c[0]);
-    close(pipe_c2p[0]);
+    close(pipe_c2p[1]);
 
     char* clang_format_argv[] = {kClangFormatName, kClangFormatConfig, NULL};
     char* env[] = {NULL};
     int ret = execve("/usr/bin/clang-format", clang_format_argv, env);
     LOG(0) << "CLANG FORMAT ERROR : " << ret;
+
+    // Do not return to the copy of the caller.
+    _exit(1);
   }
 }
 
@@ -129,7 +143,8 @@ void DoClangFormatUsingFormatServer(int server_port, zmq::context_t& context,
 
 // file_path is relative path from the image_dir_path.
 std::vector<std::string> FindFileAndCandidates(
-    std::string_view file_path, std::string_view image_dir_path) {
+    std::string_view file_path, std::string_view image_dir_path,
+    const ImageIndex& image_index) {
   auto [file_name, file_ext] = GetFileNameAndExtension(file_path);
 
   std::vector<std::string> candidates;
@@ -146,7 +161,13 @@ std::vector<std::string> FindFileAndCandidates(
 
   std::vector<std::string> image_files;
   for (const auto& file : candidates) {
-    if (IsFileExist(StrCat(image_dir_path, "/", file))) {
+    // Only touch the filesystem if the index cannot tell.
+    std::optional<bool> exists = image_index.Exists(file);
+    if (!exists) {
+      exists = IsFileExist(StrCat(image_dir_path, "/", file));
+    }
+
+    if (*exists) {
       image_files.push_back(file);
     }
   }
@@ -161,33 +182,39 @@ std::vector<std::string> FindFileAndCandidates(
 
 }  // namespace
 
+ScopedDependencyRecorder::ScopedDependencyRecorder(
+    GeneratorDependencies* dependencies)
+    : prev_(current_dependencies) {
+  current_dependencies = dependencies;
+}
+
+ScopedDependencyRecorder::~ScopedDependencyRecorder() {
+  current_dependencies = prev_;
+}
+
+GeneratorDependencies* ScopedDependencyRecorder::Current() {
+  return current_dependencies;
+}
+
 std::string_view GeneratorContext::GetClangFormatted(
     const ParseTreeTextNode* node, std::string_view md) {
-  {
-    std::lock_guard<std::mutex> lk(m_format_map);
-    if (const auto itr = verbatim_to_formatted_.find(node);
-        itr != verbatim_to_formatted_.end()) {
-      return itr->second;
+  std::string code(md.substr(node->Start(), node->End() - node->Start()));
+
+  // Keyed by the code itself so that the identical snippets in different
+  // documents are formatted only once.
+  return code_to_formatted_.FindOrInsert(code, [this, &code]() {
+    TRACE_SCOPE("clang-format");
+    std::string formatted_code;
+    if (use_clang_server_) {
+      DoClangFormatUsingFormatServer(clang_server_port_, *context_, code,
+                                     &formatted_code);
+    } else {
+      // Otherwise actually do formatting.
+      DoClangFormat(code, &formatted_code);
     }
-  }
 
-  std::string_view code = md.substr(node->Start(), node->End() - node->Start());
-  std::string formatted_code;
-
-  if (use_clang_server_) {
-    DoClangFormatUsingFormatServer(clang_server_port_, *context_, code,
-                                   &formatted_code);
-  } else {
-    // Otherwise actually do formatting.
-    DoClangFormat(md.substr(node->Start(), node->End() - node->Start()),
-                  &formatted_code);
-  }
-
-  {
-    std::lock_guard<std::mutex> lk(m_format_map);
-    verbatim_to_formatted_[node] = formatted_code;
-    return verbatim_to_formatted_[node];
-  }
+    return formatted_code;
+  });
 }
 
 std::pair<std::string_view, std::string_view> GeneratorContext::FindReference(
@@ -211,6 +238,9 @@ std::pair<std::string_view, std::string_view> GeneratorContext::FindReference(
   }
 
   if (metadata == nullptr) {
+    if (current_dependencies != nullptr) {
+      current_dependencies->refs[std::string(name)] = "";
+    }
     return std::make_pair("", actual_ref);
   }
 
@@ -224,11 +254,25 @@ std::pair<std::string_view, std::string_view> GeneratorContext::FindReference(
     file_name.remove_suffix(3);
   }
 
+  if (current_dependencies != nullptr) {
+    current_dependencies->refs[std::string(name)] = file_name;
+  }
+
   return std::make_pair(file_name, actual_ref);
 }
 
 std::string_view GeneratorContext::FindImageForHtml(
     const std::string& image_url) {
+  std::string_view image = FindPreferredImageForHtml(image_url);
+  if (current_dependencies != nullptr) {
+    current_dependencies->html_images[image_url] = image;
+  }
+
+  return image;
+}
+
+std::string_view GeneratorContext::FindPreferredImageForHtml(
+    const std::string& image_url) {
   const std::vector<std::string>& files = FindImage(image_url);
   if (files.empty()) {
     return image_url;
@@ -249,6 +293,16 @@ std::string_view GeneratorContext::FindImageForHtml(
 }
 
 std::string GeneratorContext::FindImageForLatex(const std::string& image_url) {
+  std::string image = FindPreferredImageForLatex(image_url);
+  if (current_dependencies != nullptr) {
+    current_dependencies->latex_images[image_url] = image;
+  }
+
+  return image;
+}
+
+std::string GeneratorContext::FindPreferredImageForLatex(
+    const std::string& image_url) {
   const std::vector<std::string>& files = FindImage(image_url);
   if (files.empty()) {
     return image_url;
@@ -258,7 +312,7 @@ std::string GeneratorContext::FindImageForLatex(const std::string& image_url) {
 
   for (auto& file_name : files) {
     auto [name, ext] = GetFileNameAndExtension(file_name);
-    if (kLatexNotAllowedFileExt.find(ext) == kLatexNotAllowedFileExt.end()) {
+    if (!kLatexNotAllowedFileExt.Contains(ext)) {
       file = file_name;
       break;
     }
@@ -269,25 +323,41 @@ std::string GeneratorContext::FindImageForLatex(const std::string& image_url) {
 
 const std::vector<std::string>& GeneratorContext::FindImage(
     const std::string& image_url) {
-  if (const auto& actual_path = image_url_to_actual_path_.find(image_url);
-      actual_path != image_url_to_actual_path_.end()) {
-    return actual_path->second;
-  }
+  return image_url_to_actual_path_.FindOrInsert(
+      image_url, [this, &image_url]() { return FindImageFiles(image_url); });
+}
 
+std::vector<std::string> GeneratorContext::FindImageFiles(
+    const std::string& image_url) const {
   if (image_url.find(kDaumImageURL) != std::string_view::npos) {
     size_t id_start = image_url.find("image%2F");
     MD2_ASSERT(id_start != std::string_view::npos,
                "Daum image url is malformed. " + image_url);
 
     std::string image_name = image_url.substr(id_start + 8);
-    image_url_to_actual_path_[image_url] =
-        FindFileAndCandidates(StrCat("/img/", image_name), image_dir_path_);
-  } else {
-    image_url_to_actual_path_[image_url] =
-        FindFileAndCandidates(image_url, image_dir_path_);
+    return FindFileAndCandidates(StrCat("/img/", image_name), image_dir_path_,
+                                 GetImageIndex());
+  }
+
+  return FindFileAndCandidates(image_url, image_dir_path_, GetImageIndex());
+}
+
+const ImageIndex& GeneratorContext::GetImageIndex() const {
+  std::lock_guard<std::mutex> lk(m_image_index);
+  if (image_index_ == nullptr) {
+    image_index_ = std::make_unique<ImageIndex>(image_dir_path_);
+  }
+
+  return *image_index_;
+}
+
+void GeneratorContext::ClearImageCache() {
+  {
+    std::lock_guard<std::mutex> lk(m_image_index);
+    image_index_.reset();
   }
 
-  return image_url_to_actual_path_[image_url];
+  image_url_to_actual_path_.Clear();
 }
 
 const Metadata* GeneratorContext::FindMetadataByFilename(
@@ -1,12 +1,16 @@
 #ifndef GENERATORS_GENERATOR_CONTEXT_H
 #define GENERATORS_GENERATOR_CONTEXT_H
 
+#include <map>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <zmq.hpp>
 
+#include "generators/image_index.h"
 #include "metadata_repo.h"
 #include "parse_tree_nodes/paragraph.h"
+#include "sharded_map.h"
 
 namespace md2 {
 
@@ -15,7 +19,36 @@ struct GeneratorOptions {
   bool no_latex_image = false;
 };
 
-// Common object that is shared by generators.
+// References and images that are resolved through the GeneratorContext while
+// generating a single document. The driver uses this to figure out which files
+// should be regenerated when other files are changed.
+struct GeneratorDependencies {
+  // Map between the reference name and the file name that it is resolved to.
+  // The file name is empty if the reference was not resolved.
+  std::map<std::string, std::string> refs;
+
+  // Map between the image url and the resolved image path.
+  std::map<std::string, std::string> html_images;
+  std::map<std::string, std::string> latex_images;
+};
+
+// While alive, every reference and image that is resolved by any
+// GeneratorContext on the current thread is recorded to the given
+// dependencies.
+class ScopedDependencyRecorder {
+ public:
+  explicit ScopedDependencyRecorder(GeneratorDependencies* dependencies);
+  ~ScopedDependencyRecorder();
+
+  // Returns nullptr if there is no recorder on the current thread.
+  static GeneratorDependencies* Current();
+
+ private:
+  GeneratorDependencies* prev_;
+};
+
+// Common object that is shared by generators. This is thread safe; A single
+// context can be shared by every generator in the build.
 class GeneratorContext {
  public:
   GeneratorContext(const MetadataRepo& repo, const std::string& image_dir_path,
@@ -44,17 +77,32 @@ class GeneratorContext {
   const Metadata* FindMetadataByFilename(std::string_view filename) const;
   const GeneratorOptions& GetGeneratorOptions() const { return options_; }
 
+  // Forget every image that is found so far (e.g when the image directory is
+  // changed). FindImageForHtml returns a view into the cache, so this must
+  // only be called between the builds, while no generator is running.
+  void ClearImageCache();
+
  private:
+  std::string_view FindPreferredImageForHtml(const std::string& image_url);
+  std::string FindPreferredImageForLatex(const std::string& image_url);
+
   const std::vector<std::string>& FindImage(const std::string& image_url);
 
-  std::mutex m_format_map;
-  std::unordered_map<const ParseTreeTextNode*, std::string>
-      verbatim_to_formatted_;
+  // Find the image files in the image directory that match the url.
+  std::vector<std::string> FindImageFiles(const std::string& image_url) const;
+
+  // The image directory is indexed on the first use.
+  const ImageIndex& GetImageIndex() const;
+
+  // Map from the code to the clang formatted code.
+  ShardedMap<std::string, std::string> code_to_formatted_;
 
   // Map from image link url to the actual path. If multiple images are
   // available, then they are inserted into the vector.
-  std::unordered_map<std::string, std::vector<std::string>>
-      image_url_to_actual_path_;
+  ShardedMap<std::string, std::vector<std::string>> image_url_to_actual_path_;
+
+  mutable std::mutex m_image_index;
+  mutable std::unique_ptr<ImageIndex> image_index_;
 
   const MetadataRepo& repo_;
   std::string image_dir_path_;
@@ -0,0 +1,50 @@
+#include "html_escape.h"
+
+#include "special_char_scan.h"
+
+namespace md2 {
+namespace {
+
+// Returns "" if it does not need to be escaped.
+std::string_view EscapeHtmlChar(char c) {
+  switch (c) {
+    case '<':
+      return "&lt;";
+    case '>':
+      return "&gt;";
+    case '&':
+      return "&amp;";
+  }
+
+  return "";
+}
+
+constexpr SpecialCharSet kHtmlSpecialChars("<>&");
+
+}  // namespace
+
+size_t FindHtmlSpecialChar(std::string_view s) {
+  return FindSpecialChar(s, kHtmlSpecialChars);
+}
+
+void AppendEscapedHtml(std::string_view s, std::string* target) {
+  while (!s.empty()) {
+    const size_t pos = FindHtmlSpecialChar(s);
+    target->append(s.substr(0, pos));
+    if (pos == s.size()) {
+      break;
+    }
+
+    target->append(EscapeHtmlChar(s[pos]));
+    s.remove_prefix(pos + 1);
+  }
+}
+
+std::string EscapeHtml(std::string_view s) {
+  std::string escaped;
+  escaped.reserve(s.size());
+  AppendEscapedHtml(s, &escaped);
+  return escaped;
+}
+
+}  // namespace md2
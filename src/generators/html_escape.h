@@ -0,0 +1,21 @@
+#ifndef GENERATORS_HTML_ESCAPE_H
+#define GENERATORS_HTML_ESCAPE_H
+
+#include <string>
+#include <string_view>
+
+namespace md2 {
+
+// Escapes '<', '>' and '&' of the text for HTML. The text is scanned 32 (AVX2)
+// or 16 (SSE2) bytes at a time depending on the CPU, and the runs between the
+// escaped characters are copied at once.
+void AppendEscapedHtml(std::string_view s, std::string* target);
+std::string EscapeHtml(std::string_view s);
+
+// Returns the position of the first character that should be escaped (or the
+// size of s if there is none).
+size_t FindHtmlSpecialChar(std::string_view s);
+
+}  // namespace md2
+
+#endif
@@ -5,10 +5,12 @@
 #include "asm_syntax_highlighter.h"
 #include "cpp_syntax_highlighter.h"
 #include "generator_util.h"
+#include "html_escape.h"
 #include "logger.h"
 #include "objdump_highlighter.h"
 #include "py_syntax_highlighter.h"
 #include "rust_syntax_highlighter.h"
+#include "trace.h"
 
 namespace md2 {
 namespace {
@@ -52,38 +54,12 @@ std::string RunSyntaxHighlighter(const GeneratorContext& context,
     return str_code;
   }
 
+  TRACE_SCOPE("highlight");
   highlighter->ParseCode();
   highlighter->ColorMerge();
   return highlighter->GenerateHighlightedHTML();
 }
 
-// Returns "" if it does not need to be escaped.
-std::string_view EscapeHtmlChar(char c) {
-  if (c == '<') {
-    return "&lt;";
-  } else if (c == '>') {
-    return "&gt;";
-  } else if (c == '&') {
-    return "&amp;";
-  }
-
-  return "";
-}
-
-std::string EscapeString(std::string_view s) {
-  std::string escaped;
-  escaped.reserve(s.size());
-  for (char c : s) {
-    if (std::string_view esc = EscapeHtmlChar(c); !esc.empty()) {
-      escaped.append(esc);
-    } else {
-      escaped.push_back(c);
-    }
-  }
-
-  return escaped;
-}
-
 std::pair<std::string_view, std::string_view> GetCurHeightAndWidthFromImageSize(
     std::string_view image_size) {
   size_t first_comma = image_size.find(',');
@@ -173,21 +149,14 @@ void HTMLGenerator::HandleParseTreeNode(const ParseTreeNode& node) {
   }
 }
 
-void HTMLGenerator::EmitChar(int index) {
-  if (should_escape_html_) {
-    std::string_view escaped = EscapeHtmlChar(md_[index]);
-    if (!escaped.empty()) {
-      GetCurrentTarget()->append(escaped);
-    } else
-      GetCurrentTarget()->push_back(md_[index]);
-  } else {
-    GetCurrentTarget()->push_back(md_[index]);
-  }
-}
+void HTMLGenerator::EmitChar(int index) { EmitChar(index, index + 1); }
 
 void HTMLGenerator::EmitChar(int from, int to) {
-  for (int i = from; i < to; i++) {
-    EmitChar(i);
+  const std::string_view text = md_.substr(from, to - from);
+  if (should_escape_html_) {
+    AppendEscapedHtml(text, GetCurrentTarget());
+  } else {
+    GetCurrentTarget()->append(text);
   }
 }
 
@@ -199,21 +168,23 @@ void HTMLGenerator::HandleParagraph(const ParseTreeParagraphNode& node) {
 
   GetCurrentTarget()->append("<p>");
 
-  GenerateWithDefaultAction(node, [this](int index) { EmitChar(index); });
+  GenerateWithDefaultAction(
+      node, [this](int start, int end) { EmitChar(start, end); });
 
   GetCurrentTarget()->append("</p>");
 }
 
 void HTMLGenerator::HandleText(const ParseTreeTextNode& node) {
-  GenerateWithDefaultAction(node, [this](int index) { EmitChar(index); });
+  GenerateWithDefaultAction(
+      node, [this](int start, int end) { EmitChar(start, end); });
 }
 
 void HTMLGenerator::HandleBold(const ParseTreeBoldNode& node) {
   GetCurrentTarget()->append("<span class='font-weight-bold'>");
 
   GenerateWithDefaultActionSpan(
-      node, [this](int index) { EmitChar(index); }, node.Start() + 2,
-      node.End() - 2);
+      node, [this](int start, int end) { EmitChar(start, end); },
+      node.Start() + 2, node.End() - 2);
 
   GetCurrentTarget()->append("</span>");
 }
@@ -222,8 +193,8 @@ void HTMLGenerator::HandleItalic(const ParseTreeItalicNode& node) {
   GetCurrentTarget()->append("<span class='font-italic'>");
 
   GenerateWithDefaultActionSpan(
-      node, [this](int index) { EmitChar(index); }, node.Start() + 1,
-      node.End() - 1);
+      node, [this](int start, int end) { EmitChar(start, end); },
+      node.Start() + 1, node.End() - 1);
 
   GetCurrentTarget()->append("</span>");
 }
@@ -233,8 +204,8 @@ void HTMLGenerator::HandleStrikeThrough(
   GetCurrentTarget()->append("<span class='font-strike'>");
 
   GenerateWithDefaultActionSpan(
-      node, [this](int index) { EmitChar(index); }, node.Start() + 2,
-      node.End() - 2);
+      node, [this](int start, int end) { EmitChar(start, end); },
+      node.Start() + 2, node.End() - 2);
 
   GetCurrentTarget()->append("</span>");
 }
@@ -277,33 +248,29 @@ void HTMLGenerator::HandleLink(const ParseTreeLinkNode& node) {
 void HTMLGenerator::HandleImage(const ParseTreeImageNode& node) {
   MD2_ASSERT(node.GetChildren().size() == 2, "Number of children is not two");
 
-  const ParseTreeNode* desc_node = node.GetChildren()[0].get();
+  const ParseTreeNode* desc_node = node.GetChildren()[0];
   MD2_ASSERT(desc_node->GetNodeType() == ParseTreeNode::NODE, "");
 
-  const ParseTreeNode* desc = desc_node->GetChildren()[0].get();
+  const ParseTreeNode* desc = desc_node->GetChildren()[0];
   MD2_ASSERT(desc->GetNodeType() == ParseTreeNode::TEXT, "");
 
   images_.push_back(HTMLImageBuilder());
 
-  const auto keyword_to_index = node.GetKeywordToIndex();
-  if (auto index = keyword_to_index.find("alt");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("alt"); index) {
     targets_.push_back(&images_.back().alt);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
-  if (auto index = keyword_to_index.find("caption");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("caption"); index) {
     targets_.push_back(&images_.back().caption);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
-  if (auto index = keyword_to_index.find("size");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("size"); index) {
     targets_.push_back(&images_.back().size);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
@@ -430,7 +397,7 @@ void HTMLGenerator::HandleListItem(const ParseTreeListItemNode& node) {
 void HTMLGenerator::HandleHeader(const ParseTreeHeaderNode& node) {
   MD2_ASSERT(node.GetChildren().size() == 2, "");
 
-  std::string_view header_symbol = GetStringInNode(node.GetChildren()[0].get());
+  std::string_view header_symbol = GetStringInNode(node.GetChildren()[0]);
 
   if (std::all_of(header_symbol.begin(), header_symbol.end(),
                   [](const char c) { return c == '#'; })) {
@@ -454,7 +421,7 @@ void HTMLGenerator::HandleHeader(const ParseTreeHeaderNode& node) {
     GetCurrentTarget()->append("</h2>");
   } else if (header_symbol == "##@") {
     std::string_view header_content =
-        Strip(GetStringInNode(node.GetChildren()[1].get()));
+        Strip(GetStringInNode(node.GetChildren()[1]));
     if (header_content == "chewing-c-end") {
       GetCurrentTarget()->append(fmt::format(kChewingCEnd, GetFileTitle()));
     } else if (header_content == "chewing-cpp-end") {
@@ -487,11 +454,11 @@ void HTMLGenerator::HandleVerbatim(const ParseTreeVerbatimNode& node) {
       // We should emit the link to the inline code instead.
       GetCurrentTarget()->append(
           fmt::format("<a href='{}' class='link-code'>", link));
-      GetCurrentTarget()->append(EscapeString(ref_name));
+      AppendEscapedHtml(ref_name, GetCurrentTarget());
       GetCurrentTarget()->append("</a>");
     } else {
       GetCurrentTarget()->append("<code class='inline-code'>");
-      GetCurrentTarget()->append(EscapeString(ref_name));
+      AppendEscapedHtml(ref_name, GetCurrentTarget());
       GetCurrentTarget()->append("</code>");
     }
     return;
@@ -513,10 +480,10 @@ void HTMLGenerator::HandleVerbatim(const ParseTreeVerbatimNode& node) {
   } else if (name == "py" || name == "asm" || name == "objdump" ||
              name == "rust") {
     GetCurrentTarget()->append(RunSyntaxHighlighter(
-        *context_, GetStringInNode(content_node.get()), name));
+        *context_, GetStringInNode(content_node), name));
   } else if (name == "cpp-formatted") {
     GetCurrentTarget()->append(RunSyntaxHighlighter(
-        *context_, GetStringInNode(content_node.get()), "cpp"));
+        *context_, GetStringInNode(content_node), "cpp"));
   } else if (name == "compiler-warning") {
     GetCurrentTarget()->append(
         "<p class='compiler-warning-title'><i class='xi-warning'></i>컴파일 "
@@ -579,7 +546,7 @@ void HTMLGenerator::HandleCommand(const ParseTreeCommandNode& node) {
   } else if (command == "newline") {
     GetCurrentTarget()->append("<br>");
   } else if (command == "ref") {
-    std::string_view ref_name = GetStringInNode(node.GetChildren()[0].get());
+    std::string_view ref_name = GetStringInNode(node.GetChildren()[0]);
     GetCurrentTarget()->append(
         GetReferenceNodeGeneratedOutput(std::string(ref_name)));
   }
@@ -687,11 +654,7 @@ void HTMLGenerator::HandleBox(const ParseTreeBoxNode& node) {
 
 void HTMLGenerator::HandleQuote(const ParseTreeQuoteNode& node) {
   GetCurrentTarget()->append("<blockquote class='quote'>");
-  GenerateWithDefaultAction(node, [this](int index) {
-    /* Do nothing */
-    (void)(index);
-    (void)(this);
-  });
+  GenerateWithDefaultAction(node, [](int, int) { /* Do nothing */ });
 
   GetCurrentTarget()->append("</blockquote>");
 }
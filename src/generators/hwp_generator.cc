@@ -2,6 +2,7 @@
 
 #include "fmt/format.h"
 #include "generator_util.h"
+#include "special_char_scan.h"
 #include "string_util.h"
 
 namespace md2 {
@@ -150,45 +151,47 @@ std::optional<HwpImageSize> GetHwpImageSize(std::string_view image_size) {
   return size;
 }
 
-}  // namespace
+// Returns "" if it does not need to be escaped.
+std::string_view EscapeHwpChar(char c) {
+  switch (c) {
+    case '\t':
+      return "<TAB/>";
+    case '"':
+      return "&quot;";
+    case '\'':
+      return "&apos;";
+    case '<':
+      return "&lt;";
+    case '>':
+      return "&gt;";
+    case '&':
+      return "&amp;";
+  }
 
-void HwpGenerator::EmitChar(int index) {
-  switch (md_[index]) {
-    case '\t': {
-      GetCurrentTarget()->append("<TAB/>");
-      break;
-    }
-    case '"': {
-      GetCurrentTarget()->append("&quot;");
-      break;
-    }
-    case '\'': {
-      GetCurrentTarget()->append("&apos;");
-      break;
-    }
-    case '<': {
-      GetCurrentTarget()->append("&lt;");
-      break;
-    }
-    case '>': {
-      GetCurrentTarget()->append("&gt;");
-      break;
-    }
-    case '&': {
-      GetCurrentTarget()->append("&amp;");
-      break;
-    }
-    default: {
-      GetCurrentTarget()->push_back(md_[index]);
+  return "";
+}
+
+constexpr SpecialCharSet kHwpSpecialChars("\t\"'<>&");
+
+void AppendEscapedHwp(std::string_view s, std::string* target) {
+  while (!s.empty()) {
+    const size_t pos = FindSpecialChar(s, kHwpSpecialChars);
+    target->append(s.substr(0, pos));
+    if (pos == s.size()) {
       break;
     }
+
+    target->append(EscapeHwpChar(s[pos]));
+    s.remove_prefix(pos + 1);
   }
 }
 
+}  // namespace
+
+void HwpGenerator::EmitChar(int index) { EmitChar(index, index + 1); }
+
 void HwpGenerator::EmitChar(int from, int to) {
-  for (int i = from; i < to; i++) {
-    EmitChar(i);
-  }
+  AppendEscapedHwp(md_.substr(from, to - from), GetCurrentTarget());
 }
 
 void HwpGenerator::HandleParseTreeNode(const ParseTreeNode& node) {
@@ -276,30 +279,15 @@ void HwpGenerator::HandleParagraph(const ParseTreeParagraphNode& node) {
     p_added = true;
   }
 
-  int current_start = node.Start();
-  for (const auto& child_node : node.GetChildren()) {
-    // Handle the regular texts.
-    if (current_start < child_node->Start()) {
-      TextWrapper text_wrapper(
-          this, hwp_state_manager_.GetRegularCharShape(total_paragraph_count_));
-
-      GetCurrentTarget()->append("<CHAR>");
-      EmitChar(current_start, child_node->Start());
-      GetCurrentTarget()->append("</CHAR>");
-    }
-
-    HandleParseTreeNode(*child_node);
-    current_start = child_node->End();
-  }
-
-  if (current_start < node.End()) {
+  // Handle the regular texts.
+  GenerateWithDefaultAction(node, [this](int start, int end) {
     TextWrapper text_wrapper(
         this, hwp_state_manager_.GetRegularCharShape(total_paragraph_count_));
 
     GetCurrentTarget()->append("<CHAR>");
-    EmitChar(current_start, node.End());
+    EmitChar(start, end);
     GetCurrentTarget()->append("</CHAR>");
-  }
+  });
 
   if (p_added) {
     xml_tree_.pop_back();
@@ -404,18 +392,16 @@ void HwpGenerator::HandleImage(const ParseTreeImageNode& node) {
   ParagraphWrapper wrapper(this);
   TextWrapper text_wrapper(this, 0);
 
-  const ParseTreeNode* desc_node = node.GetChildren()[0].get();
+  const ParseTreeNode* desc_node = node.GetChildren()[0];
   MD2_ASSERT(desc_node->GetNodeType() == ParseTreeNode::NODE, "");
 
-  const ParseTreeNode* desc = desc_node->GetChildren()[0].get();
+  const ParseTreeNode* desc = desc_node->GetChildren()[0];
   MD2_ASSERT(desc->GetNodeType() == ParseTreeNode::TEXT, "");
 
-  const auto keyword_to_index = node.GetKeywordToIndex();
   std::string image_size;
-  if (auto index = keyword_to_index.find("size");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("size"); index) {
     targets_.push_back(&image_size);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
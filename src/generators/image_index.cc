@@ -0,0 +1,88 @@
+#include "image_index.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "logger.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+// Splits the normalized relative path into (path without extension,
+// extension). Returns nullopt if the path escapes the root.
+std::optional<std::pair<std::string, std::string>> SplitNormalizedPath(
+    const fs::path& path) {
+  fs::path normalized = path.lexically_normal().relative_path();
+  if (normalized.empty() || *normalized.begin() == "..") {
+    return std::nullopt;
+  }
+
+  std::string ext = normalized.extension().string();
+  if (!ext.empty()) {
+    ext = ext.substr(1);
+  }
+
+  normalized.replace_extension();
+  return std::make_pair(normalized.generic_string(), std::move(ext));
+}
+
+}  // namespace
+
+ImageIndex::ImageIndex(std::string_view image_dir_path) {
+  std::error_code ec;
+  const fs::path root(image_dir_path);
+  if (image_dir_path.empty() || !fs::is_directory(root, ec)) {
+    return;
+  }
+
+  indexed_ = true;
+  for (auto itr = fs::recursive_directory_iterator(
+           root, fs::directory_options::follow_directory_symlink |
+                     fs::directory_options::skip_permission_denied,
+           ec);
+       !ec && itr != fs::recursive_directory_iterator(); itr.increment(ec)) {
+    if (!itr->is_regular_file(ec)) {
+      continue;
+    }
+
+    auto stem_and_ext =
+        SplitNormalizedPath(itr->path().lexically_relative(root));
+    if (!stem_and_ext) {
+      continue;
+    }
+
+    auto& [stem, ext] = *stem_and_ext;
+    stem_to_exts_[std::move(stem)].push_back(std::move(ext));
+    num_files_++;
+  }
+
+  if (ec) {
+    LOG(0) << "Error while scanning the image directory " << image_dir_path
+           << " : " << ec.message();
+  }
+}
+
+std::optional<bool> ImageIndex::Exists(std::string_view file_path) const {
+  if (!indexed_) {
+    return std::nullopt;
+  }
+
+  auto stem_and_ext = SplitNormalizedPath(fs::path(file_path));
+  if (!stem_and_ext) {
+    return std::nullopt;
+  }
+
+  auto& [stem, ext] = *stem_and_ext;
+  auto itr = stem_to_exts_.find(stem);
+  if (itr == stem_to_exts_.end()) {
+    return false;
+  }
+
+  return std::find(itr->second.begin(), itr->second.end(), ext) !=
+         itr->second.end();
+}
+
+}  // namespace md2
@@ -0,0 +1,38 @@
+#ifndef GENERATORS_IMAGE_INDEX_H
+#define GENERATORS_IMAGE_INDEX_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace md2 {
+
+// In-memory index of every file under the image directory. This is built once
+// so that finding images does not need to touch the filesystem.
+class ImageIndex {
+ public:
+  // Scans every file under the image_dir_path. If image_dir_path is not a
+  // directory, then nothing is indexed and Exists always returns nullopt.
+  explicit ImageIndex(std::string_view image_dir_path);
+
+  // Returns whether the file exists. file_path is the path relative to the
+  // image directory (e.g /img/abc.png). Returns nullopt if the path cannot be
+  // answered by the index (e.g it points outside of the image directory).
+  std::optional<bool> Exists(std::string_view file_path) const;
+
+  size_t Size() const { return num_files_; }
+
+ private:
+  // Map from the normalized path without the extension to the available
+  // extensions (e.g img/abc --> {png, webp}).
+  std::unordered_map<std::string, std::vector<std::string>> stem_to_exts_;
+
+  size_t num_files_ = 0;
+  bool indexed_ = false;
+};
+
+}  // namespace md2
+
+#endif
@@ -0,0 +1,65 @@
+#include "latex_escape.h"
+
+#include <array>
+#include <utility>
+
+#include "special_char_scan.h"
+
+namespace md2 {
+namespace {
+
+constexpr std::pair<char, std::string_view> kLatexEscapes[] = {
+    {'~', "$\\sim$"}, {'^', "$\\hat{}$"}, {'\\', "\\textbackslash "},
+    {'&', "\\&"},     {'%', "\\%"},       {'$', "\\$"},
+    {'#', "\\#"},     {'_', "\\_"},       {'{', "\\{"},
+    {'}', "\\}"},     {'<', "$<$"},       {'>', "$>$"}};
+
+// Escaped string of every byte ("" if it does not need to be escaped).
+constexpr std::array<std::string_view, 256> kEscapeTable = [] {
+  std::array<std::string_view, 256> table{};
+  for (const auto& [c, escaped] : kLatexEscapes) {
+    table[static_cast<unsigned char>(c)] = escaped;
+  }
+  return table;
+}();
+
+constexpr SpecialCharSet kLatexSpecialChars("~^\\&%$#_{}<>");
+
+// Must be the same characters as kLatexEscapes.
+static_assert([] {
+  for (int b = 0; b < 256; b++) {
+    if (kLatexSpecialChars.Contains(static_cast<char>(b)) ==
+        kEscapeTable[b].empty()) {
+      return false;
+    }
+  }
+  return true;
+}());
+
+}  // namespace
+
+size_t FindLatexSpecialChar(std::string_view s) {
+  return FindSpecialChar(s, kLatexSpecialChars);
+}
+
+void AppendEscapedLatex(std::string_view s, std::string* target) {
+  while (!s.empty()) {
+    const size_t pos = FindLatexSpecialChar(s);
+    target->append(s.substr(0, pos));
+    if (pos == s.size()) {
+      break;
+    }
+
+    target->append(kEscapeTable[static_cast<unsigned char>(s[pos])]);
+    s.remove_prefix(pos + 1);
+  }
+}
+
+std::string EscapeLatex(std::string_view s) {
+  std::string escaped;
+  escaped.reserve(s.size());
+  AppendEscapedLatex(s, &escaped);
+  return escaped;
+}
+
+}  // namespace md2
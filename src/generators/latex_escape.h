@@ -0,0 +1,21 @@
+#ifndef GENERATORS_LATEX_ESCAPE_H
+#define GENERATORS_LATEX_ESCAPE_H
+
+#include <string>
+#include <string_view>
+
+namespace md2 {
+
+// Escapes the LaTeX special characters (~ ^ \ & % $ # _ { } < >) of the text.
+// The text is scanned 32 (AVX2) or 16 (SSE2) bytes at a time depending on the
+// CPU, and the runs between the escaped characters are copied at once.
+void AppendEscapedLatex(std::string_view s, std::string* target);
+std::string EscapeLatex(std::string_view s);
+
+// Returns the position of the first character that should be escaped (or the
+// size of s if there is none).
+size_t FindLatexSpecialChar(std::string_view s);
+
+}  // namespace md2
+
+#endif
@@ -3,41 +3,11 @@
 #include <fmt/core.h>
 
 #include "generator_util.h"
+#include "latex_escape.h"
 
 namespace md2 {
 namespace {
 
-std::string_view EscapeLatexChar(char c) {
-  switch (c) {
-    case '~':
-      return "$\\sim$";
-    case '^':
-      return "$\\hat{}$";
-    case '\\':
-      return "\\textbackslash ";
-    case '&':
-      return "\\&";
-    case '%':
-      return "\\%";
-    case '$':
-      return "\\$";
-    case '#':
-      return "\\#";
-    case '_':
-      return "\\_";
-    case '{':
-      return "\\{";
-    case '}':
-      return "\\}";
-    case '<':
-      return "$<$";
-    case '>':
-      return "$>$";
-  }
-
-  return "";
-}
-
 std::string EmitTColorBoxHeader(std::string_view color,
                                 std::string_view title = "",
                                 std::string_view font_color = "white") {
@@ -127,21 +97,14 @@ void LatexGenerator::HandleParseTreeNode(const ParseTreeNode& node) {
   }
 }
 
-void LatexGenerator::EmitChar(int index) {
-  if (should_escape_latex_) {
-    std::string_view escaped = EscapeLatexChar(md_[index]);
-    if (!escaped.empty()) {
-      GetCurrentTarget()->append(escaped);
-    } else
-      GetCurrentTarget()->push_back(md_[index]);
-  } else {
-    GetCurrentTarget()->push_back(md_[index]);
-  }
-}
+void LatexGenerator::EmitChar(int index) { EmitChar(index, index + 1); }
 
 void LatexGenerator::EmitChar(int from, int to) {
-  for (int i = from; i < to; i++) {
-    EmitChar(i);
+  const std::string_view text = md_.substr(from, to - from);
+  if (should_escape_latex_) {
+    AppendEscapedLatex(text, GetCurrentTarget());
+  } else {
+    GetCurrentTarget()->append(text);
   }
 }
 
@@ -151,20 +114,22 @@ void LatexGenerator::HandleParagraph(const ParseTreeParagraphNode& node) {
   }
 
   GetCurrentTarget()->append("\n");
-  GenerateWithDefaultAction(node, [this](int index) { EmitChar(index); });
+  GenerateWithDefaultAction(
+      node, [this](int start, int end) { EmitChar(start, end); });
   GetCurrentTarget()->append("\n");
 }
 
 void LatexGenerator::HandleText(const ParseTreeTextNode& node) {
-  GenerateWithDefaultAction(node, [this](int index) { EmitChar(index); });
+  GenerateWithDefaultAction(
+      node, [this](int start, int end) { EmitChar(start, end); });
 }
 
 void LatexGenerator::HandleBold(const ParseTreeBoldNode& node) {
   GetCurrentTarget()->append("\\textbf{");
 
   GenerateWithDefaultActionSpan(
-      node, [this](int index) { EmitChar(index); }, node.Start() + 2,
-      node.End() - 2);
+      node, [this](int start, int end) { EmitChar(start, end); },
+      node.Start() + 2, node.End() - 2);
 
   GetCurrentTarget()->append("}");
 }
@@ -173,8 +138,8 @@ void LatexGenerator::HandleItalic(const ParseTreeItalicNode& node) {
   GetCurrentTarget()->append("\\emph{");
 
   GenerateWithDefaultActionSpan(
-      node, [this](int index) { EmitChar(index); }, node.Start() + 1,
-      node.End() - 1);
+      node, [this](int start, int end) { EmitChar(start, end); },
+      node.Start() + 1, node.End() - 1);
 
   GetCurrentTarget()->append("}");
 }
@@ -184,8 +149,8 @@ void LatexGenerator::HandleStrikeThrough(
   GetCurrentTarget()->append("\\sout{");
 
   GenerateWithDefaultActionSpan(
-      node, [this](int index) { EmitChar(index); }, node.Start() + 2,
-      node.End() - 2);
+      node, [this](int start, int end) { EmitChar(start, end); },
+      node.Start() + 2, node.End() - 2);
 
   GetCurrentTarget()->append("}");
 }
@@ -212,37 +177,33 @@ void LatexGenerator::HandleLink(const ParseTreeLinkNode& node) {
 void LatexGenerator::HandleImage(const ParseTreeImageNode& node) {
   MD2_ASSERT(node.GetChildren().size() == 2, "Number of children is not two");
 
-  const ParseTreeNode* desc_node = node.GetChildren()[0].get();
+  const ParseTreeNode* desc_node = node.GetChildren()[0];
   MD2_ASSERT(desc_node->GetNodeType() == ParseTreeNode::NODE, "");
 
-  const ParseTreeNode* desc = desc_node->GetChildren()[0].get();
+  const ParseTreeNode* desc = desc_node->GetChildren()[0];
   MD2_ASSERT(desc->GetNodeType() == ParseTreeNode::TEXT, "");
 
   images_.push_back(LatexImageBuilder());
 
-  const auto keyword_to_index = node.GetKeywordToIndex();
-  if (auto index = keyword_to_index.find("alt");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("alt"); index) {
     targets_.push_back(&images_.back().alt);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
-  if (auto index = keyword_to_index.find("caption");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("caption"); index) {
     targets_.push_back(&images_.back().caption);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
-  if (auto index = keyword_to_index.find("size");
-      index != keyword_to_index.end()) {
+  if (auto index = node.GetKeywordIndex("size"); index) {
     targets_.push_back(&images_.back().size);
-    HandleParseTreeNode(*desc->GetChildren().at(index->second));
+    HandleParseTreeNode(*desc->GetChildren().at(*index));
     targets_.pop_back();
   }
 
-  images_.back().url = GetStringInNode(node.GetChildren()[1].get(), 1, 1);
+  images_.back().url = GetStringInNode(node.GetChildren()[1], 1, 1);
 
   const LatexImageBuilder& image = images_.back();
   if (image.caption.empty()) {
@@ -323,15 +284,15 @@ void LatexGenerator::HandleVerbatim(const ParseTreeVerbatimNode& node) {
         StrCat("\\begin{minted}{cpp}\n", formatted_cpp, "\n\\end{minted}\n"));
   } else if (name == "py") {
     GetCurrentTarget()->append(StrCat("\\begin{minted}{python}\n",
-                                      GetStringInNode(content_node.get()),
+                                      GetStringInNode(content_node),
                                       "\n\\end{minted}\n"));
   } else if (name == "asm") {
     GetCurrentTarget()->append(StrCat("\\begin{minted}{nasm}\n",
-                                      GetStringInNode(content_node.get()),
+                                      GetStringInNode(content_node),
                                       "\n\\end{minted}\n"));
   } else if (name == "cpp-formatted") {
     GetCurrentTarget()->append(StrCat("\\begin{minted}{cpp}\n",
-                                      GetStringInNode(content_node.get()),
+                                      GetStringInNode(content_node),
                                       "\n\\end{minted}\n"));
   } else if (name == "compiler-warning") {
     GetCurrentTarget()->append(
@@ -416,7 +377,7 @@ void LatexGenerator::HandleListItem(const ParseTreeListItemNode& node) {
 void LatexGenerator::HandleHeader(const ParseTreeHeaderNode& node) {
   MD2_ASSERT(node.GetChildren().size() == 2, "");
 
-  std::string_view header_symbol = GetStringInNode(node.GetChildren()[0].get());
+  std::string_view header_symbol = GetStringInNode(node.GetChildren()[0]);
 
   if (std::all_of(header_symbol.begin(), header_symbol.end(),
                   [](const char c) { return c == '#'; })) {
@@ -465,7 +426,7 @@ void LatexGenerator::HandleCommand(const ParseTreeCommandNode& node) {
   } else if (command == "newline") {
     GetCurrentTarget()->append("\\newline");
   } else if (command == "ref") {
-    std::string_view ref_name = GetStringInNode(node.GetChildren()[0].get());
+    std::string_view ref_name = GetStringInNode(node.GetChildren()[0]);
     GetCurrentTarget()->append(
         GetReferenceNodeGeneratedOutput(std::string(ref_name)));
   }
@@ -552,11 +513,7 @@ void LatexGenerator::HandleBox(const ParseTreeBoxNode& node) {
 
 void LatexGenerator::HandleQuote(const ParseTreeQuoteNode& node) {
   GetCurrentTarget()->append("\n\\begin{displayquote}\n");
-  GenerateWithDefaultAction(node, [this](int index) {
-    /* Do nothing */
-    (void)(index);
-    (void)(this);
-  });
+  GenerateWithDefaultAction(node, [](int, int) { /* Do nothing */ });
 
   GetCurrentTarget()->append("\n\\end{displayquote}\n");
 }
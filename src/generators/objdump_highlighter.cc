@@ -1,20 +1,18 @@
 #include "objdump_highlighter.h"
 
 #include <algorithm>
-#include <unordered_set>
 
 #include "asm_syntax_highlighter.h"
-#include "container_util.h"
 #include "cpp_syntax_highlighter.h"
 #include "logger.h"
+#include "static_set.h"
 #include "string_util.h"
 
 namespace md2 {
 namespace {
 
 constexpr std::string_view kWhiteSpace = " \t";
-static std::unordered_set<char> kATandTAssemblySuffix = {'b', 's', 'w',
-                                                         'l', 'q', 't'};
+constexpr CharSet kATandTAssemblySuffix("bswlqt");
 inline bool IsHexDigit(char c) {
   if ('0' <= c && c <= '9') {
     return true;
@@ -173,7 +171,7 @@ std::string_view ObjdumpHighlighter::FindAssemblyReference(
 
   // If the instruction is not immediately found, check whether it is the AT&T
   // assembly format.
-  if (!SetContains(kATandTAssemblySuffix, inst.back())) {
+  if (!kATandTAssemblySuffix.Contains(inst.back())) {
     return "";
   }
 
@@ -1,21 +1,19 @@
 #include "py_syntax_highlighter.h"
 
-#include <unordered_set>
-
-#include "container_util.h"
+#include "static_set.h"
 
 namespace md2 {
 
 namespace {
 
-std::unordered_set<std::string_view> kPyKeywords = {
+constexpr auto kPyKeywords = MakeStaticStringSet({
     "assert", "async", "await",  "break", "class",    "continue",
     "def",    "del",   "elif",   "else",  "except",   "finally",
     "for",    "from",  "global", "if",    "import",   "in",
     "lambda", "pass",  "raise",  "self",  "nonlocal", "return",
-    "try",    "while", "yield",  "as",    "with"};
+    "try",    "while", "yield",  "as",    "with"});
 
-std::unordered_set<std::string_view> kPyBuiltIn = {
+constexpr auto kPyBuiltIn = MakeStaticStringSet({
     "__import__", "abs",        "all",          "any",      "bin",
     "bool",       "bytearray",  "bytes",        "char",     "classmethod",
     "cmp",        "compile",    "complex",      "delattr",  "dict",
@@ -28,103 +26,27 @@ std::unordered_set<std::string_view> kPyBuiltIn = {
     "ord",        "pow",        "print",        "property", "range",
     "repr",       "reversed",   "round",        "set",      "setattr",
     "slice",      "sorted",     "staticmethod", "str",      "sum",
-    "super",      "tuple",      "type",         "vars",     "zip"};
+    "super",      "tuple",      "type",         "vars",     "zip"});
 
-std::unordered_set<std::string_view> kPyMagicFunctions = {"__abs__",
-                                                          "__add__",
-                                                          "__aenter__",
-                                                          "__aexit__",
-                                                          "__aiter__",
-                                                          "__and__",
-                                                          "__anext__",
-                                                          "__await__",
-                                                          "__bool__",
-                                                          "__bytes__",
-                                                          "__call__",
-                                                          "__complex__",
-                                                          "__contains__",
-                                                          "__del__",
-                                                          "__delattr__",
-                                                          "__delete__",
-                                                          "__delitem__",
-                                                          "__dir__",
-                                                          "__divmod__",
-                                                          "__enter__",
-                                                          "__eq__",
-                                                          "__exit__",
-                                                          "__float__",
-                                                          "__floordiv__",
-                                                          "__format__",
-                                                          "__ge__",
-                                                          "__get__",
-                                                          "__getattr__",
-                                                          "__getattribute__",
-                                                          "__getitem__",
-                                                          "__gt__",
-                                                          "__hash__",
-                                                          "__iadd__",
-                                                          "__iand__",
-                                                          "__ifloordiv__",
-                                                          "__ilshift__",
-                                                          "__imatmul__",
-                                                          "__imod__",
-                                                          "__import__",
-                                                          "__imul__",
-                                                          "__index__",
-                                                          "__init__",
-                                                          "__instancecheck__",
-                                                          "__int__",
-                                                          "__invert__",
-                                                          "__ior__",
-                                                          "__ipow__",
-                                                          "__irshift__",
-                                                          "__isub__",
-                                                          "__iter__",
-                                                          "__itruediv__",
-                                                          "__ixor__",
-                                                          "__le__",
-                                                          "__len__",
-                                                          "__length_hint__",
-                                                          "__lshift__",
-                                                          "__lt__",
-                                                          "__matmul__",
-                                                          "__missing__",
-                                                          "__mod__",
-                                                          "__mul__",
-                                                          "__ne__",
-                                                          "__neg__",
-                                                          "__new__",
-                                                          "__next__",
-                                                          "__or__",
-                                                          "__pos__",
-                                                          "__pow__",
-                                                          "__prepare__",
-                                                          "__radd__",
-                                                          "__rand__",
-                                                          "__rdivmod__",
-                                                          "__repr__",
-                                                          "__reversed__",
-                                                          "__rfloordiv__",
-                                                          "__rlshift__",
-                                                          "__rmatmul__",
-                                                          "__rmod__",
-                                                          "__rmul__",
-                                                          "__ror__",
-                                                          "__round__",
-                                                          "__rpow__",
-                                                          "__rrshift__",
-                                                          "__rshift__",
-                                                          "__rsub__",
-                                                          "__rtruediv__",
-                                                          "__rxor__",
-                                                          "__set__",
-                                                          "__setattr__",
-                                                          "__setitem__",
-                                                          "__str__",
-                                                          "__sub__",
-                                                          "__subclasscheck__",
-                                                          "__truediv__",
-                                                          "__xor__"};
+constexpr auto kPyMagicFunctions = MakeStaticStringSet({
+    "__abs__", "__add__", "__aenter__", "__aexit__", "__aiter__", "__and__",
+    "__anext__", "__await__", "__bool__", "__bytes__", "__call__",
+    "__complex__", "__contains__", "__del__", "__delattr__", "__delete__",
+    "__delitem__", "__dir__", "__divmod__", "__enter__", "__eq__", "__exit__",
+    "__float__", "__floordiv__", "__format__", "__ge__", "__get__",
+    "__getattr__", "__getattribute__", "__getitem__", "__gt__", "__hash__",
+    "__iadd__", "__iand__", "__ifloordiv__", "__ilshift__", "__imatmul__",
+    "__imod__", "__import__", "__imul__", "__index__", "__init__",
+    "__instancecheck__", "__int__", "__invert__", "__ior__", "__ipow__",
+    "__irshift__", "__isub__", "__iter__", "__itruediv__", "__ixor__", "__le__",
+    "__len__", "__length_hint__", "__lshift__", "__lt__", "__matmul__",
+    "__missing__", "__mod__", "__mul__", "__ne__", "__neg__", "__new__",
+    "__next__", "__or__", "__pos__", "__pow__", "__prepare__", "__radd__",
+    "__rand__", "__rdivmod__", "__repr__", "__reversed__", "__rfloordiv__",
+    "__rlshift__", "__rmatmul__", "__rmod__", "__rmul__", "__ror__",
+    "__round__", "__rpow__", "__rrshift__", "__rshift__", "__rsub__",
+    "__rtruediv__", "__rxor__", "__set__", "__setattr__", "__setitem__",
+    "__str__", "__sub__", "__subclasscheck__", "__truediv__", "__xor__"});
 
 // Check whether the character is allowed in the identifier.
 bool IsIdenfierAllowedChar(char c) {
@@ -376,11 +298,11 @@ void PySyntaxHighlighter::AppendCurrentToken(SyntaxTokenType current_token,
   if (current_token == IDENTIFIER) {
     // Check whether it matches one of our keyword set.
     std::string_view token = code_.substr(token_start, token_end - token_start);
-    if (SetContains(kPyBuiltIn, token)) {
+    if (kPyBuiltIn.Contains(token)) {
       current_token = BUILT_IN;
-    } else if (SetContains(kPyKeywords, token)) {
+    } else if (kPyKeywords.Contains(token)) {
       current_token = KEYWORD;
-    } else if (SetContains(kPyMagicFunctions, token)) {
+    } else if (kPyMagicFunctions.Contains(token)) {
       current_token = MAGIC_FUNCTION;
     } else if (IsNumericLiteral(token)) {
       current_token = NUMERIC_LITERAL;
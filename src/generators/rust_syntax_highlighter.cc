@@ -1,25 +1,23 @@
 #include "rust_syntax_highlighter.h"
 
-#include <unordered_set>
-
-#include "container_util.h"
 #include "logger.h"
+#include "static_set.h"
 #include "string_util.h"
 
 namespace md2 {
 namespace {
 
-std::unordered_set<std::string_view> kRustKeywords = {
+constexpr auto kRustKeywords = MakeStaticStringSet({
     "as",     "break",  "const", "continue", "crate",  "else",   "enum",
     "extern", "false",  "fn",    "for",      "if",     "impl",   "in",
     "let",    "loop",   "match", "mod",      "move",   "mut",    "pub",
     "ref",    "return", "self",  "Self",     "static", "struct", "super",
     "trait",  "true",   "type",  "unsafe",   "use",    "where",  "while",
-    "async",  "await",  "dyn"};
+    "async",  "await",  "dyn"});
 
-std::unordered_set<std::string_view> kRustTypeKeywords = {
+constexpr auto kRustTypeKeywords = MakeStaticStringSet({
     "i8",   "u8",    "i16",   "u16", "i32", "u32", "i64", "u64",   "i128",
-    "u128", "isize", "usize", "f32", "f64", "str", "Vec", "String"};
+    "u128", "isize", "usize", "f32", "f64", "str", "Vec", "String"});
 
 // Check whether the character is allowed in the identifier.
 bool IsIdenfierAllowedChar(char c) {
@@ -338,9 +336,9 @@ void RustSyntaxHighlighter::AppendCurrentToken(SyntaxTokenType current_token,
   if (current_token == IDENTIFIER) {
     // Check whether it matches one of our keyword set.
     std::string_view token = code_.substr(token_start, token_end - token_start);
-    if (SetContains(kRustKeywords, token)) {
+    if (kRustKeywords.Contains(token)) {
       current_token = KEYWORD;
-    } else if (SetContains(kRustTypeKeywords, token)) {
+    } else if (kRustTypeKeywords.Contains(token)) {
       current_token = TYPE_KEYWORD;
     } else if (IsNumericLiteral(token)) {
       current_token = NUMERIC_LITERAL;
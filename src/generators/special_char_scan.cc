@@ -0,0 +1,112 @@
+#include "special_char_scan.h"
+
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MD2_SPECIAL_CHAR_SCAN_AVX2
+#endif
+
+namespace md2 {
+namespace {
+
+size_t FindScalar(const char* data, size_t size, const SpecialCharSet& set) {
+  for (size_t i = 0; i < size; i++) {
+    if (set.Contains(data[i])) {
+      return i;
+    }
+  }
+  return size;
+}
+
+#if defined(__SSE2__)
+// SSE2 has no byte shuffle, so it compares against each character.
+size_t FindSse2(const char* data, size_t size, const SpecialCharSet& set) {
+  const std::string_view chars = set.Chars();
+
+  size_t pos = 0;
+  for (; pos + 16 <= size; pos += 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+    __m128i mask = _mm_setzero_si128();
+    for (const char c : chars) {
+      mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)));
+    }
+    if (const auto bits = static_cast<uint32_t>(_mm_movemask_epi8(mask))) {
+      return pos + std::countr_zero(bits);
+    }
+  }
+
+  return pos + FindScalar(data + pos, size - pos, set);
+}
+#endif
+
+#if defined(MD2_SPECIAL_CHAR_SCAN_AVX2)
+// Classifies the bytes by the nibble tables with two shuffles.
+__attribute__((target("avx2"))) size_t FindAvx2(const char* data, size_t size,
+                                                 const SpecialCharSet& set) {
+  const __m256i low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(set.LowNibbles().data())));
+  const __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(set.HighNibbles().data())));
+  const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+
+  size_t pos = 0;
+  for (; pos + 32 <= size; pos += 32) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+    const __m256i low = _mm256_shuffle_epi8(
+        low_table, _mm256_and_si256(chunk, nibble_mask));
+    const __m256i high = _mm256_shuffle_epi8(
+        high_table,
+        _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble_mask));
+    const __m256i not_special = _mm256_cmpeq_epi8(
+        _mm256_and_si256(low, high), _mm256_setzero_si256());
+    if (const auto bits =
+            ~static_cast<uint32_t>(_mm256_movemask_epi8(not_special))) {
+      _mm256_zeroupper();
+      return pos + std::countr_zero(bits);
+    }
+  }
+
+  // Otherwise the SSE code that runs after this pays the transition penalty
+  // (the compiler does not always put it by itself).
+  _mm256_zeroupper();
+  return pos + FindSse2(data + pos, size - pos, set);
+}
+#endif
+
+using FindFn = size_t (*)(const char* data, size_t size,
+                          const SpecialCharSet& set);
+
+// Picks the widest kernel that the CPU supports.
+FindFn ResolveFind() {
+#if defined(MD2_SPECIAL_CHAR_SCAN_AVX2)
+  if (__builtin_cpu_supports("avx2")) {
+    return FindAvx2;
+  }
+#endif
+#if defined(__SSE2__)
+  return FindSse2;
+#else
+  return FindScalar;
+#endif
+}
+
+}  // namespace
+
+size_t FindSpecialChar(std::string_view s, const SpecialCharSet& set) {
+  // Most of the text runs are short; Not worth the indirect call.
+  if (s.size() < 16) {
+    return FindScalar(s.data(), s.size(), set);
+  }
+
+  static const FindFn find = ResolveFind();
+  return find(s.data(), s.size(), set);
+}
+
+}  // namespace md2
@@ -0,0 +1,74 @@
+#ifndef GENERATORS_SPECIAL_CHAR_SCAN_H
+#define GENERATORS_SPECIAL_CHAR_SCAN_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace md2 {
+
+// Set of the characters that FindSpecialChar looks for. It is meant to be
+// built at compile time; At most 16 characters, and their high nibbles can
+// take at most 8 distinct values.
+class SpecialCharSet {
+ public:
+  static constexpr size_t kMaxChars = 16;
+
+  constexpr explicit SpecialCharSet(std::string_view chars);
+
+  constexpr bool Contains(char c) const {
+    return contains_[static_cast<unsigned char>(c)];
+  }
+
+  constexpr std::string_view Chars() const {
+    return std::string_view(chars_.data(), num_chars_);
+  }
+
+  // The byte b is in the set iff (LowNibbles()[b & 0xF] &
+  // HighNibbles()[b >> 4]) != 0. Every high nibble that has a character in
+  // the set owns its own bit, so the test is exact.
+  constexpr const std::array<uint8_t, 16>& LowNibbles() const { return low_; }
+  constexpr const std::array<uint8_t, 16>& HighNibbles() const {
+    return high_;
+  }
+
+ private:
+  std::array<char, kMaxChars> chars_{};
+  size_t num_chars_ = 0;
+
+  std::array<bool, 256> contains_{};
+  std::array<uint8_t, 16> low_{};
+  std::array<uint8_t, 16> high_{};
+};
+
+constexpr SpecialCharSet::SpecialCharSet(std::string_view chars) {
+  // Not a constant expression if thrown; Compilation fails there.
+  if (chars.size() > kMaxChars) {
+    throw "Too many characters";
+  }
+
+  int num_bits = 0;
+  for (const char c : chars) {
+    const auto u = static_cast<unsigned char>(c);
+    chars_[num_chars_++] = c;
+    contains_[u] = true;
+
+    if (high_[u >> 4] == 0) {
+      if (num_bits == 8) {
+        throw "Too many high nibbles";
+      }
+      high_[u >> 4] = uint8_t{1} << num_bits++;
+    }
+    low_[u & 0xF] |= high_[u >> 4];
+  }
+}
+
+// Returns the position of the first character of s that is in the set (or the
+// size of s if there is none). The text is scanned 32 (AVX2) or 16 (SSE2)
+// bytes at a time depending on the CPU.
+size_t FindSpecialChar(std::string_view s, const SpecialCharSet& set);
+
+}  // namespace md2
+
+#endif
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <fstream>
 
+#include "html_escape.h"
 #include "logger.h"
 #include "string_util.h"
 
@@ -121,21 +122,6 @@ std::string_view TokenTypeToString(SyntaxTokenType type) {
   return "";
 }
 
-void EscapeHTML(std::string* s) {
-  for (size_t i = 0; i < s->length(); i++) {
-    if (s->at(i) == '<') {
-      s->replace(i, 1, "&lt;");
-      i += 3;
-    } else if (s->at(i) == '>') {
-      s->replace(i, 1, "&gt;");
-      i += 3;
-    } else if (s->at(i) == '&') {
-      s->replace(i, 1, "&amp;");
-      i += 3;
-    }
-  }
-}
-
 template <typename K, typename V>
 bool IsUnorderedMapIdentical(const std::unordered_map<K, V>& m1,
                              const std::unordered_map<K, V>& m2) {
@@ -165,10 +151,8 @@ std::string SyntaxHighlighter::GenerateHighlightedHTML() const {
 
   for (const auto& token : token_list_) {
     std::string class_name = TokenTypeToClassName(token.token_type);
-    std::string token_str(
+    const std::string token_str = EscapeHtml(
         code_.substr(token.token_start, token.token_end - token.token_start));
-
-    EscapeHTML(&token_str);
     html += StrCat("<span class='", class_name, "'>",
                    GetReferenceOf(token.token_type, token_str), "</span>");
   }
@@ -21,14 +21,14 @@ std::string CharToHex(int c) {
 
 }  // namespace
 
-std::optional<std::string> GenerateSha256Hash(const std::string& s) {
+std::optional<std::string> GenerateSha256Hash(std::string_view s) {
   std::optional<std::string> maybe_hash = std::nullopt;
 
   EVP_MD_CTX* context = EVP_MD_CTX_new();
 
   if (context != NULL) {
     if (EVP_DigestInit_ex(context, EVP_sha256(), NULL)) {
-      if (EVP_DigestUpdate(context, s.c_str(), s.length())) {
+      if (EVP_DigestUpdate(context, s.data(), s.length())) {
         unsigned char hash_arr[kSha256HashLength];
         unsigned int hash_length = kSha256HashLength;
 
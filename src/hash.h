@@ -3,10 +3,11 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 
 namespace md2 {
 
-std::optional<std::string> GenerateSha256Hash(const std::string& s);
+std::optional<std::string> GenerateSha256Hash(std::string_view s);
 
 }  // namespace md2
 
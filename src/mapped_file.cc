@@ -0,0 +1,92 @@
+#include "mapped_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+namespace md2 {
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(0) << "Unable to open " << path;
+    return nullptr;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    LOG(0) << "Unable to stat " << path;
+    close(fd);
+    return nullptr;
+  }
+
+  // mmap does not allow zero length mapping.
+  if (st.st_size == 0) {
+    close(fd);
+    return std::unique_ptr<MappedFile>(new MappedFile("", 0));
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping remains valid after the file descriptor is closed.
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    LOG(0) << "Unable to mmap " << path;
+    return nullptr;
+  }
+
+  // Files are scanned from the beginning to the end.
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  madvise(data, st.st_size, MADV_WILLNEED);
+
+  return std::unique_ptr<MappedFile>(
+      new MappedFile(static_cast<const char*>(data), st.st_size));
+}
+
+std::unique_ptr<MappedFile> MappedFile::Read(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(0) << "Unable to open " << path;
+    return nullptr;
+  }
+
+  // The size is only a hint; The file may be changed while reading it.
+  struct stat st;
+  std::string content;
+  if (fstat(fd, &st) == 0) {
+    content.reserve(st.st_size);
+  }
+
+  char buffer[64 * 1024];
+  while (true) {
+    ssize_t num_read = read(fd, buffer, sizeof(buffer));
+    if (num_read < 0 && errno == EINTR) {
+      continue;
+    }
+    if (num_read < 0) {
+      LOG(0) << "Unable to read " << path;
+      close(fd);
+      return nullptr;
+    }
+    if (num_read == 0) {
+      break;
+    }
+    content.append(buffer, num_read);
+  }
+
+  close(fd);
+  return std::unique_ptr<MappedFile>(new MappedFile(std::move(content)));
+}
+
+MappedFile::~MappedFile() {
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+}  // namespace md2
@@ -0,0 +1,53 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace md2 {
+
+// Read-only memory mapping of the entire file. The mapping is released when
+// the object is destroyed, so every string_view returned by Content() must
+// not outlive it.
+class MappedFile {
+ public:
+  // Returns nullptr if the file could not be opened or mapped.
+  static std::unique_ptr<MappedFile> Open(const std::string& path);
+
+  // Same as Open but the file is copied into memory instead of being mapped.
+  // The mapped content changes (or the access raises SIGBUS) if the file is
+  // modified in place, so this should be used for the files that may be edited
+  // while the content is in use.
+  static std::unique_ptr<MappedFile> Read(const std::string& path);
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile();
+
+  std::string_view Content() const { return std::string_view(data_, size_); }
+
+ private:
+  MappedFile(const char* data, size_t size)
+      : data_(data), size_(size), mapped_(size > 0) {}
+  explicit MappedFile(std::string content)
+      : content_(std::move(content)),
+        data_(content_.data()),
+        size_(content_.size()),
+        mapped_(false) {}
+
+  // Owns the content if the file is read instead of being mapped.
+  std::string content_;
+
+  const char* data_;
+  size_t size_;
+
+  // True if data_ should be unmapped.
+  bool mapped_;
+};
+
+}  // namespace md2
+
+#endif
@@ -58,7 +58,8 @@ std::unique_ptr<Metadata> MetadataFactory::ParseMetadata(
   size_t current = 0;
 
   // Ignore until it sees non whitespace.
-  while (std::isspace(content[current])) {
+  while (current < content.size() &&
+         std::isspace(static_cast<unsigned char>(content[current]))) {
     current++;
   }
 
@@ -68,7 +69,7 @@ std::unique_ptr<Metadata> MetadataFactory::ParseMetadata(
   }
 
   // Go to the next line.
-  while (content[current] != '\n' && current < content.size()) {
+  while (current < content.size() && content[current] != '\n') {
     current++;
   }
 
@@ -79,6 +79,11 @@ bool MetadataRepo::RegisterMetadata(std::string_view filename,
   return true;
 }
 
+void MetadataRepo::Clear() {
+  ref_to_metadata_.clear();
+  repo_.clear();
+}
+
 const Metadata* MetadataRepo::FindMetadata(std::string_view ref) const {
   std::string lowercase_ref;
   std::transform(ref.begin(), ref.end(), std::back_inserter(lowercase_ref),
@@ -26,6 +26,9 @@ class MetadataRepo {
   // Pathname is the normalized version of filename (e.g dump_121.md --> 121)
   const Metadata* FindMetadataByPathname(std::string_view filename) const;
 
+  // Remove every registered metadata.
+  void Clear();
+
   std::string DumpFileHeaderAsJson() const;
   std::string DumpPathAsJson() const;
 
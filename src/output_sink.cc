@@ -0,0 +1,83 @@
+#include "output_sink.h"
+
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace md2 {
+
+void OutputSink::Append(std::string chunk) {
+  if (chunk.empty()) {
+    return;
+  }
+
+  size_ += chunk.size();
+  chunks_.push_back(std::move(chunk));
+}
+
+bool OutputSink::Equals(std::string_view content) const {
+  if (content.size() != size_) {
+    return false;
+  }
+
+  for (const std::string& chunk : chunks_) {
+    if (content.substr(0, chunk.size()) != chunk) {
+      return false;
+    }
+    content.remove_prefix(chunk.size());
+  }
+
+  return true;
+}
+
+bool OutputSink::WriteTo(int fd) const {
+  std::vector<iovec> iovs;
+  iovs.reserve(chunks_.size());
+  for (const std::string& chunk : chunks_) {
+    iovs.push_back(iovec{.iov_base = const_cast<char*>(chunk.data()),
+                         .iov_len = chunk.size()});
+  }
+
+  // writev takes at most IOV_MAX buffers and may write only a part of them.
+  size_t first = 0;
+  while (first < iovs.size()) {
+    const int count = static_cast<int>(
+        std::min<size_t>(iovs.size() - first, IOV_MAX));
+    ssize_t written = writev(fd, &iovs[first], count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    while (first < iovs.size() &&
+           static_cast<size_t>(written) >= iovs[first].iov_len) {
+      written -= iovs[first].iov_len;
+      first++;
+    }
+    if (written > 0) {
+      iovs[first].iov_base = static_cast<char*>(iovs[first].iov_base) + written;
+      iovs[first].iov_len -= written;
+    }
+  }
+
+  return true;
+}
+
+std::string OutputSink::ToString() && {
+  if (chunks_.size() == 1) {
+    return std::move(chunks_[0]);
+  }
+
+  std::string content;
+  content.reserve(size_);
+  for (const std::string& chunk : chunks_) {
+    content.append(chunk);
+  }
+  return content;
+}
+
+}  // namespace md2
@@ -0,0 +1,42 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace md2 {
+
+// Generated output as the list of the chunks. The generator hands its buffer
+// over as a chunk whenever it grows past kChunkSize, so the output is never
+// copied into one contiguous string; It is written to the file with writev,
+// sent as the ZMQ frames or handed to the FFI callers chunk by chunk.
+class OutputSink {
+ public:
+  static constexpr size_t kChunkSize = 64 << 10;
+
+  // Takes the chunk without copying it. Empty chunks are dropped.
+  void Append(std::string chunk);
+
+  size_t Size() const { return size_; }
+  const std::vector<std::string>& Chunks() const { return chunks_; }
+
+  // Returns true if the concatenated chunks equal to the content.
+  bool Equals(std::string_view content) const;
+
+  // Writes every chunk to the fd (with writev). Returns false on the error.
+  bool WriteTo(int fd) const;
+
+  // Concatenates the chunks. It is not copied if there is only one chunk.
+  std::string ToString() &&;
+
+  std::vector<std::string> ReleaseChunks() && { return std::move(chunks_); }
+
+ private:
+  std::vector<std::string> chunks_;
+  size_t size_ = 0;
+};
+
+}  // namespace md2
+
+#endif
@@ -0,0 +1,140 @@
+#include "output_writer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+#include "logger.h"
+#include "mapped_file.h"
+#include "string_util.h"
+#include "trace.h"
+
+namespace md2 {
+namespace {
+
+// Returns nullptr unless the path is a regular file of the size.
+std::unique_ptr<MappedFile> OpenIfSameSize(const std::string& path,
+                                           size_t size) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+      static_cast<size_t>(st.st_size) != size) {
+    return nullptr;
+  }
+
+  return MappedFile::Open(path);
+}
+
+bool IsSameContent(const std::string& path, std::string_view content) {
+  std::unique_ptr<MappedFile> file = OpenIfSameSize(path, content.size());
+  return file != nullptr && file->Content() == content;
+}
+
+bool IsSameContent(const std::string& path, const OutputSink& content) {
+  std::unique_ptr<MappedFile> file = OpenIfSameSize(path, content.Size());
+  return file != nullptr && content.Equals(file->Content());
+}
+
+bool WriteAll(int fd, std::string_view content) {
+  while (!content.empty()) {
+    ssize_t written = write(fd, content.data(), content.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    content.remove_prefix(written);
+  }
+
+  return true;
+}
+
+bool WriteAll(int fd, const OutputSink& content) { return content.WriteTo(fd); }
+
+// Writes the content to the temporary file and renames it to the path.
+template <typename Content>
+OutputWriter::WriteResult WriteFileIfChangedImpl(const std::string& path,
+                                                 const Content& content) {
+  if (IsSameContent(path, content)) {
+    return OutputWriter::UNCHANGED;
+  }
+
+  // The temporary file is in the same directory so that rename is atomic. Its
+  // name is unique, so that the processes writing the same path (e.g sharing
+  // the parse tree cache) never write to the same temporary file.
+  std::string temp_path = StrCat(path, ".XXXXXX");
+  int fd = mkostemp(temp_path.data(), O_CLOEXEC);
+  if (fd < 0) {
+    LOG(0) << "Unable to create the temporary file of " << path;
+    return OutputWriter::FAILED;
+  }
+
+  // mkostemp creates the file readable by the owner only.
+  bool ok = fchmod(fd, 0644) == 0 && WriteAll(fd, content);
+  ok = (close(fd) == 0) && ok;
+
+  if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    LOG(0) << "Unable to write " << path;
+    unlink(temp_path.c_str());
+    return OutputWriter::FAILED;
+  }
+
+  return OutputWriter::WRITTEN;
+}
+
+}  // namespace
+
+OutputWriter::OutputWriter(size_t max_pending) : queue_(max_pending) {
+  writer_ = std::thread([this]() {
+    while (auto output = queue_.Pop()) {
+      TRACE_SCOPE("write", output->path);
+      switch (WriteFileIfChanged(output->path, output->content)) {
+        case WRITTEN:
+          num_written_++;
+          break;
+        case UNCHANGED:
+          num_unchanged_++;
+          break;
+        case FAILED:
+          num_failed_++;
+          break;
+      }
+    }
+  });
+}
+
+OutputWriter::~OutputWriter() { Finish(); }
+
+void OutputWriter::Write(std::string path, std::string content) {
+  OutputSink sink;
+  sink.Append(std::move(content));
+  Write(std::move(path), std::move(sink));
+}
+
+void OutputWriter::Write(std::string path, OutputSink content) {
+  queue_.Push(Output{.path = std::move(path), .content = std::move(content)});
+}
+
+void OutputWriter::Finish() {
+  queue_.Close();
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+}
+
+OutputWriter::WriteResult OutputWriter::WriteFileIfChanged(
+    const std::string& path, std::string_view content) {
+  return WriteFileIfChangedImpl(path, content);
+}
+
+OutputWriter::WriteResult OutputWriter::WriteFileIfChanged(
+    const std::string& path, const OutputSink& content) {
+  return WriteFileIfChangedImpl(path, content);
+}
+
+}  // namespace md2
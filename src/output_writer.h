@@ -0,0 +1,61 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "bounded_queue.h"
+#include "output_sink.h"
+
+namespace md2 {
+
+// Writes the generated files on a dedicated thread so that the render threads
+// do not block on the disk. Files are replaced atomically (written to a
+// temporary file and then renamed), and the files whose content is identical
+// to the existing one are not touched at all (so that their mtime is kept).
+class OutputWriter {
+ public:
+  enum WriteResult { WRITTEN, UNCHANGED, FAILED };
+
+  // At most max_pending outputs are buffered; Write() blocks beyond that.
+  explicit OutputWriter(size_t max_pending);
+
+  // Waits until every pending output is written.
+  ~OutputWriter();
+
+  void Write(std::string path, std::string content);
+  void Write(std::string path, OutputSink content);
+
+  // Waits until every pending output is written. No more Write() is allowed
+  // after this.
+  void Finish();
+
+  size_t NumWritten() const { return num_written_; }
+  size_t NumUnchanged() const { return num_unchanged_; }
+  size_t NumFailed() const { return num_failed_; }
+
+  // Synchronously writes the file unless the content is the same.
+  static WriteResult WriteFileIfChanged(const std::string& path,
+                                        std::string_view content);
+  static WriteResult WriteFileIfChanged(const std::string& path,
+                                        const OutputSink& content);
+
+ private:
+  struct Output {
+    std::string path;
+    OutputSink content;
+  };
+
+  BoundedQueue<Output> queue_;
+  std::thread writer_;
+
+  std::atomic<size_t> num_written_ = 0;
+  std::atomic<size_t> num_unchanged_ = 0;
+  std::atomic<size_t> num_failed_ = 0;
+};
+
+}  // namespace md2
+
+#endif
@@ -0,0 +1,205 @@
+#include "parallel_parser.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+// True if the blank line right after the line is almost always a sync point;
+// i.e the line is a paragraph text, a header or the end of the box. E.g the
+// list item is not since the blank line belongs to the list item.
+bool IsFollowedBySyncPoint(std::string_view line) {
+  if (line.empty()) {
+    return false;
+  }
+
+  if (line == "```") {
+    return true;
+  }
+
+  const char c = line[0];
+  if ('0' <= c && c <= '9') {
+    return false;
+  }
+
+  return std::string_view(" \t*|>`$\\").find(c) == std::string_view::npos;
+}
+
+}  // namespace
+
+struct ParallelParser::Chunk {
+  size_t start = 0;
+
+  std::unique_ptr<Arena> arena;
+  ParseTreeNode* root = nullptr;
+  RefContainer refs;
+  std::vector<SyncPoint> sync_points;
+
+  // Where the parse of the chunk stopped.
+  size_t end = 0;
+  bool parsed = false;
+
+  // True if the chunk stopped at the sync point (which is the start of the
+  // later chunk) rather than at the end of the content.
+  bool StoppedAtSyncPoint() const {
+    return !sync_points.empty() &&
+           static_cast<size_t>(sync_points.back().position) == end;
+  }
+};
+
+std::vector<size_t> ParallelParser::FindSplitPoints(std::string_view content,
+                                                    size_t chunk_size) {
+  std::vector<size_t> split_points;
+  size_t next_split = chunk_size;
+
+  int box_depth = 0;
+  bool in_math = false;
+
+  // Last two lines before the current line.
+  std::string_view prev_line, prev_prev_line;
+
+  size_t line_start = 0;
+  while (line_start < content.size()) {
+    size_t line_end = content.find('\n', line_start);
+    if (line_end == std::string_view::npos) {
+      line_end = content.size();
+    }
+    std::string_view line = content.substr(line_start, line_end - line_start);
+
+    // Line that comes right after the single blank line.
+    if (line_start >= next_split && box_depth == 0 && !in_math &&
+        !line.empty() && prev_line.empty() &&
+        IsFollowedBySyncPoint(prev_prev_line)) {
+      split_points.push_back(line_start);
+      next_split = line_start + chunk_size;
+    }
+
+    if (line.starts_with("```")) {
+      if (line == "```") {
+        box_depth = std::max(box_depth - 1, 0);
+      } else {
+        box_depth++;
+      }
+    } else if (box_depth == 0) {
+      for (size_t pos = line.find("$$"); pos != std::string_view::npos;
+           pos = line.find("$$", pos + 2)) {
+        in_math = !in_math;
+      }
+    }
+
+    prev_prev_line = prev_line;
+    prev_line = line;
+    line_start = line_end + 1;
+  }
+
+  return split_points;
+}
+
+void ParallelParser::ParseChunk(std::string_view content,
+                                const StructuralIndex& structural_index,
+                                const std::function<bool(size_t)>& stop_at,
+                                Chunk* chunk) {
+  chunk->arena = std::make_unique<Arena>();
+  chunk->root = ParseTreeNode::Create<ParseTreeNode>(
+      chunk->arena.get(), /*parent=*/nullptr, chunk->start);
+  if (chunk->start == 0) {
+    chunk->sync_points.push_back(SyncPoint{.position = 0, .read_end = 0});
+  }
+
+  chunk->end = Parser().ParseTopLevel(
+      content, &structural_index, chunk->arena.get(), chunk->start,
+      /*read_end=*/chunk->start, chunk->root, &chunk->refs, &chunk->sync_points,
+      stop_at);
+  chunk->parsed = true;
+}
+
+ParseTree ParallelParser::GenerateParseTree(std::string_view content,
+                                            std::unique_ptr<Arena> arena) {
+  const size_t chunk_size =
+      std::max(min_chunk_size_, content.size() / pool_->NumThreads() + 1);
+  const std::vector<size_t> split_points = FindSplitPoints(content, chunk_size);
+  if (split_points.empty()) {
+    return Parser().GenerateParseTree(content, std::move(arena));
+  }
+
+  std::vector<Chunk> chunks(split_points.size() + 1);
+  for (size_t i = 0; i < split_points.size(); i++) {
+    chunks[i + 1].start = split_points[i];
+  }
+
+  const StructuralIndex structural_index(content);
+  const std::function<bool(size_t)> stop_at =
+      [&split_points](size_t position) {
+        return std::binary_search(split_points.begin(), split_points.end(),
+                                  position);
+      };
+
+  TaskGroup group;
+  for (Chunk& chunk : chunks) {
+    pool_->Submit(
+        [&, chunk = &chunk]() {
+          ParseChunk(content, structural_index, stop_at, chunk);
+        },
+        &group);
+  }
+  pool_->Wait(group);
+
+  if (!std::all_of(chunks.begin(), chunks.end(),
+                   [](const Chunk& chunk) { return chunk.parsed; })) {
+    return Parser().GenerateParseTree(content, std::move(arena));
+  }
+
+  auto* root = ParseTreeNode::Create<ParseTreeNode>(arena.get(),
+                                                    /*parent=*/nullptr, 0);
+  RefContainer refs;
+  std::vector<SyncPoint> sync_points;
+
+  // Follows the chunks that start where the previous one stopped.
+  auto chunk = chunks.begin();
+  while (true) {
+    for (ParseTreeNode* block : chunk->root->GetChildren()) {
+      if (block->GetParent() == chunk->root) {
+        block->SetParent(root);
+      }
+      root->AddChildren(block);
+    }
+    root->SetEnd(chunk->root->End());
+
+    // Later definition of the reference wins as in the sequential parse.
+    for (auto& [name, node] : chunk->refs) {
+      refs[name] = node;
+    }
+
+    // The sequential parse had looked at least as far as the previous sync
+    // point did.
+    for (SyncPoint sync_point : chunk->sync_points) {
+      if (!sync_points.empty()) {
+        sync_point.read_end =
+            std::max(sync_point.read_end, sync_points.back().read_end);
+      }
+      sync_points.push_back(sync_point);
+    }
+
+    arena->Adopt(std::move(chunk->arena));
+
+    if (!chunk->StoppedAtSyncPoint()) {
+      break;
+    }
+
+    const size_t end = chunk->end;
+    chunk = std::find_if(chunk + 1, chunks.end(), [end](const Chunk& next) {
+      return next.start == end;
+    });
+    if (chunk == chunks.end()) {
+      break;
+    }
+  }
+
+  return ParseTree(std::move(arena), root, std::move(refs),
+                   std::move(sync_points));
+}
+
+}  // namespace md2
@@ -0,0 +1,60 @@
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+#include "parse_tree.h"
+#include "structural_index.h"
+#include "thread_pool.h"
+
+namespace md2 {
+
+// Parses a large document on multiple threads of the pool.
+//
+// The document is split at the blank lines that are likely to be the sync
+// points (i.e not inside of the box, the math or the list) and every chunk is
+// parsed from its split point in parallel. The parse of a chunk stops at the
+// first later split point that turns out to be a sync point, so the chunk that
+// starts there continues exactly where the sequential parse would be. Chunks
+// that do not start at a sync point are covered by the parse of the previous
+// chunk and are discarded. Hence the tree is always the same as the one that
+// Parser::GenerateParseTree builds.
+class ParallelParser {
+ public:
+  // Documents are not split into the chunks smaller than this.
+  static constexpr size_t kMinChunkSize = 256 * 1024;
+
+  explicit ParallelParser(ThreadPool* pool,
+                          size_t min_chunk_size = kMinChunkSize)
+      : pool_(pool), min_chunk_size_(min_chunk_size) {}
+
+  ParseTree GenerateParseTree(std::string_view content,
+                              std::unique_ptr<Arena> arena);
+
+  // Returns the positions (right after the blank lines) that split the content
+  // into the chunks of at least chunk_size bytes.
+  static std::vector<size_t> FindSplitPoints(std::string_view content,
+                                             size_t chunk_size);
+
+ private:
+  // Result of the parse of the chunk.
+  struct Chunk;
+
+  // Parses from the start of the chunk until the sync point where stop_at
+  // returns true (or the end of the content).
+  static void ParseChunk(std::string_view content,
+                         const StructuralIndex& structural_index,
+                         const std::function<bool(size_t)>& stop_at,
+                         Chunk* chunk);
+
+  ThreadPool* pool_;
+  size_t min_chunk_size_;
+};
+
+}  // namespace md2
+
+#endif
@@ -1,6 +1,74 @@
 #include "parse_tree.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <unordered_set>
+
+#include "parser.h"
+#include "structural_index.h"
+
 namespace md2 {
+namespace {
+
+// Shifts the offsets of the node and its subtree.
+void ShiftNode(ParseTreeNode* node, int delta) {
+  node->SetStart(node->Start() + delta);
+  node->SetEnd(node->End() + delta);
+  for (ParseTreeNode* child : node->GetChildren()) {
+    ShiftNode(child, delta);
+  }
+}
+
+bool IsBefore(const SyncPoint& sync_point, int position) {
+  return sync_point.position < position;
+}
+
+bool Intersects(const ParseTreeNode& node, int begin, int end) {
+  return node.Start() < end && begin < node.End();
+}
+
+void CollectNodesInRange(const ParseTreeNode& node, int begin, int end,
+                         std::vector<const ParseTreeNode*>* nodes) {
+  nodes->push_back(&node);
+
+  // Ends of the children are sorted as well since they do not overlap.
+  const ParseTreeNode::Children& children = node.GetChildren();
+  auto itr = std::partition_point(
+      children.begin(), children.end(),
+      [begin](const ParseTreeNode* child) { return child->End() <= begin; });
+  for (; itr != children.end() && (*itr)->Start() < end; ++itr) {
+    CollectNodesInRange(**itr, begin, end, nodes);
+  }
+}
+
+// Finds the reference boxes (```ref-name) of the names under the node. The
+// boxes are visited in the order that the parser registers them (the nested
+// box comes before the box that contains it), so the later one wins.
+void FindReferenceBoxes(ParseTreeNode* node, std::string_view content,
+                        const std::unordered_set<std::string>& names,
+                        RefContainer* refs) {
+  for (ParseTreeNode* child : node->GetChildren()) {
+    FindReferenceBoxes(child, content, names, refs);
+  }
+
+  if (node->GetNodeType() != ParseTreeNode::BOX) {
+    return;
+  }
+
+  const ParseTreeNode* name_node = node->GetChildren().front();
+  std::string_view box_name = content.substr(
+      name_node->Start(), name_node->End() - name_node->Start());
+  if (box_name.substr(0, 4) != "ref-" || box_name.size() <= 4) {
+    return;
+  }
+
+  if (std::string name(box_name.substr(4)); names.count(name)) {
+    (*refs)[std::move(name)] = node;
+  }
+}
+
+}  // namespace
 
 ParseTreeNode* ParseTree::FindReferenceNode(std::string_view name) const {
   if (auto itr = refs_.find(std::string(name)); itr != refs_.end()) {
@@ -10,4 +78,165 @@ ParseTreeNode* ParseTree::FindReferenceNode(std::string_view name) const {
   return nullptr;
 }
 
+const ParseTreeNode* ParseTree::NodeAt(int offset) const {
+  if (root_ == nullptr || offset < root_->Start() || offset >= root_->End()) {
+    return nullptr;
+  }
+
+  const ParseTreeNode* node = root_;
+  while (const ParseTreeNode* child = node->GetChildAt(offset)) {
+    node = child;
+  }
+  return node;
+}
+
+std::vector<const ParseTreeNode*> ParseTree::NodesInRange(int begin,
+                                                          int end) const {
+  std::vector<const ParseTreeNode*> nodes;
+  if (root_ != nullptr && begin < end && Intersects(*root_, begin, end)) {
+    CollectNodesInRange(*root_, begin, end, &nodes);
+  }
+  return nodes;
+}
+
+std::unique_ptr<Arena> ParseTree::ReleaseArena() && {
+  root_ = nullptr;
+  refs_.clear();
+  sync_points_.clear();
+
+  std::unique_ptr<Arena> arena = std::move(arena_);
+  if (arena != nullptr) {
+    arena->Reset();
+  }
+  return arena;
+}
+
+void ParseTree::ApplyEdit(const TextEdit& edit, std::string_view content,
+                          Parser* parser) {
+  if (sync_points_.empty()) {
+    std::unique_ptr<Arena> arena = std::move(*this).ReleaseArena();
+    *this = parser->GenerateParseTree(content, std::move(arena));
+    return;
+  }
+
+  const int delta = edit.new_end - edit.old_end;
+
+  // Resume from the last sync point that was reached without looking at the
+  // edited text. Note that the first sync point (the start of the content) is
+  // always such.
+  auto resume = std::partition_point(
+                    sync_points_.begin(), sync_points_.end(),
+                    [&edit](const SyncPoint& sync_point) {
+                      return sync_point.read_end <= edit.start;
+                    }) -
+                1;
+  const SyncPoint begin = *resume;
+
+  // Once the parser reaches the old sync point after the edit, the rest of the
+  // content is parsed exactly as before.
+  auto old_after_edit = std::lower_bound(resume, sync_points_.end(),
+                                         edit.old_end, IsBefore);
+  std::function<bool(size_t)> stop_at = [&](size_t position) {
+    if (static_cast<int>(position) < edit.new_end) {
+      return false;
+    }
+
+    auto old = std::lower_bound(old_after_edit, sync_points_.end(),
+                                static_cast<int>(position) - delta, IsBefore);
+    return old != sync_points_.end() &&
+           old->position == static_cast<int>(position) - delta;
+  };
+
+  // Indexing the entire content would cost as much as parsing it, so only the
+  // blocks that are expected to be parsed again (up to the first old sync
+  // point after the edit) are indexed.
+  const size_t expected_end =
+      old_after_edit != sync_points_.end()
+          ? static_cast<size_t>(old_after_edit->position + delta)
+          : content.size();
+  const StructuralIndex structural_index(content, begin.position,
+                                         expected_end);
+
+  auto* blocks = ParseTreeNode::Create<ParseTreeNode>(
+      arena_.get(), /*parent=*/nullptr, begin.position);
+  RefContainer new_refs;
+  std::vector<SyncPoint> new_sync_points;
+  const int end = static_cast<int>(parser->ParseTopLevel(
+      content, &structural_index, arena_.get(), begin.position,
+      begin.read_end, blocks, &new_refs, &new_sync_points, stop_at));
+
+  // Replaced part of the old text is [begin.position, old_end).
+  const bool stopped = !new_sync_points.empty() &&
+                       new_sync_points.back().position == end && stop_at(end);
+  const int old_end = stopped ? end - delta : std::numeric_limits<int>::max();
+
+  // The reference may be still defined in the blocks that are kept.
+  std::unordered_set<std::string> erased_refs;
+  for (auto itr = refs_.begin(); itr != refs_.end();) {
+    const int start = itr->second->Start();
+    if (begin.position <= start && start < old_end) {
+      erased_refs.insert(itr->first);
+      itr = refs_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+
+  ParseTreeNode::Children& children = root_->GetChildren();
+  auto first = std::partition_point(
+      children.begin(), children.end(), [&begin](const ParseTreeNode* child) {
+        return child->Start() < begin.position;
+      });
+  auto last = std::partition_point(first, children.end(),
+                                   [old_end](const ParseTreeNode* child) {
+                                     return child->Start() < old_end;
+                                   });
+
+  for (auto itr = last; itr != children.end(); ++itr) {
+    ShiftNode(*itr, delta);
+  }
+
+  for (ParseTreeNode* block : blocks->GetChildren()) {
+    if (block->GetParent() == blocks) {
+      block->SetParent(root_);
+    }
+  }
+  first = children.erase(first, last);
+  children.insert(first, blocks->GetChildren().begin(),
+                  blocks->GetChildren().end());
+  // Note that the parser may stop before the end of the content (e.g at the
+  // stray end of the box).
+  root_->SetEnd(stopped ? root_->End() + delta : end);
+
+  if (!erased_refs.empty()) {
+    FindReferenceBoxes(root_, content, erased_refs, &refs_);
+  }
+
+  // The later definition of the same reference wins.
+  for (auto& [name, node] : new_refs) {
+    auto [itr, inserted] = refs_.try_emplace(name, node);
+    if (!inserted && itr->second->Start() < node->Start()) {
+      itr->second = node;
+    }
+  }
+
+  std::vector<SyncPoint> sync_points(sync_points_.begin(), resume + 1);
+  sync_points.insert(sync_points.end(), new_sync_points.begin(),
+                     new_sync_points.end());
+  if (stopped) {
+    const int read_end = new_sync_points.back().read_end;
+    auto old = std::upper_bound(
+        old_after_edit, sync_points_.end(), old_end,
+        [](int position, const SyncPoint& sync_point) {
+          return position < sync_point.position;
+        });
+    for (; old != sync_points_.end(); ++old) {
+      sync_points.push_back(
+          SyncPoint{.position = old->position + delta,
+                    .read_end = std::max(old->read_end + delta, read_end)});
+    }
+  }
+  sync_points_ = std::move(sync_points);
+}
+
 }  // namespace md2
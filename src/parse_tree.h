@@ -3,30 +3,99 @@
 
 #include <list>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "arena.h"
 #include "parse_tree_nodes/node.h"
 
 namespace md2 {
 
+class Parser;
+
+// Edit of the text: [start, old_end) of the old text is replaced with
+// [start, new_end) of the new text.
+struct TextEdit {
+  int start;
+  int old_end;
+  int new_end;
+};
+
+// Position where the parser is at the top level with nothing open (i.e right
+// after the blank line that ends the paragraph). Parsing from here does not
+// depend on the text before it.
+struct SyncPoint {
+  int position;
+
+  // Parsing the text before the position looked at the text up to here (not
+  // included). E.g the unclosed "$$" looks at the rest of the text to find the
+  // closing "$$".
+  int read_end;
+};
+
 class ParseTree {
  public:
-  ParseTree(std::unique_ptr<ParseTreeNode> root,
-            std::unordered_map<std::string, ParseTreeNode*>&& refs)
-      : root_(std::move(root)), refs_(std::move(refs)) {}
+  // Every node of the tree must be allocated from the arena.
+  ParseTree(std::unique_ptr<Arena> arena, ParseTreeNode* root,
+            std::unordered_map<std::string, ParseTreeNode*>&& refs,
+            std::vector<SyncPoint> sync_points = {})
+      : arena_(std::move(arena)),
+        root_(root),
+        refs_(std::move(refs)),
+        sync_points_(std::move(sync_points)) {}
+
+  ParseTree(ParseTree&&) = default;
+  ParseTree& operator=(ParseTree&&) = default;
 
-  const ParseTreeNode* GetRoot() const { return root_.get(); }
+  const ParseTreeNode* GetRoot() const { return root_; }
+  const Arena* GetArena() const { return arena_.get(); }
   void Print() const { root_->Print(); }
 
   // Returns nullptr if not found.
   ParseTreeNode* FindReferenceNode(std::string_view name) const;
 
+  const std::unordered_map<std::string, ParseTreeNode*>& GetReferences() const {
+    return refs_;
+  }
+
+  const std::vector<SyncPoint>& GetSyncPoints() const { return sync_points_; }
+
+  // Returns the deepest node whose span contains the offset, or nullptr if the
+  // offset is out of the tree. Since the children of every node are sorted
+  // by the position, each level is a binary search (and nothing has to be
+  // rebuilt after ApplyEdit).
+  const ParseTreeNode* NodeAt(int offset) const;
+
+  // Returns every node whose span intersects [begin, end) in the pre-order
+  // (so the ancestors come before the descendants). Empty if begin >= end.
+  std::vector<const ParseTreeNode*> NodesInRange(int begin, int end) const;
+
+  // Destroys the tree and returns the (reset) arena so that it can be reused
+  // for the next document.
+  std::unique_ptr<Arena> ReleaseArena() &&;
+
+  // Updates the tree to the edited content. Only the top level blocks (e.g
+  // the paragraph or the box between the blank lines) that the edit can affect
+  // are parsed again. The rest of the tree is reused as is, with its offsets
+  // shifted. The result is identical to parsing the whole new content.
+  //
+  // Note that the replaced nodes stay in the arena until the tree is released.
+  void ApplyEdit(const TextEdit& edit, std::string_view content,
+                 Parser* parser);
+
  private:
-  std::unique_ptr<ParseTreeNode> root_;
+  // Owns every node in the tree. The tree is freed at once when the arena is
+  // destroyed.
+  std::unique_ptr<Arena> arena_;
+  ParseTreeNode* root_;
 
   // References that are identified by the name.
   std::unordered_map<std::string, ParseTreeNode*> refs_;
+
+  // Sorted by the position. Empty if the tree does not support ApplyEdit.
+  std::vector<SyncPoint> sync_points_;
 };
 
 }  // namespace md2
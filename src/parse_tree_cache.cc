@@ -0,0 +1,68 @@
+#include "parse_tree_cache.h"
+
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include "hash.h"
+#include "logger.h"
+#include "mapped_file.h"
+#include "output_writer.h"
+
+namespace md2 {
+
+ParseTreeCache::ParseTreeCache(std::string dir) : dir_(std::move(dir)) {
+  std::error_code ec;
+  std::filesystem::create_directories(dir_, ec);
+  if (ec) {
+    LOG(0) << "Unable to create the parse tree cache " << dir_ << " : "
+           << ec.message();
+  }
+}
+
+std::string ParseTreeCache::Key(std::string_view content) {
+  return GenerateSha256Hash(content).value_or("");
+}
+
+std::optional<ParseTree> ParseTreeCache::Load(
+    std::string_view key, std::unique_ptr<Arena>* arena) const {
+  if (key.empty()) {
+    return std::nullopt;
+  }
+
+  // Missing file is the common case (not an error).
+  const std::string path = GetPath(key);
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) {
+    return std::nullopt;
+  }
+
+  std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+  if (file == nullptr) {
+    return std::nullopt;
+  }
+
+  // The mapping is only needed while the nodes are created.
+  std::optional<ParseTree> tree =
+      FlatParseTree::DeserializeParseTree(file->Content(), arena);
+  if (!tree) {
+    LOG(1) << "Ignoring the stale or corrupted parse tree " << path;
+  }
+  return tree;
+}
+
+bool ParseTreeCache::Store(std::string_view key, const ParseTree& tree) const {
+  if (key.empty()) {
+    return false;
+  }
+
+  return OutputWriter::WriteFileIfChanged(
+             GetPath(key), FlatParseTree(tree).Serialize()) !=
+         OutputWriter::FAILED;
+}
+
+std::string ParseTreeCache::GetPath(std::string_view key) const {
+  return (std::filesystem::path(dir_) / (std::string(key) + ".tree")).string();
+}
+
+}  // namespace md2
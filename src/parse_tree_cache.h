@@ -0,0 +1,45 @@
+#ifndef PARSE_TREE_CACHE_H
+#define PARSE_TREE_CACHE_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "flat_parse_tree.h"
+#include "parse_tree.h"
+
+namespace md2 {
+
+// Parse trees that are stored on the disk in the binary format of
+// FlatParseTree, keyed by the hash of the content. The parser is deterministic,
+// so the content that is seen before does not have to be parsed again.
+//
+// Each tree is stored at dir/<key>.tree and is replaced atomically, so the
+// cache can be shared by multiple processes.
+class ParseTreeCache {
+ public:
+  explicit ParseTreeCache(std::string dir);
+
+  // Key of the content. Empty if the hash could not be computed (then the
+  // content is not cached).
+  static std::string Key(std::string_view content);
+
+  // Returns nullopt if the tree is not cached (or is of the old version). The
+  // tree is built in the given arena, which is taken only if the tree is
+  // loaded.
+  std::optional<ParseTree> Load(std::string_view key,
+                                std::unique_ptr<Arena>* arena) const;
+
+  // Returns false if the tree could not be stored.
+  bool Store(std::string_view key, const ParseTree& tree) const;
+
+ private:
+  std::string GetPath(std::string_view key) const;
+
+  std::string dir_;
+};
+
+}  // namespace md2
+
+#endif
@@ -7,10 +7,9 @@ namespace md2 {
 
 class ParseTreeBoxNode : public ParseTreeNode {
  public:
-  ParseTreeBoxNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::BOX; }
+  ParseTreeBoxNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                   int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::BOX) {}
 };
 
 }  // namespace md2
@@ -8,15 +8,18 @@ namespace md2 {
 // Node for escaped character. (e.g \*).
 class ParseTreeCommandNode : public ParseTreeNode {
  public:
-  ParseTreeCommandNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
+  ParseTreeCommandNode(std::pmr::memory_resource* resource,
+                       ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::COMMAND) {}
 
-  NodeType GetNodeType() const override { return ParseTreeNode::COMMAND; }
-  void SetCommandName(std::string_view command_name) { command_name_ = command_name; }
+  void SetCommandName(std::string_view command_name) {
+    command_name_ = command_name;
+  }
   std::string_view GetCommandName() const { return command_name_; }
 
  private:
-  std::string command_name_;
+  // Points to the static command table in the parser.
+  std::string_view command_name_;
 };
 
 }  // namespace md2
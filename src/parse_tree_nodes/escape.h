@@ -8,10 +8,10 @@ namespace md2 {
 // Node for escaped character. (e.g \*).
 class ParseTreeEscapeNode : public ParseTreeNode {
  public:
-  ParseTreeEscapeNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start, /*is_leaf_node=*/true) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::ESCAPE; }
+  ParseTreeEscapeNode(std::pmr::memory_resource* resource,
+                      ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::ESCAPE,
+                      /*is_leaf_node=*/true) {}
 };
 
 }  // namespace md2
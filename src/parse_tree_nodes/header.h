@@ -7,10 +7,9 @@ namespace md2 {
 
 class ParseTreeHeaderNode : public ParseTreeNode {
  public:
-  ParseTreeHeaderNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::HEADER; }
+  ParseTreeHeaderNode(std::pmr::memory_resource* resource,
+                      ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::HEADER) {}
 
   enum HeaderTypes {
     NORMAL_HEADER,
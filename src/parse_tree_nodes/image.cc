@@ -9,21 +9,17 @@ namespace md2 {
 namespace {}  // namespace
 
 void ParseTreeImageNode::SetKeywordNodes(
-    std::unordered_map<std::string, std::unique_ptr<ParseTreeNode>>&
-        nodes_per_keyword) {
+    std::unordered_map<std::string_view, ParseTreeNode*>& nodes_per_keyword) {
   // Image description node.
-  ParseTreeNode* desc_node = children_[0].get();
+  ParseTreeNode* desc_node = children_[0];
   MD2_ASSERT(desc_node->GetNodeType() == ParseTreeNode::NODE, "");
 
-  ParseTreeNode* desc = desc_node->GetChildren()[0].get();
+  ParseTreeNode* desc = desc_node->GetChildren()[0];
   MD2_ASSERT(desc->GetNodeType() == ParseTreeNode::TEXT, "");
 
-  std::vector<std::pair<std::unique_ptr<ParseTreeNode>, std::string>>
-      nodes_and_keyword;
-
+  std::vector<std::pair<ParseTreeNode*, std::string_view>> nodes_and_keyword;
   for (auto& [keyword, keyword_node] : nodes_per_keyword) {
-    nodes_and_keyword.push_back(
-        std::make_pair(std::move(keyword_node), keyword));
+    nodes_and_keyword.push_back(std::make_pair(keyword_node, keyword));
   }
 
   // Now sort keyword nodes by the starting index.
@@ -33,9 +29,25 @@ void ParseTreeImageNode::SetKeywordNodes(
             });
 
   for (auto& [keyword_node, keyword] : nodes_and_keyword) {
-    desc->AddChildren(std::move(keyword_node));
-    keyword_to_index_[keyword] = desc->GetChildren().size() - 1;
+    desc->AddChildren(keyword_node);
+    AddKeywordIndex(keyword, desc->GetChildren().size() - 1);
   }
 }
 
+void ParseTreeImageNode::AddKeywordIndex(std::string_view keyword, int index) {
+  MD2_ASSERT(num_keywords_ < kMaxKeywords, "Too many image keywords");
+  keyword_to_index_[num_keywords_++] = std::make_pair(keyword, index);
+}
+
+std::optional<int> ParseTreeImageNode::GetKeywordIndex(
+    std::string_view keyword) const {
+  for (size_t i = 0; i < num_keywords_; i++) {
+    if (keyword_to_index_[i].first == keyword) {
+      return keyword_to_index_[i].second;
+    }
+  }
+
+  return std::nullopt;
+}
+
 }  // namespace md2
@@ -1,32 +1,45 @@
 #ifndef PARSE_TREE_IMAGE_H
 #define PARSE_TREE_IMAGE_H
 
+#include <array>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
 #include "node.h"
 
 namespace md2 {
 
 class ParseTreeImageNode : public ParseTreeNode {
  public:
-  ParseTreeImageNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
+  ParseTreeImageNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                     int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::IMAGE) {}
 
-  NodeType GetNodeType() const override { return ParseTreeNode::IMAGE; }
+  // Maximum number of the keywords in the image description (alt, caption
+  // and size).
+  static constexpr size_t kMaxKeywords = 3;
 
+  // Note that the keywords must outlive the node.
   void SetKeywordNodes(
-      std::unordered_map<std::string, std::unique_ptr<ParseTreeNode>>&
-          nodes_per_keyword);
+      std::unordered_map<std::string_view, ParseTreeNode*>& nodes_per_keyword);
+
+  // Returns the index of the node of the keyword in the image description's
+  // children vector. Returns nullopt if the keyword is not specified.
+  std::optional<int> GetKeywordIndex(std::string_view keyword) const;
 
-  const std::unordered_map<std::string, int>& GetKeywordToIndex() const {
-    return keyword_to_index_;
-  }
+  // Registers the index of the keyword node that is already in the image
+  // description.
+  void AddKeywordIndex(std::string_view keyword, int index);
 
  private:
   // Parse the metadata in the image description.
   void ParseImageDescriptionMetadata();
 
-  // Map of image description keyword to the corresponding node's index in the
-  // Image description's children vector.
-  std::unordered_map<std::string, int> keyword_to_index_;
+  // Pairs of image description keyword and the corresponding node's index.
+  // Not a map since the node is never destroyed (see Arena).
+  std::array<std::pair<std::string_view, int>, kMaxKeywords> keyword_to_index_;
+  size_t num_keywords_ = 0;
 };
 
 }  // namespace md2
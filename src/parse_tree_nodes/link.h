@@ -8,10 +8,9 @@ namespace md2 {
 // Node for escaped character. (e.g \*).
 class ParseTreeLinkNode : public ParseTreeNode {
  public:
-  ParseTreeLinkNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::LINK; }
+  ParseTreeLinkNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                    int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::LINK) {}
 };
 
 }  // namespace md2
@@ -7,8 +7,7 @@ void ParseTreeListNode ::SetListItemIndexes() {
   for (auto& child : GetChildren()) {
     if (child->GetNodeType() == ParseTreeNode::LIST_ITEM ||
         child->GetNodeType() == ParseTreeNode::ORDERED_LIST_ITEM) {
-      ParseTreeListItemNode* list_item =
-          dynamic_cast<ParseTreeListItemNode*>(child.get());
+      auto* list_item = static_cast<ParseTreeListItemNode*>(child);
       list_item->SetListIndex(index++);
     }
   }
@@ -7,15 +7,12 @@ namespace md2 {
 
 class ParseTreeListNode : public ParseTreeNode {
  public:
-  ParseTreeListNode(ParseTreeNode* parent, int start, bool is_ordered)
-      : ParseTreeNode(parent, start), is_ordered_(is_ordered) {}
-
-  NodeType GetNodeType() const override {
-    if (is_ordered_) {
-      return ParseTreeNode::ORDERED_LIST;
-    }
-    return ParseTreeNode::LIST;
-  }
+  ParseTreeListNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                    int start, bool is_ordered)
+      : ParseTreeNode(resource, parent, start,
+                      is_ordered ? ParseTreeNode::ORDERED_LIST
+                                 : ParseTreeNode::LIST),
+        is_ordered_(is_ordered) {}
 
   constexpr bool IsOrdered() const { return is_ordered_; }
 
@@ -27,16 +24,12 @@ class ParseTreeListNode : public ParseTreeNode {
 
 class ParseTreeListItemNode : public ParseTreeNode {
  public:
-  ParseTreeListItemNode(ParseTreeNode* parent, int start, bool is_ordered)
-      : ParseTreeNode(parent, start), is_ordered_(is_ordered) {}
-
-  NodeType GetNodeType() const override {
-    if (is_ordered_) {
-      return ParseTreeNode::ORDERED_LIST_ITEM;
-    }
-
-    return ParseTreeNode::LIST_ITEM;
-  }
+  ParseTreeListItemNode(std::pmr::memory_resource* resource,
+                        ParseTreeNode* parent, int start, bool is_ordered)
+      : ParseTreeNode(resource, parent, start,
+                      is_ordered ? ParseTreeNode::ORDERED_LIST_ITEM
+                                 : ParseTreeNode::LIST_ITEM),
+        is_ordered_(is_ordered) {}
 
   void SetListDepth(int list_depth) { list_depth_ = list_depth; }
   constexpr int GetListDepth() const { return list_depth_; }
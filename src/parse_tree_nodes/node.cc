@@ -1,5 +1,6 @@
 #include "node.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "../logger.h"
@@ -30,41 +31,44 @@ std::unordered_map<ParseTreeNode::NodeType, std::string_view> kNodeTypeToName =
         {ParseTreeNode::QUOTE, "QUOTE"},
 };
 
-std::unique_ptr<ParseTreeNode> ParseTreeNode::PopChildrenAt(int index) {
-  std::unique_ptr<ParseTreeNode> child = std::move(children_[index]);
+ParseTreeNode* ParseTreeNode::PopChildrenAt(int index) {
+  ParseTreeNode* child = children_[index];
   children_.erase(children_.begin() + index);
 
   return child;
 }
 
 ParseTreeNode* ParseTreeNode::GetNext(int pos) const {
-  for (auto& child : children_) {
-    if (pos <= child->Start()) {
-      return child.get();
-    }
-  }
-
-  return nullptr;
+  const size_t index = GetNextChildIndex(pos);
+  return index < children_.size() ? children_[index] : nullptr;
 }
 
 int ParseTreeNode::GetNextChildIndex(int pos) const {
-  for (size_t i = 0; i < children_.size(); i++) {
-    // Return the first element whose Start() covers current index.
-    if (pos <= children_[i]->Start()) {
-      return i;
-    }
+  auto itr = std::partition_point(
+      children_.begin(), children_.end(),
+      [pos](const ParseTreeNode* child) { return child->Start() < pos; });
+  return itr - children_.begin();
+}
+
+ParseTreeNode* ParseTreeNode::GetChildAt(int pos) const {
+  // The last child that starts at or before pos.
+  auto itr = std::partition_point(
+      children_.begin(), children_.end(),
+      [pos](const ParseTreeNode* child) { return child->Start() <= pos; });
+  if (itr == children_.begin() || pos >= (*(itr - 1))->End()) {
+    return nullptr;
   }
 
-  return children_.size();
+  return *(itr - 1);
 }
 
 void ParseTreeNode::AddChildBefore(ParseTreeNode* node_to_find,
-                                   std::unique_ptr<ParseTreeNode> child) {
-  for (size_t i = 0; i < children_.size(); i++) {
-    if (children_[i].get() == node_to_find) {
-      children_.insert(children_.begin() + i, std::move(child));
-      return;
-    }
+                                   ParseTreeNode* child) {
+  // The node is almost always the last child (e.g the paragraph that is being
+  // parsed), so search from the back.
+  auto itr = std::find(children_.rbegin(), children_.rend(), node_to_find);
+  if (itr != children_.rend()) {
+    children_.insert(itr.base() - 1, child);
   }
 }
 
@@ -1,18 +1,30 @@
 #ifndef PARSE_TREE_NODE_H
 #define PARSE_TREE_NODE_H
 
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
+#include <memory_resource>
 #include <vector>
 
+#include "arena.h"
 #include "md2_assert.h"
 
 namespace md2 {
 
+// Nodes are allocated from the Arena of the parse tree (see Create) and are
+// never destroyed individually; The child nodes are owned by the arena, not
+// by the parent node.
+//
+// The node type is stored inline (instead of being a virtual function of the
+// node class) so that dispatching on the node type does not need a virtual
+// call, and the node does not need a vtable.
 class ParseTreeNode {
  public:
-  enum NodeType {
+  using Children = std::pmr::vector<ParseTreeNode*>;
+
+  enum NodeType : uint8_t {
     NODE,
     PARAGRAPH,
     TEXT,
@@ -36,35 +48,46 @@ class ParseTreeNode {
     QUOTE
   };
 
-  ParseTreeNode(ParseTreeNode* parent, int start, bool is_leaf_node = false)
-      : parent_(parent), start_(start), is_leaf_node_(is_leaf_node) {}
+  // The children list is allocated from the resource.
+  ParseTreeNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                int start, NodeType type = NODE, bool is_leaf_node = false)
+      : children_(resource),
+        parent_(parent),
+        start_(start),
+        type_(type),
+        is_leaf_node_(is_leaf_node) {}
+
+  // Creates the node in the arena. The children list of the node is allocated
+  // from the arena as well.
+  template <typename NodeType, typename... Args>
+  static NodeType* Create(Arena* arena, Args&&... args) {
+    return arena->Create<NodeType>(arena, std::forward<Args>(args)...);
+  }
 
-  virtual NodeType GetNodeType() const { return NODE; }
+  constexpr NodeType GetNodeType() const { return type_; }
   void SetStart(int start) { start_ = start; }
   void SetEnd(int end) { end_ = end; }
 
-  // Override in case adding a children is not valid.
-  void AddChildren(std::unique_ptr<ParseTreeNode> child) {
+  void AddChildren(ParseTreeNode* child) {
     if (is_leaf_node_) {
       MD2_ASSERT(false, "This node is the leaf node.");
       return;
     }
 
-    children_.push_back(std::move(child));
+    children_.push_back(child);
   }
 
-  void AddChildrenFront(std::unique_ptr<ParseTreeNode> child) {
+  void AddChildrenFront(ParseTreeNode* child) {
     if (is_leaf_node_) {
       MD2_ASSERT(false, "This node is the leaf node.");
       return;
     }
 
-    children_.insert(children_.begin(), std::move(child));
+    children_.insert(children_.begin(), child);
   }
 
   // Add a child node right before node_to_find.
-  void AddChildBefore(ParseTreeNode* node_to_find,
-                      std::unique_ptr<ParseTreeNode> child);
+  void AddChildBefore(ParseTreeNode* node_to_find, ParseTreeNode* child);
 
   void SetParent(ParseTreeNode* parent) { parent_ = parent; }
   constexpr ParseTreeNode* GetParent() const { return parent_; }
@@ -73,38 +96,36 @@ class ParseTreeNode {
       return nullptr;
     }
 
-    return children_.back().get();
+    return children_.back();
   }
 
-  constexpr const std::vector<std::unique_ptr<ParseTreeNode>>& GetChildren()
-      const {
-    return children_;
-  }
+  const Children& GetChildren() const { return children_; }
+  Children& GetChildren() { return children_; }
 
-  std::vector<std::unique_ptr<ParseTreeNode>>& GetChildren() {
-    return children_;
-  }
-
-  std::unique_ptr<ParseTreeNode> PopChildrenAt(int index);
+  ParseTreeNode* PopChildrenAt(int index);
 
   constexpr int Size() const { return end_ - start_; }
   constexpr int Start() const { return start_; }
   constexpr int End() const { return end_; }
 
-  // Given index, return the TreeNode that contains the pos in its span. If
-  // there is no such, then this returns a nullptr.
+  // Children are sorted by the position and do not overlap, so the lookups
+  // below are binary searches.
+
+  // Returns the first child that starts at or after pos. If there is no such,
+  // then this returns a nullptr.
   ParseTreeNode* GetNext(int pos) const;
 
   // Same as GetNext but returns the index of the child node instead. If there
   // is no such node, then this returns the children_.size().
   int GetNextChildIndex(int pos) const;
 
-  virtual ~ParseTreeNode() = default;
+  // Returns the child that contains pos in its span (or nullptr).
+  ParseTreeNode* GetChildAt(int pos) const;
 
   void Print(int depth = 0) const;
 
  protected:
-  std::vector<std::unique_ptr<ParseTreeNode>> children_;
+  Children children_;
 
   ParseTreeNode* parent_;
 
@@ -112,6 +133,8 @@ class ParseTreeNode {
   int start_;
   int end_;
 
+  NodeType type_;
+
   // If this is true, then the node cannot have any child node.
   bool is_leaf_node_;
 };
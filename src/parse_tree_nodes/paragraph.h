@@ -8,19 +8,17 @@ namespace md2 {
 // This node represents the single paragraph.
 class ParseTreeParagraphNode : public ParseTreeNode {
  public:
-  ParseTreeParagraphNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::PARAGRAPH; }
+  ParseTreeParagraphNode(std::pmr::memory_resource* resource,
+                         ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::PARAGRAPH) {}
 };
 
 // This node represents the simple text (not part of the paragraph).
 class ParseTreeTextNode : public ParseTreeNode {
  public:
-  ParseTreeTextNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::TEXT; }
+  ParseTreeTextNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                    int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::TEXT) {}
 };
 
 }  // namespace md2
@@ -7,10 +7,9 @@ namespace md2 {
 
 class ParseTreeQuoteNode : public ParseTreeNode {
  public:
-  ParseTreeQuoteNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::QUOTE; }
+  ParseTreeQuoteNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                     int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::QUOTE) {}
 };
 
 }  // namespace md2
@@ -9,15 +9,15 @@ namespace md2 {
 
 class ParseTreeTableNode : public ParseTreeNode {
  public:
-  ParseTreeTableNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::TABLE; }
+  ParseTreeTableNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                     int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::TABLE) {}
 
   // The number of current children will be set as the row size.
   // Will be only set once.
   void SetRowSizeIfNotSpecified();
 
+  void SetColSize(int col_size) { col_size_ = col_size; }
   constexpr int GetColSize() const { return col_size_; }
 
  private:
@@ -7,44 +7,37 @@ namespace md2 {
 
 class ParseTreeBoldNode : public ParseTreeNode {
  public:
-  ParseTreeBoldNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::BOLD; }
+  ParseTreeBoldNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                    int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::BOLD) {}
 };
 
 class ParseTreeItalicNode : public ParseTreeNode {
  public:
-  ParseTreeItalicNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::ITALIC; }
+  ParseTreeItalicNode(std::pmr::memory_resource* resource,
+                      ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::ITALIC) {}
 };
 
 class ParseTreeStrikeThroughNode : public ParseTreeNode {
  public:
-  ParseTreeStrikeThroughNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override {
-    return ParseTreeNode::STRIKE_THROUGH;
-  }
+  ParseTreeStrikeThroughNode(std::pmr::memory_resource* resource,
+                             ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::STRIKE_THROUGH) {}
 };
 
 class ParseTreeMathNode : public ParseTreeNode {
  public:
-  ParseTreeMathNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::MATH; }
+  ParseTreeMathNode(std::pmr::memory_resource* resource, ParseTreeNode* parent,
+                    int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::MATH) {}
 };
 
 class ParseTreeNewlineMathNode : public ParseTreeNode {
  public:
-  ParseTreeNewlineMathNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::MATH_NEWLINE; }
+  ParseTreeNewlineMathNode(std::pmr::memory_resource* resource,
+                           ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::MATH_NEWLINE) {}
 };
 
 }  // namespace md2
@@ -7,10 +7,9 @@ namespace md2 {
 
 class ParseTreeVerbatimNode : public ParseTreeNode {
  public:
-  ParseTreeVerbatimNode(ParseTreeNode* parent, int start)
-      : ParseTreeNode(parent, start) {}
-
-  NodeType GetNodeType() const override { return ParseTreeNode::VERBATIM; }
+  ParseTreeVerbatimNode(std::pmr::memory_resource* resource,
+                        ParseTreeNode* parent, int start)
+      : ParseTreeNode(resource, parent, start, ParseTreeNode::VERBATIM) {}
 };
 
 }  // namespace md2
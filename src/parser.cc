@@ -1,8 +1,11 @@
 #include "parser.h"
 
+#include <algorithm>
 #include <cctype>
-#include <unordered_set>
+#include <cstdint>
 #include <optional>
+#include <unordered_map>
+#include <utility>
 
 #include "logger.h"
 #include "parse_tree_nodes/box.h"
@@ -17,43 +20,55 @@
 #include "parse_tree_nodes/table.h"
 #include "parse_tree_nodes/text_decoration.h"
 #include "parse_tree_nodes/verbatim.h"
+#include "static_set.h"
 
 namespace md2 {
 namespace {
 
-static std::unordered_set<char> kEscapeableChars = {'*', '`', '\\',
-                                                    '|', '{', '}'};
+constexpr CharSet kEscapeableChars("*`\\|{}");
 
 // Box names that should be always treated as verbatim (nested not allowed).
-static std::unordered_set<std::string> kVerbatimBoxNames = {
-    "cpp",           "py",        "asm",
-    "cpp-formatted", "embed",     "compiler-warning",
-    "info",          "info-verb", "info-term",
-    "info-format",   "exec",      "objdump",
-    "rust"};
+constexpr auto kVerbatimBoxNames = MakeStaticStringSet(
+    {"cpp", "py", "asm", "cpp-formatted", "embed", "compiler-warning", "info",
+     "info-verb", "info-term", "info-format", "exec", "objdump", "rust"});
 
 // "alt" is not here because alt text is just a default when no xxx= is
 // specified.
-static std::unordered_set<std::string> kImageDescKeywords = {"caption", "size"};
-
-static std::unordered_map<std::string, int> kCommandToNumArgs = {
-    {"sidenote", 1}, {"sc", 1},        {"newline", 1},  {"serif", 1},
-    {"htmlonly", 1}, {"latexonly", 1}, {"footnote", 1}, {"esc", 1},
-    {"tooltip", 2},  {"ref", 1}};
-
-// Commands that take verbatim stuff in the argument (should not parse whatever
-// that's inside {}) and the index of those args.
-static std::unordered_map<std::string, std::unordered_set<size_t>>
-    kVerbatimCommands = {{"htmlonly", {0}}, {"tooltip", {1}}, {"ref", {0}}};
-
-// Create a new node that starts at the given parameter.
-template <typename NewNodeType>
-ParseTreeNode* CreateNewNode(ParseTreeNode* current_node, size_t start) {
-  auto p_node = std::make_unique<NewNodeType>(current_node, start);
-  current_node->AddChildren(std::move(p_node));
-  current_node = current_node->GetLastChildren();
-
-  return current_node;
+constexpr std::string_view kImageDescKeywords[] = {"caption", "size"};
+
+struct CommandInfo {
+  int num_args;
+
+  // Bit i is set if the i-th argument is verbatim (i.e should not parse
+  // whatever that's inside {}).
+  uint32_t verbatim_args;
+};
+
+constexpr auto kCommands = MakeStaticStringMap<CommandInfo>({
+    {"sidenote", {1, 0}},
+    {"sc", {1, 0}},
+    {"newline", {1, 0}},
+    {"serif", {1, 0}},
+    {"htmlonly", {1, 0b01}},
+    {"latexonly", {1, 0}},
+    {"footnote", {1, 0}},
+    {"esc", {1, 0}},
+    {"tooltip", {2, 0b10}},
+    {"ref", {1, 0b01}},
+});
+
+constexpr size_t kMaxCommandNameSize = kCommands.MaxKeySize();
+
+// Returns the end of the text that the parser may look at while it is at the
+// index (other than the delimiter search). None of the lookaheads goes beyond
+// the next line (e.g the list checks whether the next line starts a new list).
+size_t LookaheadEnd(std::string_view content, size_t index) {
+  size_t line_end = content.find('\n', index);
+  if (line_end != std::string_view::npos) {
+    line_end = content.find('\n', line_end + 1);
+  }
+  return line_end == std::string_view::npos ? content.size() + 1
+                                            : line_end + 1;
 }
 
 // Find the parent which is node_type.
@@ -81,18 +96,19 @@ ParseTreeNode* MarkEndAllTheWayUp(ParseTreeNode* current_node, int index) {
   return current_node;
 }
 
-std::optional<std::tuple<std::string, int>> FindDescKeywordPost(
+// Note that the returned keyword points to the one in kImageDescKeywords.
+std::optional<std::tuple<std::string_view, int>> FindDescKeywordPost(
     std::string_view data) {
-  size_t current = 0;
-  auto found = data.find("=", current);
+  auto found = data.find('=');
   while (found != std::string_view::npos) {
     for (const auto& keyword : kImageDescKeywords) {
-      if (data.substr(found - keyword.size(), keyword.size()) == keyword) {
-        return std::make_tuple(keyword, found - keyword.size());
+      if (found >= keyword.size() &&
+          data.substr(found - keyword.size(), keyword.size()) == keyword) {
+        return std::make_tuple(std::string_view(keyword),
+                               static_cast<int>(found - keyword.size()));
       }
     }
-    current++;
-    found = data.find("=", current);
+    found = data.find('=', found + 1);
   }
 
   return std::nullopt;
@@ -104,10 +120,9 @@ std::optional<std::tuple<std::string, int>> FindDescKeywordPost(
 // new keyword (=caption) will be added to nodes_per_keyword map and the newly
 // created node will be returned.
 ParseTreeNode* BuildImageKeywordNodes(
-    std::string_view content, int start_in_actual_content,
+    Arena* arena, std::string_view content, int start_in_actual_content,
     ParseTreeNode* current_keyword,
-    std::unordered_map<std::string, std::unique_ptr<ParseTreeNode>>&
-        nodes_per_keyword) {
+    std::unordered_map<std::string_view, ParseTreeNode*>& nodes_per_keyword) {
   std::string_view current_content = content;
   while (!current_content.empty()) {
     auto keyword_and_pos_or = FindDescKeywordPost(current_content);
@@ -121,9 +136,9 @@ ParseTreeNode* BuildImageKeywordNodes(
 
     // The xxxx= part is not included in the text node.
     const size_t offset_in_current_content = start_pos + keyword.size() + 1;
-    nodes_per_keyword[keyword] = std::make_unique<ParseTreeTextNode>(
-        nullptr, start_in_actual_content + offset_in_current_content);
-    current_keyword = nodes_per_keyword[keyword].get();
+    nodes_per_keyword[keyword] = ParseTreeNode::Create<ParseTreeTextNode>(
+        arena, nullptr, start_in_actual_content + offset_in_current_content);
+    current_keyword = nodes_per_keyword[keyword];
 
     current_content = current_content.substr(offset_in_current_content);
     start_in_actual_content += offset_in_current_content;
@@ -136,11 +151,12 @@ ParseTreeNode* BuildImageKeywordNodes(
 // in some cases like Header, it should be placed Outside of the paragraph node.
 //
 // Note that exising paragraph node will be placed *AFTER* added node.
-ParseTreeNode* HoistNodeAboveParagraph(ParseTreeNode* current_node,
-                                       std::unique_ptr<ParseTreeNode> node) {
+ParseTreeNode* HoistNodeAboveParagraph(Arena* arena,
+                                       ParseTreeNode* current_node,
+                                       ParseTreeNode* node) {
   if (current_node->Start() == node->Start()) {
     current_node->SetStart(node->End());
-    current_node->GetParent()->AddChildBefore(current_node, std::move(node));
+    current_node->GetParent()->AddChildBefore(current_node, node);
     return current_node;
   }
 
@@ -150,11 +166,11 @@ ParseTreeNode* HoistNodeAboveParagraph(ParseTreeNode* current_node,
 
   ParseTreeNode* parent = current_node->GetParent();
   int new_paragraph_node_start = node->End();
-  parent->AddChildren(std::move(node));
+  parent->AddChildren(node);
 
   // Create new paragraph node.
-  parent->AddChildren(std::make_unique<ParseTreeParagraphNode>(
-      parent, new_paragraph_node_start));
+  parent->AddChildren(ParseTreeNode::Create<ParseTreeParagraphNode>(
+      arena, parent, new_paragraph_node_start));
   return current_node->GetParent()->GetLastChildren();
 }
 
@@ -234,22 +250,24 @@ bool IsListItemType(const ParseTreeNode* node) {
          node->GetNodeType() == ParseTreeNode::ORDERED_LIST_ITEM;
 }
 
-int GetDepth(std::unique_ptr<ParseTreeNode>& child) {
-  MD2_ASSERT(IsListItemType(child.get()), "");
+int GetDepth(ParseTreeNode* child) {
+  MD2_ASSERT(IsListItemType(child), "");
 
-  return static_cast<ParseTreeListItemNode*>(child.get())->GetListDepth();
+  return static_cast<ParseTreeListItemNode*>(child)->GetListDepth();
 }
 
 // Construct list from list items in range [start, end). Note that end is not
 // included.
 //
-// **children** will be moved away.
-std::unique_ptr<ParseTreeListNode> ConstructListFromListItems(
-    std::vector<std::unique_ptr<ParseTreeNode>>& children, int start, int end) {
+// The list items are added to the constructed list so the caller should remove
+// them from **children**.
+ParseTreeListNode* ConstructListFromListItems(Arena* arena,
+                                              ParseTreeNode::Children& children,
+                                              int start, int end) {
   // Pair of list node and the corresponding depth.
   std::vector<std::pair<ParseTreeListNode*, int>> current_lists;
 
-  std::unique_ptr<ParseTreeListNode> top_level_list;
+  ParseTreeListNode* top_level_list = nullptr;
 
   int list_end = children[end - 1]->End();
 
@@ -259,24 +277,23 @@ std::unique_ptr<ParseTreeListNode> ConstructListFromListItems(
         current_lists.back().second < GetDepth(children[current])) {
       bool is_ordered =
           children[current]->GetNodeType() == ParseTreeNode::ORDERED_LIST_ITEM;
-      auto list = std::make_unique<ParseTreeListNode>(
-          nullptr, children[current]->Start(), is_ordered);
+      auto* list = ParseTreeNode::Create<ParseTreeListNode>(
+          arena, nullptr, children[current]->Start(), is_ordered);
       current_lists.push_back(
-          std::make_pair(list.get(), GetDepth(children[current])));
+          std::make_pair(list, GetDepth(children[current])));
 
       // Make current list item as the children of the list.
-      current_lists.back().first->AddChildren(std::move(children[current]));
+      current_lists.back().first->AddChildren(children[current]);
 
       if (current_lists.size() == 1) {
-        top_level_list = std::move(list);
+        top_level_list = list;
       } else {
         list->SetParent(current_lists[current_lists.size() - 2].first);
-        current_lists[current_lists.size() - 2].first->AddChildren(
-            std::move(list));
+        current_lists[current_lists.size() - 2].first->AddChildren(list);
       }
     } else if (current_lists.back().second == GetDepth(children[current])) {
       // Then we can just append the current list item to the list node.
-      current_lists.back().first->AddChildren(std::move(children[current]));
+      current_lists.back().first->AddChildren(children[current]);
     } else if (current_lists.back().second > GetDepth(children[current])) {
       int depth = GetDepth(children[current]);
       while (!current_lists.empty()) {
@@ -296,20 +313,19 @@ std::unique_ptr<ParseTreeListNode> ConstructListFromListItems(
       }
 
       if (current_lists.back().second == depth) {
-        current_lists.back().first->AddChildren(std::move(children[current]));
+        current_lists.back().first->AddChildren(children[current]);
       } else {
         bool is_ordered = children[current]->GetNodeType() ==
                           ParseTreeNode::ORDERED_LIST_ITEM;
-        auto list = std::make_unique<ParseTreeListNode>(
-            nullptr, children[current]->Start(), is_ordered);
+        auto* list = ParseTreeNode::Create<ParseTreeListNode>(
+            arena, nullptr, children[current]->Start(), is_ordered);
         current_lists.push_back(
-            std::make_pair(list.get(), GetDepth(children[current])));
+            std::make_pair(list, GetDepth(children[current])));
 
         // Make current list item as the children of the list.
-        current_lists.back().first->AddChildren(std::move(children[current]));
+        current_lists.back().first->AddChildren(children[current]);
         list->SetParent(current_lists[current_lists.size() - 2].first);
-        current_lists[current_lists.size() - 2].first->AddChildren(
-            std::move(list));
+        current_lists[current_lists.size() - 2].first->AddChildren(list);
       }
     }
 
@@ -339,6 +355,28 @@ std::optional<int> IsEmptyLine(std::string_view content, int start) {
   return content.size();
 }
 
+// Increases the nesting depth while in scope.
+class ScopedNestingDepth {
+ public:
+  explicit ScopedNestingDepth(int* depth) : depth_(depth) { (*depth_)++; }
+  ~ScopedNestingDepth() { (*depth_)--; }
+
+ private:
+  int* depth_;
+};
+
+// Opens the decoration of the type that is left as a plain text, or closes it
+// if it is the innermost one.
+void ToggleLiteralDecoration(
+    std::vector<ParseTreeNode::NodeType>* literal_decorations,
+    ParseTreeNode::NodeType type) {
+  if (!literal_decorations->empty() && literal_decorations->back() == type) {
+    literal_decorations->pop_back();
+  } else {
+    literal_decorations->push_back(type);
+  }
+}
+
 bool IsEndBoxToken(std::string_view content, size_t index) {
   if (index < 1) {
     return false;
@@ -358,13 +396,108 @@ bool IsEndBoxToken(std::string_view content, size_t index) {
 }  // namespace
 
 ParseTree Parser::GenerateParseTree(std::string_view content) {
-  auto root = std::make_unique<ParseTreeNode>(/*parent=*/nullptr, 0);
+  return GenerateParseTree(content, std::make_unique<Arena>());
+}
+
+ParseTree Parser::GenerateParseTree(std::string_view content,
+                                    std::unique_ptr<Arena> arena) {
+  auto* root = ParseTreeNode::Create<ParseTreeNode>(arena.get(),
+                                                    /*parent=*/nullptr, 0);
   RefContainer refs;
+  std::vector<SyncPoint> sync_points = {
+      SyncPoint{.position = 0, .read_end = 0}};
 
-  GenericParser(content, 0, /*end_parsing_token=*/"", root.get(), &refs);
+  const StructuralIndex structural_index(content);
+  ParseTopLevel(content, &structural_index, arena.get(), /*start=*/0,
+                /*read_end=*/0, root, &refs, &sync_points, /*stop_at=*/nullptr);
 
-  PostProcessList(root.get());
-  return ParseTree(std::move(root), std::move(refs));
+  return ParseTree(std::move(arena), root, std::move(refs),
+                   std::move(sync_points));
+}
+
+size_t Parser::ParseTopLevel(std::string_view content,
+                             const StructuralIndex* structural_index,
+                             Arena* arena, size_t start, size_t read_end,
+                             ParseTreeNode* root, RefContainer* refs,
+                             std::vector<SyncPoint>* sync_points,
+                             const std::function<bool(size_t)>& stop_at) {
+  // The states below only live during this parse; They are reset even if the
+  // parse throws, since the structural index and the others are not owned.
+  struct ResetStates {
+    Parser* parser;
+    ~ResetStates() {
+      parser->structural_index_ = nullptr;
+      parser->arena_ = nullptr;
+      parser->failed_positions_.clear();
+      parser->sync_points_ = nullptr;
+      parser->stop_at_ = nullptr;
+    }
+  } reset_states{this};
+
+  structural_index_ = structural_index;
+  arena_ = arena;
+  for (DelimiterFinder* finder :
+       {&math_end_finder_, &newline_math_end_finder_, &verbatim_end_finder_,
+        &verbatim_box_end_finder_}) {
+    finder->Reset();
+  }
+
+  // Note that the nested parse can not be deeper than kMaxNestingDepth.
+  failed_positions_.assign((kMaxNestingDepth + 1) * NUM_NESTED_PARSE_TYPES,
+                           {});
+
+  read_end_ = read_end;
+  sync_points_ = sync_points;
+  stop_at_ = &stop_at;
+
+  size_t end = GenericParser(content, start, /*end_parsing_token=*/"", root,
+                             refs);
+  PostProcessList(root);
+  return end;
+}
+
+size_t Parser::FindDelimiter(DelimiterFinder* finder, std::string_view content,
+                             size_t pos) {
+  size_t found = finder->Find(content, pos);
+  read_end_ = std::max(read_end_, found == std::string_view::npos
+                                      ? content.size() + 1
+                                      : found + finder->DelimiterSize());
+  return found;
+}
+
+size_t Parser::ParseNested(NestedParse* nested, std::string_view content,
+                           size_t start, std::string_view end_parsing_token,
+                           ParseTreeNode* root, RefContainer* refs,
+                           bool use_text, bool must_inline, bool no_link) {
+  next_nested_parse_ = nested;
+  return GenericParser(content, start, end_parsing_token, root, refs, use_text,
+                       must_inline, no_link);
+}
+
+void Parser::MarkNestedParseFailed(const NestedParse& nested) {
+  if (nested.top_level_positions.empty()) {
+    return;
+  }
+
+  std::vector<bool>& failed = FailedPositions(nested, /*content=*/{});
+  for (size_t position : nested.top_level_positions) {
+    failed[position] = true;
+  }
+}
+
+std::string_view Parser::FindCommandName(std::string_view name) {
+  const auto* command_info = kCommands.Find(name);
+  return command_info == nullptr ? std::string_view() : command_info->first;
+}
+
+std::vector<bool>& Parser::FailedPositions(const NestedParse& nested,
+                                           std::string_view content) {
+  std::vector<bool>& failed =
+      failed_positions_[nested.depth * NUM_NESTED_PARSE_TYPES + nested.type];
+  if (failed.size() < content.size() + 1) {
+    failed.resize(content.size() + 1);
+  }
+  return failed;
 }
 
 size_t Parser::GenericParser(std::string_view content, size_t start,
@@ -372,9 +505,31 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
                              ParseTreeNode* root, RefContainer* refs,
                              bool use_text, bool must_inline, bool no_link) {
   ParseTreeNode* current_node = root;
+  const bool use_structural_index =
+      structural_index_ != nullptr && structural_index_->IsIndexOf(content);
+
+  ScopedNestingDepth depth(&nesting_depth_);
+
+  // Number of the text decorations (e.g bold) that are not closed yet. The
+  // decorations that are nested deeper than kMaxNestingDepth are left as a
+  // plain text; Their markers are paired up in literal_decorations, so that
+  // none of them closes a decoration that is open in the tree.
+  int decoration_depth = 0;
+  std::vector<ParseTreeNode::NodeType> literal_decorations;
+
+  NestedParse* nested = std::exchange(next_nested_parse_, nullptr);
+  const std::vector<bool>* failed = nullptr;
+  if (nested != nullptr) {
+    nested->depth = nesting_depth_;
+    failed = &FailedPositions(*nested, content);
+  }
 
   size_t index = start;
   while (index < content.size()) {
+    if (index >= read_end_) {
+      read_end_ = LookaheadEnd(content, index);
+    }
+
     // If current node is the root node, then create the Paragraph node as a
     // default.
     if (current_node->GetParent() == nullptr) {
@@ -386,6 +541,14 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
       }
     }
 
+    if (nested != nullptr && current_node->GetParent() == root) {
+      if ((*failed)[index]) {
+        nested->known_failure = true;
+        return start;
+      }
+      nested->top_level_positions.push_back(index);
+    }
+
     if (must_inline && content[index] == '\n') {
       return start;
     }
@@ -394,7 +557,7 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
     if (content[index] == '\\') {
       if (index + 1 < content.size()) {
         char c = content[index + 1];
-        if (kEscapeableChars.count(c)) {
+        if (kEscapeableChars.Contains(c)) {
           current_node =
               CreateNewNode<ParseTreeEscapeNode>(current_node, index);
           current_node->SetEnd(index + 2);
@@ -406,7 +569,7 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
           auto maybe_command =
               MaybeParseCommand(content, current_node, refs, index, index);
           if (maybe_command != nullptr) {
-            current_node->AddChildren(std::move(maybe_command));
+            current_node->AddChildren(maybe_command);
             continue;
           }
         }
@@ -421,9 +584,9 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
           maybe_list != nullptr) {
         if (current_node->GetNodeType() == ParseTreeNode::PARAGRAPH) {
           current_node =
-              HoistNodeAboveParagraph(current_node, std::move(maybe_list));
+              HoistNodeAboveParagraph(arena_, current_node, maybe_list);
         } else {
-          current_node->AddChildren(std::move(maybe_list));
+          current_node->AddChildren(maybe_list);
         }
 
         continue;
@@ -431,12 +594,20 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
     }
 
     if (content.substr(index, 2) == "~~") {
-      if (current_node->GetNodeType() == ParseTreeNode::STRIKE_THROUGH) {
+      if (!literal_decorations.empty() ||
+          (decoration_depth == kMaxNestingDepth &&
+           current_node->GetNodeType() != ParseTreeNode::STRIKE_THROUGH)) {
+        ToggleLiteralDecoration(&literal_decorations,
+                                ParseTreeNode::STRIKE_THROUGH);
+      } else if (current_node->GetNodeType() ==
+                 ParseTreeNode::STRIKE_THROUGH) {
         current_node->SetEnd(index + 2);
         current_node = current_node->GetParent();
+        decoration_depth--;
       } else {
         current_node =
             CreateNewNode<ParseTreeStrikeThroughNode>(current_node, index);
+        decoration_depth++;
       }
 
       index += 2;
@@ -445,12 +616,9 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
 
     if (content.substr(index, 2) == "$$") {
       size_t start = index;
-      size_t current = index + 2;
-      while (content.substr(current, 2) != "$$" && current < content.size()) {
-        current++;
-      }
+      size_t current = FindDelimiter(&math_end_finder_, content, index + 2);
 
-      if (current != content.size()) {
+      if (current != std::string_view::npos) {
         auto* node = CreateNewNode<ParseTreeMathNode>(current_node, start);
         node->SetEnd(current + 2);
         index = current + 2;
@@ -462,12 +630,10 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
 
     if (content.substr(index, 2) == "\\[") {
       size_t start = index;
-      size_t current = index + 2;
-      while (content.substr(current, 2) != "\\]" && current < content.size()) {
-        current++;
-      }
+      size_t current =
+          FindDelimiter(&newline_math_end_finder_, content, index + 2);
 
-      if (current != content.size()) {
+      if (current != std::string_view::npos) {
         auto* node =
             CreateNewNode<ParseTreeNewlineMathNode>(current_node, start);
         node->SetEnd(current + 2);
@@ -484,9 +650,9 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
           maybe_list != nullptr) {
         if (current_node->GetNodeType() == ParseTreeNode::PARAGRAPH) {
           current_node =
-              HoistNodeAboveParagraph(current_node, std::move(maybe_list));
+              HoistNodeAboveParagraph(arena_, current_node, maybe_list);
         } else {
-          current_node->AddChildren(std::move(maybe_list));
+          current_node->AddChildren(maybe_list);
         }
 
         continue;
@@ -504,11 +670,17 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
       if (content.substr(index, 2) == "**" &&
           (current_node->GetNodeType() != ParseTreeNode::ITALIC ||
            FindParent(current_node, ParseTreeNode::BOLD) == nullptr)) {
-        if (current_node->GetNodeType() == ParseTreeNode::BOLD) {
+        if (!literal_decorations.empty() ||
+            (decoration_depth == kMaxNestingDepth &&
+             current_node->GetNodeType() != ParseTreeNode::BOLD)) {
+          ToggleLiteralDecoration(&literal_decorations, ParseTreeNode::BOLD);
+        } else if (current_node->GetNodeType() == ParseTreeNode::BOLD) {
           current_node->SetEnd(index + 2);
           current_node = current_node->GetParent();
+          decoration_depth--;
         } else {
           current_node = CreateNewNode<ParseTreeBoldNode>(current_node, index);
+          decoration_depth++;
         }
 
         // Skip the next two **s.
@@ -516,11 +688,17 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
         continue;
       }
 
-      if (current_node->GetNodeType() == ParseTreeNode::ITALIC) {
+      if (!literal_decorations.empty() ||
+          (decoration_depth == kMaxNestingDepth &&
+           current_node->GetNodeType() != ParseTreeNode::ITALIC)) {
+        ToggleLiteralDecoration(&literal_decorations, ParseTreeNode::ITALIC);
+      } else if (current_node->GetNodeType() == ParseTreeNode::ITALIC) {
         current_node->SetEnd(index + 1);
         current_node = current_node->GetParent();
+        decoration_depth--;
       } else {
         current_node = CreateNewNode<ParseTreeItalicNode>(current_node, index);
+        decoration_depth++;
       }
 
       index += 1;
@@ -532,7 +710,7 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
           MaybeParseLink<ParseTreeLinkNode>(content, refs, index, index);
 
       if (maybe_link) {
-        current_node->AddChildren(std::move(maybe_link));
+        current_node->AddChildren(maybe_link);
         continue;
       }
     }
@@ -543,10 +721,9 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
           MaybeParseLink<ParseTreeImageNode>(content, refs, index + 1, index);
 
       if (maybe_image) {
-        ParseTreeImageNode* image =
-            static_cast<ParseTreeImageNode*>(maybe_image.get());
+        auto* image = static_cast<ParseTreeImageNode*>(maybe_image);
         ParseImageDescriptionMetadata(content, image);
-        current_node->AddChildren(std::move(maybe_image));
+        current_node->AddChildren(maybe_image);
         continue;
       }
     }
@@ -557,10 +734,10 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
       if (maybe_header) {
         if (current_node->GetNodeType() == ParseTreeNode::PARAGRAPH) {
           current_node =
-              HoistNodeAboveParagraph(current_node, std::move(maybe_header));
+              HoistNodeAboveParagraph(arena_, current_node, maybe_header);
         } else {
           // TODO Mark as a syntax error in the MD file.
-          current_node->AddChildren(std::move(maybe_header));
+          current_node->AddChildren(maybe_header);
         }
         continue;
       }
@@ -573,10 +750,10 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
         if (maybe_quote) {
           if (current_node->GetNodeType() == ParseTreeNode::PARAGRAPH) {
             current_node =
-                HoistNodeAboveParagraph(current_node, std::move(maybe_quote));
+                HoistNodeAboveParagraph(arena_, current_node, maybe_quote);
           } else {
             // TODO Mark as a syntax error in the MD file.
-            current_node->AddChildren(std::move(maybe_quote));
+            current_node->AddChildren(maybe_quote);
           }
           continue;
         }
@@ -598,24 +775,22 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
         if (current_node->GetNodeType() == ParseTreeNode::PARAGRAPH ||
             current_node->GetNodeType() == ParseTreeNode::TEXT) {
           current_node =
-              HoistNodeAboveParagraph(current_node, std::move(maybe_box));
+              HoistNodeAboveParagraph(arena_, current_node, maybe_box);
         } else {
-          current_node->AddChildren(std::move(maybe_box));
+          current_node->AddChildren(maybe_box);
         }
         continue;
       } else if (content.substr(index, 3) != "```") {
         int verbatim_start = index;
-        index++;
 
         // Try to find the end `.
-        while (index < content.size()) {
-          if (content[index] == '`') {
-            current_node->AddChildren(std::make_unique<ParseTreeVerbatimNode>(
-                current_node, verbatim_start));
-            current_node->GetLastChildren()->SetEnd(index + 1);
-            break;
-          }
-          index++;
+        index = FindDelimiter(&verbatim_end_finder_, content, index + 1);
+        if (index == std::string_view::npos) {
+          index = content.size();
+        } else {
+          current_node->AddChildren(
+              NewNode<ParseTreeVerbatimNode>(current_node, verbatim_start));
+          current_node->GetLastChildren()->SetEnd(index + 1);
         }
         index++;
         continue;
@@ -627,9 +802,24 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
     // that).
     if (end_parsing_token != "\n" && content.substr(index, 2) == "\n\n") {
       current_node = MarkEndAllTheWayUp(current_node, index);
+      decoration_depth = 0;
+      literal_decorations.clear();
 
       // Skip the next two \n s.
       index += 2;
+
+      // Nothing is open at the top level now.
+      if (nesting_depth_ == 1 && sync_points_ != nullptr) {
+        read_end_ = std::max(read_end_, index);
+        sync_points_->push_back(
+            SyncPoint{.position = static_cast<int>(index),
+                      .read_end = static_cast<int>(read_end_)});
+
+        if (*stop_at_ && (*stop_at_)(index)) {
+          root->SetEnd(index);
+          return index;
+        }
+      }
       continue;
     }
 
@@ -639,9 +829,9 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
       if (maybe_table) {
         if (current_node->GetNodeType() == ParseTreeNode::PARAGRAPH) {
           current_node =
-              HoistNodeAboveParagraph(current_node, std::move(maybe_table));
+              HoistNodeAboveParagraph(arena_, current_node, maybe_table);
         } else {
-          current_node->AddChildren(std::move(maybe_table));
+          current_node->AddChildren(maybe_table);
         }
         continue;
       }
@@ -660,9 +850,18 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
       return index + end_parsing_token.size();
     }
 
-    index += 1;
+    // None of the above can happen at the plain text so jump to the next
+    // structural character.
+    if (use_structural_index) {
+      index = structural_index_->NextStructural(index + 1);
+    } else {
+      index += 1;
+    }
   }
 
+  // The parser had to look until the end of the content.
+  read_end_ = content.size() + 1;
+
   // Walk up the node and mark its end.
   MarkEndAllTheWayUp(current_node, content.size());
   root->SetEnd(content.size());
@@ -672,22 +871,25 @@ size_t Parser::GenericParser(std::string_view content, size_t start,
 
 // Link has the form [link-desc](url)
 template <typename LinkNodeType>
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseLink(std::string_view content,
-                                                      RefContainer* refs,
-                                                      size_t start,
-                                                      size_t& end) {
+ParseTreeNode* Parser::MaybeParseLink(std::string_view content,
+                                      RefContainer* refs, size_t start,
+                                      size_t& end) {
   LOG(3) << "Maybe link : " << content.substr(start, 10) << " -- " << start;
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
+
   int node_start = start;
   if constexpr (std::is_same_v<LinkNodeType, ParseTreeImageNode>) {
     // Need to include the preceding '!'.
     node_start--;
   }
 
-  auto root = std::make_unique<LinkNodeType>(nullptr, node_start);
+  auto* root = NewNode<LinkNodeType>(nullptr, node_start);
 
   // We should not specify the parent as Link yet (otherwise checking the end
   // parsing token would not work.)
-  auto desc = std::make_unique<ParseTreeNode>(nullptr, node_start);
+  auto* desc = NewNode<ParseTreeNode>(nullptr, node_start);
 
   bool no_nested_link = true;
 
@@ -699,21 +901,30 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseLink(std::string_view content,
   */
 
   // Note that parsing starts after "[" (to prevent infinite loop).
-  size_t desc_end =
-      GenericParser(content, start + 1, "]", desc.get(), refs,
-                    /*use_text=*/true, /*must_inline=*/true, no_nested_link);
-
-  if (start == desc_end || content.substr(desc_end - 1, 2) != "](") {
+  NestedParse desc_parse(LINK_DESC);
+  size_t desc_end = ParseNested(&desc_parse, content, start + 1, "]", desc,
+                                refs, /*use_text=*/true, /*must_inline=*/true,
+                                no_nested_link);
+
+  if (desc_parse.known_failure || start == desc_end ||
+      content.substr(desc_end - 1, 2) != "](") {
+    MarkNestedParseFailed(desc_parse);
     return nullptr;
   }
   desc->SetEnd(desc_end);
 
-  auto url = std::make_unique<ParseTreeNode>(nullptr, desc_end);
+  auto* url = NewNode<ParseTreeNode>(nullptr, desc_end);
 
   // Parsing starts after "(".
-  size_t url_end = GenericParser(content, desc_end + 1, ")", url.get(), refs,
-                                 /*use_text=*/true, /*must_inline=*/true);
-  if (url_end == desc_end + 1 || content.substr(url_end - 1, 1) != ")") {
+  NestedParse url_parse(LINK_URL);
+  size_t url_end =
+      ParseNested(&url_parse, content, desc_end + 1, ")", url, refs,
+                  /*use_text=*/true, /*must_inline=*/true);
+  if (url_parse.known_failure || url_end == desc_end + 1 ||
+      content.substr(url_end - 1, 1) != ")") {
+    // Every link that has the same description fails as well.
+    MarkNestedParseFailed(desc_parse);
+    MarkNestedParseFailed(url_parse);
     return nullptr;
   }
   url->SetEnd(url_end);
@@ -721,11 +932,11 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseLink(std::string_view content,
   end = url_end;
   root->SetEnd(url_end);
 
-  desc->SetParent(root.get());
-  root->AddChildren(std::move(desc));
+  desc->SetParent(root);
+  root->AddChildren(desc);
 
-  url->SetParent(root.get());
-  root->AddChildren(std::move(url));
+  url->SetParent(root);
+  root->AddChildren(url);
 
   return root;
 }
@@ -733,20 +944,18 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseLink(std::string_view content,
 void Parser::ParseImageDescriptionMetadata(std::string_view content,
                                            ParseTreeImageNode* image) {
   // Keys can be "alt", "caption" or "size".
-  std::unordered_map<std::string, std::unique_ptr<ParseTreeNode>>
-      nodes_per_keyword;
+  std::unordered_map<std::string_view, ParseTreeNode*> nodes_per_keyword;
 
   // Go through the strings in the paragraph that are not part of the any
   // child node. If it contains xxx= kind of the form, check what xxx is.
-  ParseTreeNode* desc_node = image->GetChildren()[0].get();
+  ParseTreeNode* desc_node = image->GetChildren()[0];
   MD2_ASSERT(desc_node->GetNodeType() == ParseTreeNode::NODE, "");
 
-  ParseTreeNode* desc = desc_node->GetChildren()[0].get();
+  ParseTreeNode* desc = desc_node->GetChildren()[0];
   MD2_ASSERT(desc->GetNodeType() == ParseTreeNode::TEXT, "");
 
-  nodes_per_keyword["alt"] =
-      std::make_unique<ParseTreeTextNode>(nullptr, desc->Start());
-  ParseTreeNode* current_keyword = nodes_per_keyword["alt"].get();
+  nodes_per_keyword["alt"] = NewNode<ParseTreeTextNode>(nullptr, desc->Start());
+  ParseTreeNode* current_keyword = nodes_per_keyword["alt"];
 
   // Start of the current segment.
   int start = desc->Start();
@@ -757,22 +966,21 @@ void Parser::ParseImageDescriptionMetadata(std::string_view content,
       // There is no child node from [start ~ ].  Then [start ~ desc->End())
       // forms the string that is not part of the child node.
       std::string_view raw_str = content.substr(start, desc->End() - start);
-      current_keyword = BuildImageKeywordNodes(raw_str, start, current_keyword,
-                                               nodes_per_keyword);
+      current_keyword = BuildImageKeywordNodes(
+          arena_, raw_str, start, current_keyword, nodes_per_keyword);
       current_keyword->SetEnd(desc->End());
       break;
     } else {
-      ParseTreeNode* next_child = desc->GetChildren()[next_child_index].get();
+      ParseTreeNode* next_child = desc->GetChildren()[next_child_index];
 
       // Then [start ~ next_child->Start()) forms the raw string.
       std::string_view raw_str =
           content.substr(start, next_child->Start() - start);
-      current_keyword = BuildImageKeywordNodes(raw_str, start, current_keyword,
-                                               nodes_per_keyword);
+      current_keyword = BuildImageKeywordNodes(
+          arena_, raw_str, start, current_keyword, nodes_per_keyword);
 
-      std::unique_ptr<ParseTreeNode> child =
-          desc->PopChildrenAt(next_child_index);
-      current_keyword->AddChildren(std::move(child));
+      ParseTreeNode* child = desc->PopChildrenAt(next_child_index);
+      current_keyword->AddChildren(child);
 
       start = next_child->End();
     }
@@ -782,9 +990,14 @@ void Parser::ParseImageDescriptionMetadata(std::string_view content,
   image->SetKeywordNodes(nodes_per_keyword);
 }
 
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseHeader(
-    std::string_view content, ParseTreeNode* parent, RefContainer* refs,
-    size_t start, size_t& end) {
+ParseTreeNode* Parser::MaybeParseHeader(std::string_view content,
+                                        ParseTreeNode* parent,
+                                        RefContainer* refs, size_t start,
+                                        size_t& end) {
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
+
   // Header must be start from the new line.
   if (start != 0 && content[start - 1] != '\n') {
     return nullptr;
@@ -804,25 +1017,24 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseHeader(
     header_token_end++;
   }
 
-  auto header = std::make_unique<ParseTreeHeaderNode>(parent, start);
-  header->AddChildren(std::make_unique<ParseTreeTextNode>(header.get(), start));
+  auto* header = NewNode<ParseTreeHeaderNode>(parent, start);
+  header->AddChildren(NewNode<ParseTreeTextNode>(header, start));
   header->GetLastChildren()->SetEnd(header_token_end);
 
   // If the header token is ###@, then we should parse it.
   // TODO This should be a default behavior. Some old markdown uses non escaped
   // syntaxs in the header which prevents us from using the GenericParser.
   if (content.substr(start, header_token_end - start) == "###@") {
-    auto header_content =
-        std::make_unique<ParseTreeNode>(nullptr, header_token_end);
-    size_t header_end = GenericParser(content, header_token_end, "\n",
-                                      header_content.get(), refs,
-                                      /*use_text=*/true);
+    auto* header_content = NewNode<ParseTreeNode>(nullptr, header_token_end);
+    size_t header_end =
+        GenericParser(content, header_token_end, "\n", header_content, refs,
+                      /*use_text=*/true);
     if (header_end != content.size() && content[header_end - 1] != '\n') {
       return nullptr;
     }
 
     header_content->SetEnd(header_end);
-    header->AddChildren(std::move(header_content));
+    header->AddChildren(header_content);
     header->SetEnd(header_end);
     end = header_end;
 
@@ -835,20 +1047,21 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseHeader(
     end++;
   }
 
-  header->AddChildren(
-      std::make_unique<ParseTreeTextNode>(header.get(), header_token_end));
+  header->AddChildren(NewNode<ParseTreeTextNode>(header, header_token_end));
   header->GetLastChildren()->SetEnd(end);
   header->SetEnd(end);
 
   return header;
 }
 
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseBox(std::string_view content,
-                                                     ParseTreeNode* parent,
-                                                     RefContainer* refs,
-                                                     size_t start,
-                                                     size_t& end) {
+ParseTreeNode* Parser::MaybeParseBox(std::string_view content,
+                                     ParseTreeNode* parent, RefContainer* refs,
+                                     size_t start, size_t& end) {
   LOG(3) << "start : " << start << " : " << content.substr(start, 10);
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
+
   if (start != 0 && content[start - 1] != '\n') {
     return nullptr;
   }
@@ -864,7 +1077,7 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseBox(std::string_view content,
 
   // Try to read the box name.
   size_t box_name_end = start + 3;
-  while (content[box_name_end] != '\n' && box_name_end < content.size()) {
+  while (box_name_end < content.size() && content[box_name_end] != '\n') {
     box_name_end++;
   }
 
@@ -874,29 +1087,25 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseBox(std::string_view content,
     return nullptr;
   }
 
-  std::string box_name(content.substr(start + 3, box_name_end - (start + 3)));
-  if (kVerbatimBoxNames.count(box_name)) {
+  std::string_view box_name =
+      content.substr(start + 3, box_name_end - (start + 3));
+  if (kVerbatimBoxNames.Contains(box_name)) {
     // Then the nested ```s are not allowed. Just find the end of the box.
-    end = box_name_end + 1;
-    while (content.substr(end, 3) != "```") {
-      end++;
-
-      if (end >= content.size()) {
-        end = start;
-        return nullptr;
-      }
+    end =
+        FindDelimiter(&verbatim_box_end_finder_, content, box_name_end + 1);
+    if (end == std::string_view::npos) {
+      end = start;
+      return nullptr;
     }
 
-    auto code = std::make_unique<ParseTreeVerbatimNode>(parent, start);
+    auto* code = NewNode<ParseTreeVerbatimNode>(parent, start);
 
     // Box name becomes the first text child node.
-    code->AddChildren(
-        std::make_unique<ParseTreeTextNode>(code.get(), start + 3));
+    code->AddChildren(NewNode<ParseTreeTextNode>(code, start + 3));
     code->GetLastChildren()->SetEnd(box_name_end);
 
     // The actual code becomes the next text child node.
-    code->AddChildren(
-        std::make_unique<ParseTreeTextNode>(code.get(), box_name_end + 1));
+    code->AddChildren(NewNode<ParseTreeTextNode>(code, box_name_end + 1));
     code->GetLastChildren()->SetEnd(end);
 
     code->SetEnd(end + 3);
@@ -906,32 +1115,34 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseBox(std::string_view content,
   }
 
   // If this is not code, then the box node can be nested.
-  auto box = std::make_unique<ParseTreeBoxNode>(parent, start);
+  auto* box = NewNode<ParseTreeBoxNode>(parent, start);
 
   // Box name becomes the first text child node.
-  box->AddChildren(std::make_unique<ParseTreeTextNode>(box.get(), start + 3));
+  box->AddChildren(NewNode<ParseTreeTextNode>(box, start + 3));
   box->GetLastChildren()->SetEnd(box_name_end);
 
   // We should not specify the parent as Box yet (otherwise checking the end
   // parsing token would not work.) Note that start of the box content does not
   // contain the \n of the box name.
-  auto box_content_node =
-      std::make_unique<ParseTreeNode>(nullptr, box_name_end + 1);
+  auto* box_content_node = NewNode<ParseTreeNode>(nullptr, box_name_end + 1);
 
   bool is_ref_box = (box_name.substr(0, 4) == "ref-" && box_name.size() > 4);
+  NestedParse content_parse(is_ref_box ? REF_BOX_CONTENT : BOX_CONTENT);
   size_t box_content_end =
-      GenericParser(content, box_name_end + 1, "```", box_content_node.get(),
-                    refs, /*use_text=*/is_ref_box);
+      ParseNested(&content_parse, content, box_name_end + 1, "```",
+                  box_content_node, refs, /*use_text=*/is_ref_box);
 
   LOG(3) << "box content end : [" << content.substr(box_content_end - 4, 4)
          << "]";
-  if (content.substr(box_content_end - 4, 4) != "\n```") {
+  if (content_parse.known_failure ||
+      content.substr(box_content_end - 4, 4) != "\n```") {
+    MarkNestedParseFailed(content_parse);
     return nullptr;
   }
 
   box_content_node->SetEnd(box_content_end);
-  box_content_node->SetParent(box.get());
-  box->AddChildren(std::move(box_content_node));
+  box_content_node->SetParent(box);
+  box->AddChildren(box_content_node);
 
   // Note that ``` is included in the paragraph of the box content node.
   end = box_content_end;
@@ -939,18 +1150,21 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseBox(std::string_view content,
 
   if (is_ref_box) {
     // Then register this box node as a reference.
-    (*refs)[box_name.substr(4)] = box.get();
+    (*refs)[std::string(box_name.substr(4))] = box;
   }
 
   LOG(3) << "End box " << box_name << "!\n";
   return box;
 }
 
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseTable(std::string_view content,
-                                                       ParseTreeNode* parent,
-                                                       RefContainer* refs,
-                                                       size_t start,
-                                                       size_t& end) {
+ParseTreeNode* Parser::MaybeParseTable(std::string_view content,
+                                       ParseTreeNode* parent,
+                                       RefContainer* refs, size_t start,
+                                       size_t& end) {
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
+
   // Table must start with newline.
   if (start != 0 && content[start - 1] != '\n') {
     return nullptr;
@@ -960,21 +1174,21 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseTable(std::string_view content,
     return nullptr;
   }
 
-  auto table = std::make_unique<ParseTreeTableNode>(parent, start);
+  auto* table = NewNode<ParseTreeTableNode>(parent, start);
 
   size_t current = start + 1;
   while (true) {
     while (true) {
-      auto cell = std::make_unique<ParseTreeNode>(nullptr, current);
-      size_t cell_end = GenericParser(content, current, "|", cell.get(), refs);
+      auto* cell = NewNode<ParseTreeNode>(nullptr, current);
+      size_t cell_end = GenericParser(content, current, "|", cell, refs);
 
       // Not a valid table.
       if (content[cell_end - 1] != '|') {
         return nullptr;
       }
 
-      cell->SetParent(table.get());
-      table->AddChildren(std::move(cell));
+      cell->SetParent(table);
+      table->AddChildren(cell);
 
       if (cell_end >= content.size()) {
         // Then the current row ends.
@@ -1037,11 +1251,13 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseTable(std::string_view content,
 //
 // Those list items will from the actual list after the post-processing part in
 // the parser.
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseList(std::string_view content,
-                                                      ParseTreeNode* parent,
-                                                      RefContainer* refs,
-                                                      size_t start,
-                                                      size_t& end) {
+ParseTreeNode* Parser::MaybeParseList(std::string_view content,
+                                      ParseTreeNode* parent, RefContainer* refs,
+                                      size_t start, size_t& end) {
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
+
   auto list_header_info = IsCorrectListHeader(content, start);
   if (!list_header_info) {
     return nullptr;
@@ -1052,13 +1268,12 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseList(std::string_view content,
   bool is_ordered = content[start] != '*';
 
   // Now try to create the list item element.
-  auto list_item = std::make_unique<ParseTreeListItemNode>(
-      nullptr, start - list_depth, is_ordered);
+  auto* list_item =
+      NewNode<ParseTreeListItemNode>(nullptr, start - list_depth, is_ordered);
   list_item->SetListDepth(list_depth);
 
   while (true) {
-    size_t list_end =
-        GenericParser(content, current, "\n", list_item.get(), refs);
+    size_t list_end = GenericParser(content, current, "\n", list_item, refs);
     if (list_end == content.size()) {
       list_item->SetEnd(list_end);
       list_item->SetParent(parent);
@@ -1108,43 +1323,41 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseList(std::string_view content,
   return list_item;
 }
 
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseCommand(
-    std::string_view content, ParseTreeNode* parent, RefContainer* refs,
-    size_t start, size_t& end) {
+ParseTreeNode* Parser::MaybeParseCommand(std::string_view content,
+                                         ParseTreeNode* parent,
+                                         RefContainer* refs, size_t start,
+                                         size_t& end) {
   LOG(3) << "Maybe Command : " << content.substr(start, 5) << "--" << start;
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
 
   // Commands are in form \command{}{}..{}
   // Number of {} s can be vary.
-  std::string_view command_name;
-  int num_arg = 0;
-
+  // The command name is followed by '{'.
   size_t command_start = start + 1;
-  for (const auto& [name, arg] : kCommandToNumArgs) {
-    if (content.substr(command_start, name.size()) == name &&
-        command_start + name.size() < content.size() &&
-        content[command_start + name.size()] == '{') {
-      command_name = name;
-      num_arg = arg;
-      break;
-    }
+  const size_t brace =
+      content.substr(command_start, kMaxCommandNameSize + 1).find('{');
+  if (brace == std::string_view::npos) {
+    return nullptr;
   }
 
-  if (command_name.empty()) {
+  const auto* command_info =
+      kCommands.Find(content.substr(command_start, brace));
+  if (command_info == nullptr) {
     return nullptr;
   }
 
-  auto command = std::make_unique<ParseTreeCommandNode>(parent, start);
+  // Note that the name points to the one in kCommands.
+  const std::string_view command_name = command_info->first;
+  int num_arg = command_info->second.num_args;
+
+  auto* command = NewNode<ParseTreeCommandNode>(parent, start);
   command->SetCommandName(command_name);
 
   // current now points {.
   size_t current = command_start + command_name.size();
 
-  std::unordered_set<size_t> verbatim_args;
-  if (const auto itr = kVerbatimCommands.find(std::string(command_name));
-      itr != kVerbatimCommands.end()) {
-    verbatim_args = itr->second;
-  }
-
   size_t arg_index = 0;
   while (num_arg--) {
     if (current >= content.size() || content[current] != '{') {
@@ -1156,14 +1369,14 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseCommand(
 
     // In this case, we should treat current argument as a verbatim. Do not
     // parse whatever that is inside {}.
-    if (verbatim_args.count(arg_index)) {
+    if ((command_info->second.verbatim_args >> arg_index) & 1) {
       size_t arg_start = current;
       while (current < content.size()) {
         if (content[current] == '}' && content[current - 1] != '\\') {
-          auto arg = std::make_unique<ParseTreeTextNode>(nullptr, arg_start);
+          auto* arg = NewNode<ParseTreeTextNode>(nullptr, arg_start);
           arg->SetEnd(current);
 
-          command->AddChildren(std::move(arg));
+          command->AddChildren(arg);
 
           // Current now points after '}'.
           current++;
@@ -1172,20 +1385,24 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseCommand(
         current++;
       }
     } else {
-      auto arg = std::make_unique<ParseTreeNode>(nullptr, current);
-      current = GenericParser(content, current, "}", arg.get(), refs, true);
+      auto* arg = NewNode<ParseTreeNode>(nullptr, current);
+      NestedParse arg_parse(COMMAND_ARG);
+      current = ParseNested(&arg_parse, content, current, "}", arg, refs,
+                            /*use_text=*/true);
 
-      if (content[current - 1] != '}') {
+      if (arg_parse.known_failure || content[current - 1] != '}') {
+        MarkNestedParseFailed(arg_parse);
         return nullptr;
       }
 
-      if (num_arg > 0 && content[current] != '{') {
+      if (num_arg > 0 &&
+          (current >= content.size() || content[current] != '{')) {
         return nullptr;
       }
 
       // Arg does not include }.
       arg->SetEnd(current - 1);
-      command->AddChildren(std::move(arg));
+      command->AddChildren(arg);
     }
 
     arg_index++;
@@ -1196,20 +1413,23 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseCommand(
   return command;
 }
 
-std::unique_ptr<ParseTreeNode> Parser::MaybeParseQuote(std::string_view content,
-                                                       ParseTreeNode* parent,
-                                                       RefContainer* refs,
-                                                       size_t start,
-                                                       size_t& end) {
+ParseTreeNode* Parser::MaybeParseQuote(std::string_view content,
+                                       ParseTreeNode* parent,
+                                       RefContainer* refs, size_t start,
+                                       size_t& end) {
+  if (nesting_depth_ >= kMaxNestingDepth) {
+    return nullptr;
+  }
+
   if (content.substr(start, 2) != "> ") {
     return nullptr;
   }
 
-  auto quote = std::make_unique<ParseTreeQuoteNode>(nullptr, start);
+  auto* quote = NewNode<ParseTreeQuoteNode>(nullptr, start);
   size_t current = start + 2;
 
   while (true) {
-    current = GenericParser(content, current, "\n", quote.get(), refs,
+    current = GenericParser(content, current, "\n", quote, refs,
                             /*use_text=*/true);
     if (current != content.size() && content[current - 1] != '\n') {
       return nullptr;
@@ -1231,13 +1451,17 @@ std::unique_ptr<ParseTreeNode> Parser::MaybeParseQuote(std::string_view content,
 void Parser::PostProcessList(ParseTreeNode* root) {
   // Traverse nodes and convert list_items into part of list node based on their
   // list depth.
-  std::vector<std::unique_ptr<ParseTreeNode>>& children = root->GetChildren();
-  for (size_t current = 0; current != children.size(); current++) {
+  //
+  // The children are compacted in place (rather than erasing the list items of
+  // every list) so that the root with many lists is processed in linear time.
+  ParseTreeNode::Children& children = root->GetChildren();
+  size_t num_children = 0;
+  for (size_t current = 0; current != children.size();) {
     // If the list item is found, then locate the end of the list item.
-    if (IsListItemType(children[current].get())) {
+    if (IsListItemType(children[current])) {
       size_t list_item_end = current;
       while (list_item_end != children.size()) {
-        if (!IsListItemType(children[list_item_end].get())) {
+        if (!IsListItemType(children[list_item_end])) {
           break;
         }
 
@@ -1245,18 +1469,21 @@ void Parser::PostProcessList(ParseTreeNode* root) {
       }
 
       auto list_node =
-          ConstructListFromListItems(children, current, list_item_end);
+          ConstructListFromListItems(arena_, children, current, list_item_end);
       if (list_node != nullptr) {
-        // Erase the list item elements (they are already moved out anyway into
-        // the child of lists.).
-        children.erase(children.begin() + current,
-                       children.begin() + list_item_end);
-        children.insert(children.begin() + current, std::move(list_node));
+        // The list item elements are already moved out into the child of
+        // lists.
+        children[num_children++] = list_node;
+        current = list_item_end;
+        continue;
       }
     } else {
-      PostProcessList(children[current].get());
+      PostProcessList(children[current]);
     }
+
+    children[num_children++] = children[current++];
   }
+  children.resize(num_children);
 }
 
 }  // namespace md2
@@ -1,10 +1,13 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "parse_tree.h"
 #include "parse_tree_nodes/image.h"
+#include "structural_index.h"
 
 namespace md2 {
 
@@ -17,9 +20,39 @@ using RefContainer = std::unordered_map<std::string, ParseTreeNode*>;
 // LaTeX) by the generator.
 class Parser {
  public:
+  // Syntax that is nested deeper than this (e.g the image inside of the image
+  // inside of the image ...) is not parsed and left as a plain text. This
+  // bounds the recursion of the parser and the depth of the parse tree.
+  static constexpr int kMaxNestingDepth = 16;
+
   ParseTree GenerateParseTree(std::string_view content);
 
+  // Builds the tree inside of the given arena. The arena can be reclaimed
+  // from the returned tree (see ParseTree::ReleaseArena) and reused for the
+  // next document.
+  ParseTree GenerateParseTree(std::string_view content,
+                              std::unique_ptr<Arena> arena);
+
+  // Returns the name in the static command table that is equal to the given
+  // one (which outlives any tree), or an empty string if it is not a command.
+  static std::string_view FindCommandName(std::string_view name);
+
  private:
+  friend class ParallelParser;
+  friend class ParseTree;
+
+  // Parses the top level blocks from start (which must be a sync point whose
+  // read_end is the given one) into the root. Every sync point that the parser
+  // passes is added to sync_points. If stop_at is set, the parsing stops at the
+  // first sync point where stop_at returns true. The structural index of the
+  // content is optional.
+  // Returns the position where the parsing stopped.
+  size_t ParseTopLevel(std::string_view content,
+                       const StructuralIndex* structural_index, Arena* arena,
+                       size_t start, size_t read_end, ParseTreeNode* root,
+                       RefContainer* refs, std::vector<SyncPoint>* sync_points,
+                       const std::function<bool(size_t)>& stop_at);
+
   // Builds the tree from the given root node. Note that this parses until it
   // sees the end_parsing_token. If end_parsing_token is empty, then it tries to
   // parse until the end of the content.
@@ -32,15 +65,61 @@ class Parser {
                        RefContainer* refs, bool use_text = false,
                        bool must_inline = false, bool no_link = false);
 
+  // Types of the nested parses whose failures are memoized.
+  enum NestedParseType {
+    LINK_DESC,
+    LINK_URL,
+    BOX_CONTENT,
+    REF_BOX_CONTENT,
+    COMMAND_ARG,
+    NUM_NESTED_PARSE_TYPES
+  };
+
+  // Nested parse (e.g the description of the link) that remembers the
+  // positions where it was at the top level (i.e the current node is right
+  // under the root). From such a position, the rest of the parse only depends
+  // on the position and the nesting depth. So once the nested parse fails,
+  // every parse of the same type at the same depth that reaches one of those
+  // positions fails as well, and can stop right there. This is what keeps the
+  // parser linear on the inputs like "[a](b [a](b [a](b ...".
+  struct NestedParse {
+    explicit NestedParse(NestedParseType type) : type(type) {}
+
+    NestedParseType type;
+    int depth = 0;
+    std::vector<size_t> top_level_positions;
+
+    // Set if the parse reached a position that is known to fail.
+    bool known_failure = false;
+  };
+
+  // Finds the delimiter and notes how far the parser looked at the content.
+  size_t FindDelimiter(DelimiterFinder* finder, std::string_view content,
+                       size_t pos);
+
+  // Runs the GenericParser as the nested parse.
+  size_t ParseNested(NestedParse* nested, std::string_view content,
+                     size_t start, std::string_view end_parsing_token,
+                     ParseTreeNode* root, RefContainer* refs, bool use_text,
+                     bool must_inline = false, bool no_link = false);
+
+  // Records that the parse from the top level positions of the nested parse
+  // fails.
+  void MarkNestedParseFailed(const NestedParse& nested);
+
+  // Positions that are known to fail for the nested parse of the same type
+  // and depth.
+  std::vector<bool>& FailedPositions(const NestedParse& nested,
+                                    std::string_view content);
+
   // Try to parse the markdown that starts with '['. The parsing can fail if it
   // does not construct the proper link. In such case, this will return nullptr
   // and end will not be modified.
   // Otherwise, return the constructed tree node and set the end of the parsed
   // link.
   template <typename LinkNodeType>
-  std::unique_ptr<ParseTreeNode> MaybeParseLink(std::string_view content,
-                                                RefContainer* refs,
-                                                size_t start, size_t& end);
+  ParseTreeNode* MaybeParseLink(std::string_view content, RefContainer* refs,
+                                size_t start, size_t& end);
 
   // Parse the image description of the Image node.
   void ParseImageDescriptionMetadata(std::string_view content,
@@ -48,43 +127,80 @@ class Parser {
 
   // Try to parse the header that starts with '#'. Note that header must be
   // first in the line (so the preceding character must be '\n'.
-  std::unique_ptr<ParseTreeNode> MaybeParseHeader(std::string_view content,
-                                                  ParseTreeNode* parent,
-                                                  RefContainer* refs,
-                                                  size_t start, size_t& end);
+  ParseTreeNode* MaybeParseHeader(std::string_view content,
+                                  ParseTreeNode* parent, RefContainer* refs,
+                                  size_t start, size_t& end);
 
   // Try to parse a box (starts with ```).
-  std::unique_ptr<ParseTreeNode> MaybeParseBox(std::string_view content,
-                                               ParseTreeNode* parent,
-                                               RefContainer* refs, size_t start,
-                                               size_t& end);
+  ParseTreeNode* MaybeParseBox(std::string_view content, ParseTreeNode* parent,
+                               RefContainer* refs, size_t start, size_t& end);
 
   // Try to parse the table.
-  std::unique_ptr<ParseTreeNode> MaybeParseTable(std::string_view content,
-                                                 ParseTreeNode* parent,
-                                                 RefContainer* refs,
-                                                 size_t start, size_t& end);
+  ParseTreeNode* MaybeParseTable(std::string_view content,
+                                 ParseTreeNode* parent, RefContainer* refs,
+                                 size_t start, size_t& end);
 
   // Try to parse the list.
-  std::unique_ptr<ParseTreeNode> MaybeParseList(std::string_view content,
-                                                ParseTreeNode* parent,
-                                                RefContainer* refs,
-                                                size_t start, size_t& end);
+  ParseTreeNode* MaybeParseList(std::string_view content, ParseTreeNode* parent,
+                                RefContainer* refs, size_t start, size_t& end);
 
   // Try to parse the command.
-  std::unique_ptr<ParseTreeNode> MaybeParseCommand(std::string_view content,
-                                                   ParseTreeNode* parent,
-                                                   RefContainer* refs,
-                                                   size_t start, size_t& end);
+  ParseTreeNode* MaybeParseCommand(std::string_view content,
+                                   ParseTreeNode* parent, RefContainer* refs,
+                                   size_t start, size_t& end);
 
   // Try to parse the quote.
-  std::unique_ptr<ParseTreeNode> MaybeParseQuote(std::string_view content,
-                                                 ParseTreeNode* parent,
-                                                 RefContainer* refs,
-                                                 size_t start, size_t& end);
+  ParseTreeNode* MaybeParseQuote(std::string_view content,
+                                 ParseTreeNode* parent, RefContainer* refs,
+                                 size_t start, size_t& end);
+
+  // Creates the node in the arena of the tree that is being built.
+  template <typename NodeType, typename... Args>
+  NodeType* NewNode(Args&&... args) {
+    return ParseTreeNode::Create<NodeType>(arena_, std::forward<Args>(args)...);
+  }
+
+  // Create a new node that starts at the given parameter.
+  template <typename NewNodeType>
+  ParseTreeNode* CreateNewNode(ParseTreeNode* current_node, size_t start) {
+    current_node->AddChildren(NewNode<NewNodeType>(current_node, start));
+    return current_node->GetLastChildren();
+  }
 
   // Construct List node from the consecutive list items.
   void PostProcessList(ParseTreeNode* root);
+
+  // Arena of the tree that is being built.
+  Arena* arena_ = nullptr;
+
+  // Structural characters of the content that is being parsed. Not owned
+  // (the chunks of the content that are parsed in parallel share the index).
+  // Set while running ParseTopLevel.
+  const StructuralIndex* structural_index_ = nullptr;
+
+  // Finders of the closing delimiters.
+  DelimiterFinder math_end_finder_{"$$"};
+  DelimiterFinder newline_math_end_finder_{"\\]"};
+  DelimiterFinder verbatim_end_finder_{"`"};
+  DelimiterFinder verbatim_box_end_finder_{"```"};
+
+  // Number of the GenericParser calls that are in progress.
+  int nesting_depth_ = 0;
+
+  // Nested parse for the next GenericParser call.
+  NestedParse* next_nested_parse_ = nullptr;
+
+  // Failed positions per the nested parse type and the nesting depth.
+  std::vector<std::vector<bool>> failed_positions_;
+
+  // The parser looked at the content up to here (not included). Equals to
+  // content.size() + 1 if the parser looked for something until the end of
+  // the content.
+  size_t read_end_ = 0;
+
+  // Set while running ParseTopLevel.
+  std::vector<SyncPoint>* sync_points_ = nullptr;
+  const std::function<bool(size_t)>* stop_at_ = nullptr;
 };
 
 }  // namespace md2
@@ -0,0 +1,75 @@
+#ifndef SHARDED_MAP_H
+#define SHARDED_MAP_H
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace md2 {
+
+// Thread safe hash map that splits the keys into kNumShards shards, each
+// guarded by its own mutex. Values are only erased by Clear(), so the
+// references that are returned remain valid until the next Clear(). The
+// owner must make sure that nobody holds a reference across a Clear().
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedMap {
+ public:
+  static constexpr size_t kNumShards = 16;
+
+  // Returns nullptr if the key is not found.
+  const Value* Find(const Key& key) const {
+    const Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lk(shard.m);
+    if (auto itr = shard.map.find(key); itr != shard.map.end()) {
+      return &itr->second;
+    }
+
+    return nullptr;
+  }
+
+  // Returns the value of the key. If the key does not exist, then it inserts
+  // the value that is computed by compute(). Note that compute() is run
+  // without holding the lock; If multiple threads compute the value of the
+  // same key at the same time, the first inserted value is used.
+  template <typename Compute>
+  const Value& FindOrInsert(const Key& key, Compute compute) {
+    if (const Value* value = Find(key); value != nullptr) {
+      return *value;
+    }
+
+    Value value = compute();
+
+    Shard& shard = GetShard(key);
+    std::lock_guard<std::mutex> lk(shard.m);
+    return shard.map.try_emplace(key, std::move(value)).first->second;
+  }
+
+  // Removes every entry. Note that this invalidates the references that are
+  // returned before, so it must not run while any of them is in use.
+  void Clear() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lk(shard.m);
+      shard.map.clear();
+    }
+  }
+
+ private:
+  struct Shard {
+    mutable std::mutex m;
+    std::unordered_map<Key, Value, Hash> map;
+  };
+
+  Shard& GetShard(const Key& key) {
+    return shards_[Hash{}(key) % kNumShards];
+  }
+  const Shard& GetShard(const Key& key) const {
+    return shards_[Hash{}(key) % kNumShards];
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace md2
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef STATIC_SET_H
+#define STATIC_SET_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace md2 {
+
+// Set of characters that is built at compile time. The lookup is a single bit
+// test.
+class CharSet {
+ public:
+  constexpr explicit CharSet(std::string_view chars) {
+    for (char c : chars) {
+      const auto u = static_cast<unsigned char>(c);
+      bits_[u / 64] |= uint64_t{1} << (u % 64);
+    }
+  }
+
+  constexpr bool Contains(char c) const {
+    const auto u = static_cast<unsigned char>(c);
+    return (bits_[u / 64] >> (u % 64)) & 1;
+  }
+
+ private:
+  std::array<uint64_t, 4> bits_{};
+};
+
+// Set of strings with the perfect hash that is built at compile time (hash
+// and displace). Every key goes to a bucket by its hash, and each bucket picks
+// the seed that sends all of its keys to the empty slots. The lookup hashes
+// the string once and compares against the single candidate key; It never
+// allocates.
+//
+// Use MakeStaticStringSet() to build one. Fails to compile if the keys have a
+// duplicate.
+template <size_t N>
+class StaticStringSet {
+ public:
+  static constexpr int kNotFound = -1;
+
+  consteval explicit StaticStringSet(
+      const std::array<std::string_view, N>& keys)
+      : keys_(keys) {
+    std::array<uint64_t, N> hashes{};
+    std::array<size_t, kNumBuckets> bucket_sizes{};
+    for (size_t i = 0; i < N; i++) {
+      hashes[i] = Hash(keys_[i]);
+      bucket_sizes[BucketOf(hashes[i])]++;
+    }
+
+    // Keys grouped by the bucket. Larger buckets are harder to place so they
+    // go first.
+    std::array<size_t, N> order{};
+    for (size_t i = 0; i < N; i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      const size_t bucket_a = BucketOf(hashes[a]);
+      const size_t bucket_b = BucketOf(hashes[b]);
+      if (bucket_sizes[bucket_a] != bucket_sizes[bucket_b]) {
+        return bucket_sizes[bucket_a] > bucket_sizes[bucket_b];
+      }
+      return bucket_a < bucket_b;
+    });
+
+    slots_.fill(kNotFound);
+    for (size_t first = 0; first < N;) {
+      const size_t bucket = BucketOf(hashes[order[first]]);
+      const size_t last = first + bucket_sizes[bucket];
+
+      uint64_t seed = 0;
+      while (!TryPlaceBucket(order, first, last, seed, hashes)) {
+        seed++;
+        if (seed == kMaxSeed) {
+          // Not a constant expression; Compilation fails here.
+          throw "Keys can not be placed (duplicated?)";
+        }
+      }
+      seeds_[bucket] = seed;
+      first = last;
+    }
+  }
+
+  // Returns the index of the key in the keys that built the set (or
+  // kNotFound).
+  constexpr int Find(std::string_view key) const {
+    const uint64_t hash = Hash(key);
+    const int index = slots_[SlotOf(hash, seeds_[BucketOf(hash)])];
+    return index != kNotFound && keys_[index] == key ? index : kNotFound;
+  }
+
+  constexpr bool Contains(std::string_view key) const {
+    return Find(key) != kNotFound;
+  }
+
+  constexpr size_t MaxKeySize() const {
+    size_t max_size = 0;
+    for (std::string_view key : keys_) {
+      max_size = std::max(max_size, key.size());
+    }
+    return max_size;
+  }
+
+ private:
+  // Load factor of the slots is at most 1/2, so the seeds are found quickly.
+  static constexpr size_t kNumSlots = std::bit_ceil(2 * N);
+  static constexpr size_t kNumBuckets = std::bit_ceil(N / 4 + 1);
+  static constexpr uint64_t kMaxSeed = 1 << 16;
+
+  // FNV-1a.
+  static constexpr uint64_t Hash(std::string_view s) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : s) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // Finalizer of MurmurHash3.
+  static constexpr uint64_t Mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static constexpr size_t BucketOf(uint64_t hash) {
+    return (Mix(hash) >> 32) & (kNumBuckets - 1);
+  }
+
+  static constexpr size_t SlotOf(uint64_t hash, uint64_t seed) {
+    return Mix(hash + (seed + 1) * 0x9e3779b97f4a7c15ull) & (kNumSlots - 1);
+  }
+
+  // Puts the keys order[first, last) (of the same bucket) to the slots with
+  // the seed if none of them collides.
+  constexpr bool TryPlaceBucket(const std::array<size_t, N>& order,
+                                size_t first, size_t last, uint64_t seed,
+                                const std::array<uint64_t, N>& hashes) {
+    for (size_t i = first; i < last; i++) {
+      const size_t slot = SlotOf(hashes[order[i]], seed);
+      if (slots_[slot] != kNotFound) {
+        for (size_t j = first; j < i; j++) {
+          slots_[SlotOf(hashes[order[j]], seed)] = kNotFound;
+        }
+        return false;
+      }
+      slots_[slot] = static_cast<int>(order[i]);
+    }
+    return true;
+  }
+
+  std::array<std::string_view, N> keys_;
+  std::array<uint64_t, kNumBuckets> seeds_{};
+  std::array<int, kNumSlots> slots_{};
+};
+
+// Map from the string to the value with the compile time perfect hash (see
+// StaticStringSet).
+template <typename Value, size_t N>
+class StaticStringMap {
+ public:
+  using Entry = std::pair<std::string_view, Value>;
+
+  consteval explicit StaticStringMap(const std::array<Entry, N>& entries)
+      : keys_(Keys(entries)), entries_(entries) {}
+
+  // Returns nullptr if not found. Note that the key of the entry outlives the
+  // map (it points to the string literal).
+  constexpr const Entry* Find(std::string_view key) const {
+    const int index = keys_.Find(key);
+    return index == StaticStringSet<N>::kNotFound ? nullptr : &entries_[index];
+  }
+
+  constexpr bool Contains(std::string_view key) const {
+    return keys_.Contains(key);
+  }
+
+  constexpr size_t MaxKeySize() const { return keys_.MaxKeySize(); }
+
+ private:
+  static consteval std::array<std::string_view, N> Keys(
+      const std::array<Entry, N>& entries) {
+    std::array<std::string_view, N> keys;
+    for (size_t i = 0; i < N; i++) {
+      keys[i] = entries[i].first;
+    }
+    return keys;
+  }
+
+  StaticStringSet<N> keys_;
+  std::array<Entry, N> entries_;
+};
+
+template <size_t N>
+consteval StaticStringSet<N> MakeStaticStringSet(
+    const std::string_view (&keys)[N]) {
+  return StaticStringSet<N>(std::to_array(keys));
+}
+
+template <typename Value, size_t N>
+consteval StaticStringMap<Value, N> MakeStaticStringMap(
+    const std::pair<std::string_view, Value> (&entries)[N]) {
+  return StaticStringMap<Value, N>(std::to_array(entries));
+}
+
+}  // namespace md2
+
+#endif
@@ -0,0 +1,90 @@
+#include "structural_index.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace md2 {
+namespace {
+
+#if defined(__SSE2__)
+// Returns the mask of the structural characters in the 16 bytes at data.
+uint64_t StructuralMask16(const char* data) {
+  const __m128i chunk =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+
+  // Bytes of the multi byte UTF-8 characters are negative so they are never
+  // in the range of the digits.
+  __m128i mask =
+      _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)),
+                    _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+  for (char c : StructuralIndex::kStructuralChars) {
+    mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)));
+  }
+
+  return static_cast<uint32_t>(_mm_movemask_epi8(mask));
+}
+#endif
+
+}  // namespace
+
+StructuralIndex::StructuralIndex(std::string_view content)
+    : StructuralIndex(content, 0, content.size()) {}
+
+StructuralIndex::StructuralIndex(std::string_view content, size_t begin,
+                                 size_t end)
+    : content_(content),
+      begin_(std::min(begin, content.size())),
+      end_(std::clamp(end, begin_, content.size())),
+      bits_((end_ - begin_ + 63) / 64, 0) {
+  const std::string_view indexed = content.substr(begin_, end_ - begin_);
+
+  size_t pos = 0;
+#if defined(__SSE2__)
+  for (; pos + 16 <= indexed.size(); pos += 16) {
+    bits_[pos / 64] |= StructuralMask16(indexed.data() + pos) << (pos % 64);
+  }
+#endif
+
+  for (; pos < indexed.size(); pos++) {
+    if (IsStructuralChar(indexed[pos])) {
+      bits_[pos / 64] |= uint64_t{1} << (pos % 64);
+    }
+  }
+}
+
+size_t StructuralIndex::NextStructural(size_t pos) const {
+  if (pos >= content_.size()) {
+    return content_.size();
+  }
+  if (pos < begin_ || pos >= end_) {
+    return pos;
+  }
+
+  size_t word = (pos - begin_) / 64;
+  uint64_t bits = bits_[word] & (~uint64_t{0} << ((pos - begin_) % 64));
+  while (bits == 0) {
+    if (++word == bits_.size()) {
+      // Note that end_ is the size of the content if everything is indexed.
+      return end_;
+    }
+    bits = bits_[word];
+  }
+
+  return begin_ + word * 64 + std::countr_zero(bits);
+}
+
+size_t DelimiterFinder::Find(std::string_view content, size_t pos) {
+  if (searched_from_ == std::string_view::npos || pos < searched_from_ ||
+      (found_ != std::string_view::npos && pos > found_)) {
+    searched_from_ = pos;
+    found_ = content.find(delimiter_, pos);
+  }
+
+  return found_;
+}
+
+}  // namespace md2
@@ -0,0 +1,92 @@
+#ifndef STRUCTURAL_INDEX_H
+#define STRUCTURAL_INDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace md2 {
+
+// Bitmap of the positions in the content that can start (or end) a markdown
+// syntax. Every other byte (e.g the Korean text) is a plain text for the
+// parser, so the parser can jump between the structural positions instead of
+// examining every byte.
+//
+// The bitmap is built in a single pass that checks 16 bytes at a time with
+// SSE2 (if available).
+class StructuralIndex {
+ public:
+  StructuralIndex() = default;
+  explicit StructuralIndex(std::string_view content);
+
+  // Only indexes [begin, end) of the content (e.g the part of the content that
+  // is parsed again after an edit). Every position outside of it is treated
+  // as structural, so the parser examines those byte by byte.
+  StructuralIndex(std::string_view content, size_t begin, size_t end);
+
+  // Returns the first structural position that is at or after pos. Returns
+  // the size of the content if there is none.
+  size_t NextStructural(size_t pos) const;
+
+  bool IsStructural(size_t pos) const {
+    if (pos < begin_ || pos >= end_) {
+      return true;
+    }
+    pos -= begin_;
+    return (bits_[pos / 64] >> (pos % 64)) & 1;
+  }
+
+  // True if the index is built from the content.
+  bool IsIndexOf(std::string_view content) const {
+    return content.data() == content_.data() &&
+           content.size() == content_.size();
+  }
+
+  // Characters that can start the markdown syntax (including the first
+  // characters of the end parsing tokens of the nested parsers; "]", ")" and
+  // "}"). Digits are structural as well since they can start an ordered list.
+  static constexpr std::string_view kStructuralChars = "\n!#$)*>[\\]`|}~";
+
+  static constexpr bool IsStructuralChar(char c) {
+    return ('0' <= c && c <= '9') ||
+           kStructuralChars.find(c) != std::string_view::npos;
+  }
+
+ private:
+  std::string_view content_;
+
+  // Indexed range of the content. The bits start at begin_.
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  std::vector<uint64_t> bits_;
+};
+
+// Finds the next occurrence of the delimiter (e.g the "$$" that closes the
+// math) in the content. The result of the last search is remembered, so the
+// searches from the increasing positions (which is what the parser does for
+// every unclosed delimiter) scan each byte of the content only once.
+class DelimiterFinder {
+ public:
+  explicit DelimiterFinder(std::string_view delimiter)
+      : delimiter_(delimiter) {}
+
+  // Returns the position of the first delimiter that starts at or after pos.
+  // Returns npos if there is none.
+  size_t Find(std::string_view content, size_t pos);
+
+  size_t DelimiterSize() const { return delimiter_.size(); }
+
+  // Must be called before searching the different content.
+  void Reset() { searched_from_ = std::string_view::npos; }
+
+ private:
+  std::string_view delimiter_;
+
+  // There is no delimiter in [searched_from_, found_).
+  size_t searched_from_ = std::string_view::npos;
+  size_t found_ = std::string_view::npos;
+};
+
+}  // namespace md2
+
+#endif
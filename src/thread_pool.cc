@@ -0,0 +1,223 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+
+#include "logger.h"
+
+namespace md2 {
+namespace {
+
+// Index of the worker that runs on the current thread (if any) and the pool
+// that owns it.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker_index = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  num_threads = std::max<size_t>(num_threads, 1);
+
+  workers_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.emplace_back([this, i]() { RunWorker(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  for (const auto& error : WaitAll()) {
+    LOG(0) << "Task " << error.task_id << " failed : " << error.message;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+  }
+  work_available_.notify_all();
+
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t ThreadPool::Submit(Task task, TaskGroup* group) {
+  const size_t task_id = next_task_id_++;
+
+  // Tasks that are submitted by the worker go to its own deque.
+  size_t worker_index = current_pool == this
+                            ? current_worker_index
+                            : next_worker_++ % workers_.size();
+
+  // Counted before the task is visible to the workers.
+  num_pending_++;
+  if (group != nullptr) {
+    std::lock_guard<std::mutex> lk(group->m_);
+    group->num_pending_++;
+  }
+  num_queued_++;
+
+  {
+    Worker& worker = *workers_[worker_index];
+    std::lock_guard<std::mutex> lk(worker.m);
+    worker.tasks.push_back(Entry{task_id, std::move(task), group});
+  }
+  WakeWorker();
+
+  return task_id;
+}
+
+void ThreadPool::WakeWorker() {
+  // The sleeping worker increments num_sleeping_ before it checks
+  // num_queued_, so either it sees the new task or it is seen here.
+  if (num_sleeping_ == 0) {
+    return;
+  }
+
+  // Taking m_ makes sure that the worker is either waiting or has not checked
+  // num_queued_ yet.
+  { std::lock_guard<std::mutex> lk(m_); }
+  work_available_.notify_one();
+}
+
+std::vector<TaskError> ThreadPool::WaitAll() {
+  {
+    std::unique_lock<std::mutex> lk(m_);
+    all_done_.wait(lk, [this] { return num_pending_ == 0; });
+  }
+
+  std::lock_guard<std::mutex> lk(m_errors_);
+  return std::exchange(errors_, {});
+}
+
+void ThreadPool::Wait(TaskGroup& group) {
+  // The own deque is searched first if this is a worker.
+  const size_t worker_index = current_pool == this ? current_worker_index : 0;
+
+  while (true) {
+    Entry entry;
+    if (TryGetGroupTask(worker_index, group, &entry)) {
+      RunTask(entry);
+      continue;
+    }
+
+    // Remaining tasks are running on the other threads. Wakes up once any of
+    // them is finished (or a new task is added to the group by them).
+    std::unique_lock<std::mutex> lk(group.m_);
+    const size_t num_pending = group.num_pending_;
+    if (num_pending == 0) {
+      return;
+    }
+    group.done_.wait(lk, [&group, num_pending] {
+      return group.num_pending_ != num_pending;
+    });
+  }
+}
+
+void ThreadPool::RunWorker(size_t worker_index) {
+  current_pool = this;
+  current_worker_index = worker_index;
+
+  while (true) {
+    Entry entry;
+    if (TryGetTask(worker_index, &entry)) {
+      RunTask(entry);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lk(m_);
+    num_sleeping_++;
+    work_available_.wait(lk, [this] { return stop_ || num_queued_ > 0; });
+    num_sleeping_--;
+    if (stop_ && num_queued_ == 0) {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::TryGetTask(size_t worker_index, Entry* entry) {
+  {
+    Worker& worker = *workers_[worker_index];
+    std::lock_guard<std::mutex> lk(worker.m);
+    if (!worker.tasks.empty()) {
+      *entry = std::move(worker.tasks.front());
+      worker.tasks.pop_front();
+      num_queued_--;
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < workers_.size(); i++) {
+    Worker& victim = *workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lk(victim.m);
+    if (!victim.tasks.empty()) {
+      *entry = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      num_queued_--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ThreadPool::TryGetGroupTask(size_t worker_index, const TaskGroup& group,
+                                 Entry* entry) {
+  for (size_t i = 0; i < workers_.size(); i++) {
+    Worker& worker = *workers_[(worker_index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lk(worker.m);
+    auto itr = std::find_if(
+        worker.tasks.rbegin(), worker.tasks.rend(),
+        [&group](const Entry& queued) { return queued.group == &group; });
+    if (itr != worker.tasks.rend()) {
+      *entry = std::move(*itr);
+      worker.tasks.erase(std::next(itr).base());
+      num_queued_--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::RunTask(Entry& entry) {
+  std::string error;
+  bool failed = false;
+  try {
+    entry.task();
+  } catch (const std::exception& e) {
+    failed = true;
+    error = e.what();
+  } catch (...) {
+    failed = true;
+    error = "Unknown exception";
+  }
+
+  // Destroy the task (and its captures) before reporting the completion.
+  entry.task = Task();
+
+  if (failed) {
+    std::lock_guard<std::mutex> lk(m_errors_);
+    errors_.push_back(TaskError{entry.task_id, std::move(error)});
+  }
+
+  if (entry.group != nullptr) {
+    // Notified under the lock since the waiter may destroy the group as soon
+    // as it sees the last task finished.
+    std::lock_guard<std::mutex> lk(entry.group->m_);
+    entry.group->num_pending_--;
+    entry.group->done_.notify_all();
+  }
+
+  if (--num_pending_ == 0) {
+    { std::lock_guard<std::mutex> lk(m_); }
+    all_done_.notify_all();
+  }
+}
+
+}  // namespace md2
@@ -1,92 +1,242 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
-#include <functional>
-#include <future>
+#include <cstddef>
+#include <deque>
 #include <memory>
 #include <mutex>
-#include <queue>
-#include <stdexcept>
+#include <new>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace md2 {
 
+// Move-only type erased void() callable. Callables that fit in kInlineSize
+// are stored inline so constructing a task does not allocate.
+class Task {
+ public:
+  static constexpr size_t kInlineSize = 64;
+
+  Task() = default;
+
+  template <typename F, typename = std::enable_if_t<
+                            !std::is_same_v<std::decay_t<F>, Task>>>
+  Task(F&& f) {
+    using Fn = std::decay_t<F>;
+    if constexpr (sizeof(Fn) <= kInlineSize &&
+                  alignof(Fn) <= alignof(std::max_align_t) &&
+                  std::is_nothrow_move_constructible_v<Fn>) {
+      new (storage_) Fn(std::forward<F>(f));
+      ops_ = &kInlineOps<Fn>;
+    } else {
+      new (storage_) Fn*(new Fn(std::forward<F>(f)));
+      ops_ = &kHeapOps<Fn>;
+    }
+  }
+
+  Task(Task&& task) noexcept : ops_(task.ops_) {
+    if (ops_ != nullptr) {
+      ops_->move(storage_, task.storage_);
+      task.ops_ = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& task) noexcept {
+    if (this != &task) {
+      Reset();
+      ops_ = task.ops_;
+      if (ops_ != nullptr) {
+        ops_->move(storage_, task.storage_);
+        task.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() { Reset(); }
+
+  void operator()() { ops_->invoke(storage_); }
+  explicit operator bool() const { return ops_ != nullptr; }
+
+ private:
+  struct Ops {
+    void (*invoke)(void* storage);
+
+    // Move constructs dst from src and destroys src.
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* storage);
+  };
+
+  template <typename Fn>
+  static constexpr Ops kInlineOps = {
+      [](void* s) { (*static_cast<Fn*>(s))(); },
+      [](void* dst, void* src) {
+        new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+        static_cast<Fn*>(src)->~Fn();
+      },
+      [](void* s) { static_cast<Fn*>(s)->~Fn(); }};
+
+  template <typename Fn>
+  static constexpr Ops kHeapOps = {
+      [](void* s) { (**static_cast<Fn**>(s))(); },
+      [](void* dst, void* src) { new (dst) Fn*(*static_cast<Fn**>(src)); },
+      [](void* s) { delete *static_cast<Fn**>(s); }};
+
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  const Ops* ops_ = nullptr;
+};
+
+// Exception thrown by the task.
+struct TaskError {
+  // Id that was returned by ThreadPool::Submit.
+  size_t task_id;
+  std::string message;
+};
+
+// Tasks that are waited for together (see ThreadPool::Wait). The group must
+// outlive its tasks.
+class TaskGroup {
+ private:
+  friend class ThreadPool;
+
+  std::mutex m_;
+  std::condition_variable done_;
+
+  // Number of tasks in the group that are not finished. Guarded by m_.
+  size_t num_pending_ = 0;
+};
+
+// Work stealing thread pool. Every worker owns a deque of tasks; The worker
+// runs the tasks from the front of its own deque and steals from the back of
+// the other workers' deques once its own deque is empty.
+//
+// Tasks submitted from outside of the pool are distributed to the workers in
+// the round robin fashion. Hence if the tasks are submitted in the decreasing
+// order of the cost (see SubmitByCost), every worker starts with the most
+// expensive tasks and the cheap tasks are stolen at the end (which is the
+// longest-processing-time-first scheduling).
 class ThreadPool {
  public:
-  ThreadPool(size_t);
-  template <class F, class... Args>
-  auto enqueue(F&& f, Args&&... args)
-      -> std::future<typename std::result_of<F(Args...)>::type>;
+  explicit ThreadPool(size_t num_threads);
+
+  // Waits until every submitted task is finished.
   ~ThreadPool();
 
+  // Returns the id of the submitted task. If the group is given, the task can
+  // be waited for with Wait(group).
+  size_t Submit(Task task, TaskGroup* group = nullptr);
+
+  // Submits fn(item) for every item in the decreasing order of cost(item).
+  // Returns the task id of each item (in the order of items).
+  template <typename Item, typename Fn, typename CostFn>
+  std::vector<size_t> SubmitByCost(const std::vector<Item>& items, Fn fn,
+                                   CostFn cost);
+
+  // Blocks until every submitted task is finished. Returns the errors of the
+  // tasks that threw since the last WaitAll.
+  std::vector<TaskError> WaitAll();
+
+  // Blocks until every task of the group is finished. While waiting, the
+  // calling thread runs the queued tasks of the group (the latest one first),
+  // so a task can wait for the tasks that it submitted without idling the
+  // worker. Tasks that are not in the group are never run here.
+  void Wait(TaskGroup& group);
+
+  size_t NumThreads() const { return workers_.size(); }
+
  private:
-  // need to keep track of threads so we can join them
-  std::vector<std::thread> workers_;
+  struct Entry {
+    size_t task_id;
+    Task task;
+    TaskGroup* group = nullptr;
+  };
 
-  // the task queue
-  std::queue<std::function<void()>> tasks_;
+  struct Worker {
+    std::mutex m;
+    std::deque<Entry> tasks;
+  };
 
-  // synchronization
-  std::mutex queue_mutex_;
-  std::condition_variable condition_;
-  bool stop_;
-};
+  void RunWorker(size_t worker_index);
 
-// the constructor just launches some amount of workers
-inline ThreadPool::ThreadPool(size_t threads) : stop_(false) {
-  for (size_t i = 0; i < threads; ++i)
-    workers_.emplace_back([this] {
-      while (true) {
-        std::function<void()> task;
-        {
-          std::unique_lock<std::mutex> lock(this->queue_mutex_);
-          this->condition_.wait(
-              lock, [this] { return this->stop_ || !this->tasks_.empty(); });
-          if (this->stop_ && this->tasks_.empty()) return;
-          task = std::move(this->tasks_.front());
-          this->tasks_.pop();
-        }
-        task();
-      }
-    });
-}
+  // Pops the task from the front of the own deque or steals from the back of
+  // the other deques. Returns false if there is no task at all.
+  bool TryGetTask(size_t worker_index, Entry* entry);
 
-// add new work item to the pool
-template <class F, class... Args>
-auto ThreadPool::enqueue(F&& f, Args&&... args)
-    -> std::future<typename std::result_of<F(Args...)>::type> {
-  using return_type = typename std::result_of<F(Args...)>::type;
+  // Takes the latest queued task of the group. The own deque is searched
+  // first. Returns false if every task of the group is running or finished.
+  bool TryGetGroupTask(size_t worker_index, const TaskGroup& group,
+                       Entry* entry);
 
-  auto task = std::make_shared<std::packaged_task<return_type()>>(
-      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+  // Wakes up a sleeping worker (if any) for the newly queued task.
+  void WakeWorker();
 
-  std::future<return_type> res = task->get_future();
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
+  void RunTask(Entry& entry);
 
-    // don't allow enqueueing after stopping the pool
-    if (stop_) throw std::runtime_error("enqueue on stopped ThreadPool");
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
 
-    tasks_.emplace([task]() { (*task)(); });
-  }
-  condition_.notify_one();
-  return res;
-}
+  std::atomic<size_t> next_task_id_ = 0;
+  std::atomic<size_t> next_worker_ = 0;
+
+  // Number of tasks that are in the deques.
+  std::atomic<size_t> num_queued_ = 0;
+
+  // Number of tasks that are submitted but not finished.
+  std::atomic<size_t> num_pending_ = 0;
+
+  // Number of workers that are sleeping on work_available_.
+  std::atomic<size_t> num_sleeping_ = 0;
+
+  // Only used to park the idle workers (and the threads in WaitAll).
+  std::mutex m_;
+  std::condition_variable work_available_;
+  std::condition_variable all_done_;
+  bool stop_ = false;  // Guarded by m_.
 
-// the destructor joins all threads
-inline ThreadPool::~ThreadPool() {
-  {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
-    stop_ = true;
+  std::mutex m_errors_;
+  std::vector<TaskError> errors_;  // Guarded by m_errors_.
+};
+
+template <typename Item, typename Fn, typename CostFn>
+std::vector<size_t> ThreadPool::SubmitByCost(const std::vector<Item>& items,
+                                             Fn fn, CostFn cost) {
+  std::vector<std::pair<size_t, size_t>> cost_and_index;
+  cost_and_index.reserve(items.size());
+  for (size_t i = 0; i < items.size(); i++) {
+    cost_and_index.emplace_back(cost(items[i]), i);
   }
-  condition_.notify_all();
-  for (std::thread& worker : workers_) {
-    worker.join();
+
+  // Ties are broken by the original order.
+  std::stable_sort(cost_and_index.begin(), cost_and_index.end(),
+                   [](const auto& left, const auto& right) {
+                     return left.first > right.first;
+                   });
+
+  std::vector<size_t> task_ids(items.size());
+  for (const auto& [item_cost, index] : cost_and_index) {
+    const Item* item = &items[index];
+    task_ids[index] = Submit([fn, item]() { fn(*item); });
   }
-}
 
+  return task_ids;
 }
 
+}  // namespace md2
+
 #endif
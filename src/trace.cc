@@ -0,0 +1,158 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+
+#include "logger.h"
+
+namespace md2 {
+namespace {
+
+using json = nlohmann::json;
+
+// File of the innermost span in the current thread.
+thread_local std::string_view current_file;
+thread_local int current_depth = 0;
+
+}  // namespace
+
+Tracer& Tracer::GetTracer() {
+  static Tracer tracer;
+  return tracer;
+}
+
+void Tracer::Enable() {
+  std::lock_guard<std::mutex> lk(m_);
+  if (!enabled_) {
+    start_time_ = Clock::now();
+    enabled_ = true;
+  }
+}
+
+Tracer::ThreadBuffer& Tracer::GetThreadBuffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer;
+  if (buffer == nullptr) {
+    buffer = std::make_shared<ThreadBuffer>();
+
+    std::lock_guard<std::mutex> lk(m_);
+    buffer->thread_index = buffers_.size();
+    buffers_.push_back(buffer);
+  }
+
+  return *buffer;
+}
+
+void Tracer::AddSpan(Span span) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  span.thread_index = buffer.thread_index;
+
+  std::lock_guard<std::mutex> lk(buffer.m);
+  buffer.spans.push_back(std::move(span));
+}
+
+std::vector<Tracer::Span> Tracer::GetSpans() const {
+  std::lock_guard<std::mutex> lk(m_);
+
+  std::vector<Span> spans;
+  for (const auto& buffer : buffers_) {
+    std::lock_guard<std::mutex> buffer_lk(buffer->m);
+    spans.insert(spans.end(), buffer->spans.begin(), buffer->spans.end());
+  }
+
+  return spans;
+}
+
+std::string Tracer::DumpAsChromeTrace() const {
+  auto to_us = [](Clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+  };
+
+  json events = json::array();
+  for (const Span& span : GetSpans()) {
+    json event;
+    event["name"] = span.name;
+    event["cat"] = "md2";
+    event["ph"] = "X";
+    event["ts"] = to_us(span.start - start_time_);
+    event["dur"] = to_us(span.end - span.start);
+    event["pid"] = 1;
+    event["tid"] = span.thread_index;
+    if (!span.file.empty()) {
+      event["args"]["file"] = span.file;
+    }
+    events.push_back(std::move(event));
+  }
+
+  json trace;
+  trace["traceEvents"] = std::move(events);
+  trace["displayTimeUnit"] = "ms";
+  return trace.dump();
+}
+
+bool Tracer::WriteChromeTrace(const std::string& path) const {
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    LOG(0) << "Unable to write the trace to " << path;
+    return false;
+  }
+
+  out << DumpAsChromeTrace();
+  return out.good();
+}
+
+std::vector<std::pair<std::string, Tracer::Clock::duration>>
+Tracer::GetSlowestFiles(size_t num_files) const {
+  std::unordered_map<std::string, Clock::duration> file_to_duration;
+  for (const Span& span : GetSpans()) {
+    // Nested spans are already included in the outermost span.
+    if (span.file.empty() || span.depth != 0) {
+      continue;
+    }
+
+    file_to_duration[std::filesystem::path(span.file).stem()] +=
+        span.end - span.start;
+  }
+
+  std::vector<std::pair<std::string, Clock::duration>> files(
+      file_to_duration.begin(), file_to_duration.end());
+  std::sort(files.begin(), files.end(), [](const auto& left, const auto& right) {
+    if (left.second != right.second) {
+      return left.second > right.second;
+    }
+    return left.first < right.first;
+  });
+
+  if (files.size() > num_files) {
+    files.resize(num_files);
+  }
+  return files;
+}
+
+void TraceScope::Begin(const char* name, std::string_view file) {
+  name_ = name;
+  prev_file_ = current_file;
+  file_ = file.empty() ? current_file : file;
+  current_file = file_;
+  current_depth++;
+
+  start_ = Tracer::Clock::now();
+}
+
+void TraceScope::End() {
+  Tracer::Clock::time_point end = Tracer::Clock::now();
+
+  current_file = prev_file_;
+  current_depth--;
+
+  Tracer::GetTracer().AddSpan(Tracer::Span{.name = name_,
+                                           .file = std::string(file_),
+                                           .start = start_,
+                                           .end = end,
+                                           .thread_index = 0,
+                                           .depth = current_depth});
+}
+
+}  // namespace md2
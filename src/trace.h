@@ -0,0 +1,123 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace md2 {
+
+// Collects the time spans of the build stages. Every thread records the spans
+// into its own buffer so recording does not contend on a lock. When the
+// tracer is disabled (which is the default), TRACE_SCOPE only costs a relaxed
+// atomic load.
+class Tracer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Span {
+    // Name of the stage (e.g "parse"). Must be a string literal.
+    const char* name;
+
+    // File that the span belongs to (empty if none).
+    std::string file;
+
+    Clock::time_point start;
+    Clock::time_point end;
+
+    // Index of the thread that recorded the span.
+    size_t thread_index;
+
+    // Number of the enclosing spans in the same thread.
+    int depth;
+  };
+
+  static Tracer& GetTracer();
+
+  void Enable();
+  bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void AddSpan(Span span);
+
+  // Returns the spans that are recorded so far (in no particular order).
+  std::vector<Span> GetSpans() const;
+
+  // Chrome trace event format (can be opened at chrome://tracing or
+  // ui.perfetto.dev).
+  std::string DumpAsChromeTrace() const;
+  bool WriteChromeTrace(const std::string& path) const;
+
+  // Returns the num_files files that took the longest, along with the total
+  // duration of their outermost spans. Outputs are grouped with their source
+  // file by the file stem (e.g 123.md and 123.html).
+  std::vector<std::pair<std::string, Clock::duration>> GetSlowestFiles(
+      size_t num_files) const;
+
+ private:
+  Tracer() = default;
+
+  struct ThreadBuffer {
+    // Only contends when the spans are read.
+    std::mutex m;
+    std::vector<Span> spans;
+    size_t thread_index;
+  };
+
+  ThreadBuffer& GetThreadBuffer();
+
+  std::atomic<bool> enabled_ = false;
+  Clock::time_point start_time_;
+
+  mutable std::mutex m_;
+
+  // Buffers of every thread that has recorded a span. Kept alive after the
+  // thread exits.
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+// Records the span from the construction to the destruction. If the file is
+// empty, the span belongs to the file of the enclosing span (e.g the
+// clang-format run while generating a file).
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name, std::string_view file = {}) {
+    if (Tracer::GetTracer().IsEnabled()) {
+      Begin(name, file);
+    }
+  }
+
+  ~TraceScope() {
+    if (name_ != nullptr) {
+      End();
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  void Begin(const char* name, std::string_view file);
+  void End();
+
+  const char* name_ = nullptr;
+  std::string_view file_;
+  std::string_view prev_file_;
+  Tracer::Clock::time_point start_;
+};
+
+}  // namespace md2
+
+#define MD2_TRACE_CONCAT_INNER(a, b) a##b
+#define MD2_TRACE_CONCAT(a, b) MD2_TRACE_CONCAT_INNER(a, b)
+
+// TRACE_SCOPE(name) or TRACE_SCOPE(name, file)
+#define TRACE_SCOPE(...) \
+  md2::TraceScope MD2_TRACE_CONCAT(trace_scope_, __LINE__)(__VA_ARGS__)
+
+#endif
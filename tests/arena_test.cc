@@ -0,0 +1,137 @@
+#include "arena.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "parse_tree.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+bool IsAligned(const void* ptr, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST(ArenaTest, Allocate) {
+  Arena arena(/*block_size=*/128);
+
+  void* a = arena.Allocate(3, 1);
+  void* b = arena.Allocate(8, 8);
+  void* c = arena.Allocate(16, 16);
+  EXPECT_TRUE(IsAligned(b, 8));
+  EXPECT_TRUE(IsAligned(c, 16));
+  EXPECT_NE(a, b);
+  EXPECT_NE(b, c);
+  EXPECT_EQ(arena.Capacity(), 128);
+  EXPECT_EQ(arena.BytesUsed(), 27);
+}
+
+TEST(ArenaTest, AllocateLargerThanBlock) {
+  Arena arena(/*block_size=*/64);
+
+  arena.Allocate(10, 1);
+  void* large = arena.Allocate(1000, 8);
+  EXPECT_TRUE(IsAligned(large, 8));
+  EXPECT_GE(arena.Capacity(), 1064);
+}
+
+TEST(ArenaTest, ResetReusesMemory) {
+  Arena arena(/*block_size=*/128);
+
+  void* first = arena.Allocate(100, 8);
+  arena.Reset();
+  EXPECT_EQ(arena.BytesUsed(), 0);
+  EXPECT_EQ(arena.Allocate(100, 8), first);
+  EXPECT_EQ(arena.Capacity(), 128);
+}
+
+TEST(ArenaTest, ResetMergesBlocks) {
+  Arena arena(/*block_size=*/128);
+  for (int i = 0; i < 10; i++) {
+    arena.Allocate(100, 8);
+  }
+  const size_t capacity = arena.Capacity();
+  EXPECT_GE(capacity, 1000);
+
+  arena.Reset();
+  EXPECT_EQ(arena.Capacity(), capacity);
+
+  // Everything fits in the merged block now.
+  for (int i = 0; i < 10; i++) {
+    arena.Allocate(100, 8);
+  }
+  EXPECT_EQ(arena.Capacity(), capacity);
+}
+
+TEST(ArenaTest, Adopt) {
+  Arena arena(/*block_size=*/128);
+  arena.Allocate(100, 8);
+
+  auto other = std::make_unique<Arena>(/*block_size=*/256);
+  int* value = other->Create<int>(42);
+  arena.Adopt(std::move(other));
+
+  EXPECT_EQ(*value, 42);
+  EXPECT_EQ(arena.Capacity(), 128 + 256);
+  EXPECT_EQ(arena.BytesUsed(), 100 + sizeof(int));
+
+  // Allocation continues in the own block.
+  void* ptr = arena.Allocate(16, 8);
+  EXPECT_EQ(arena.Capacity(), 128 + 256);
+  EXPECT_NE(ptr, nullptr);
+}
+
+TEST(ArenaTest, PmrVector) {
+  Arena arena;
+
+  std::pmr::vector<int> v(&arena);
+  for (int i = 0; i < 1000; i++) {
+    v.push_back(i);
+  }
+  EXPECT_EQ(v[999], 999);
+  EXPECT_GE(arena.BytesUsed(), 1000 * sizeof(int));
+}
+
+TEST(ArenaPoolTest, ReusesReleasedArena) {
+  ArenaPool pool;
+
+  std::unique_ptr<Arena> arena = pool.Acquire();
+  arena->Allocate(100, 8);
+  Arena* arena_ptr = arena.get();
+  pool.Release(std::move(arena));
+
+  std::unique_ptr<Arena> reused = pool.Acquire();
+  EXPECT_EQ(reused.get(), arena_ptr);
+  EXPECT_EQ(reused->BytesUsed(), 0);
+
+  std::unique_ptr<Arena> fresh = pool.Acquire();
+  EXPECT_NE(fresh.get(), arena_ptr);
+}
+
+TEST(ArenaPoolTest, ParseTreeReleasesArena) {
+  std::string_view content = "# title\n\n* a\n* b\n\n[link](url) **bold**";
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+  ASSERT_EQ(tree.GetRoot()->GetChildren().size(), 4);
+
+  std::unique_ptr<Arena> arena = std::move(tree).ReleaseArena();
+  ASSERT_NE(arena, nullptr);
+  EXPECT_EQ(arena->BytesUsed(), 0);
+
+  // The next document is built in the same arena.
+  Arena* arena_ptr = arena.get();
+  ParseTree next = parser.GenerateParseTree(content, std::move(arena));
+  EXPECT_EQ(next.GetRoot()->GetChildren().size(), 4);
+
+  arena = std::move(next).ReleaseArena();
+  EXPECT_EQ(arena.get(), arena_ptr);
+}
+
+}  // namespace
+}  // namespace md2
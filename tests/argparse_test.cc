@@ -63,6 +63,63 @@ TEST(ArgParseTest, BooleanOption) {
   EXPECT_EQ(option.generate_latex, false);
 }
 
+TEST(ArgParseTest, IncrementalOption) {
+  std::string param = R"(./md2 -incremental -output_dir /home)";
+  auto str_vec = SplitStringByCharToStringVec(param, ' ');
+  auto argv = ConstructArgvFromString(str_vec);
+
+  const DriverOptions option = ArgParse::EmitOption(argv.size(), argv.data());
+
+  EXPECT_EQ(option.output_dir, "/home");
+  EXPECT_EQ(option.incremental, true);
+}
+
+TEST(ArgParseTest, WatchOption) {
+  std::string param = R"(./md2 -watch -output_dir /home)";
+  auto str_vec = SplitStringByCharToStringVec(param, ' ');
+  auto argv = ConstructArgvFromString(str_vec);
+
+  const DriverOptions option = ArgParse::EmitOption(argv.size(), argv.data());
+
+  EXPECT_EQ(option.output_dir, "/home");
+  EXPECT_EQ(option.watch, true);
+}
+
+TEST(ArgParseTest, TraceOption) {
+  std::string param = R"(./md2 -trace /tmp/trace.json -output_dir /home)";
+  auto str_vec = SplitStringByCharToStringVec(param, ' ');
+  auto argv = ConstructArgvFromString(str_vec);
+
+  const DriverOptions option = ArgParse::EmitOption(argv.size(), argv.data());
+
+  EXPECT_EQ(option.output_dir, "/home");
+  EXPECT_EQ(option.trace_path, "/tmp/trace.json");
+}
+
+TEST(ArgParseTest, ParallelParseMinSizeOption) {
+  std::string param =
+      R"(./md2 -parallel_parse_min_size 4096 -output_dir /home)";
+  auto str_vec = SplitStringByCharToStringVec(param, ' ');
+  auto argv = ConstructArgvFromString(str_vec);
+
+  const DriverOptions option = ArgParse::EmitOption(argv.size(), argv.data());
+
+  EXPECT_EQ(option.output_dir, "/home");
+  EXPECT_EQ(option.parallel_parse_min_size, 4096);
+}
+
+TEST(ArgParseTest, ParseTreeCacheDirOption) {
+  std::string param =
+      R"(./md2 -parse_tree_cache_dir /tmp/trees -output_dir /home)";
+  auto str_vec = SplitStringByCharToStringVec(param, ' ');
+  auto argv = ConstructArgvFromString(str_vec);
+
+  const DriverOptions option = ArgParse::EmitOption(argv.size(), argv.data());
+
+  EXPECT_EQ(option.output_dir, "/home");
+  EXPECT_EQ(option.parse_tree_cache_dir, "/tmp/trees");
+}
+
 TEST(ArgParseTest, PairOption) {
   std::string param = R"(./md2 -book_to_dir "135:/home/cpp,231:/home/c")";
   auto str_vec = SplitStringByCharToStringVec(param, ' ');
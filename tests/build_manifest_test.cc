@@ -0,0 +1,85 @@
+#include "build_manifest.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "metadata_repo.h"
+
+namespace md2 {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsNull;
+using ::testing::Pair;
+
+TEST(BuildManifestTest, DumpAndParse) {
+  BuildManifest manifest;
+  manifest.SetOptionsFingerprint("html:latex");
+
+  BuildManifest::Entry entry;
+  entry.content_hash = "abc";
+  entry.metadata_hash = "def";
+  entry.book_dir = "/book";
+  entry.dependencies.refs["vector"] = "123";
+  entry.dependencies.html_images["img/a"] = "img/a.webp";
+  manifest.SetEntry("1.md", entry);
+
+  auto parsed = BuildManifest::ParseFromJson(manifest.DumpAsJson());
+  ASSERT_TRUE(parsed);
+  EXPECT_EQ(parsed->GetOptionsFingerprint(), "html:latex");
+
+  const BuildManifest::Entry* parsed_entry = parsed->FindEntry("1.md");
+  ASSERT_TRUE(parsed_entry);
+  EXPECT_EQ(parsed_entry->content_hash, "abc");
+  EXPECT_EQ(parsed_entry->metadata_hash, "def");
+  EXPECT_EQ(parsed_entry->book_dir, "/book");
+  EXPECT_THAT(parsed_entry->dependencies.refs,
+              ElementsAre(Pair("vector", "123")));
+  EXPECT_THAT(parsed_entry->dependencies.html_images,
+              ElementsAre(Pair("img/a", "img/a.webp")));
+  EXPECT_TRUE(parsed_entry->dependencies.latex_images.empty());
+
+  EXPECT_THAT(parsed->FindEntry("2.md"), IsNull());
+}
+
+TEST(BuildManifestTest, MalformedManifest) {
+  EXPECT_FALSE(BuildManifest::ParseFromJson("{abc"));
+  EXPECT_FALSE(BuildManifest::ParseFromJson("[]"));
+  EXPECT_FALSE(BuildManifest::ParseFromJson(R"({"version":0,"files":{}})"));
+  EXPECT_FALSE(BuildManifest::ParseFromJson(
+      R"({"version":1,"options":"","files":{"a.md":{}}})"));
+}
+
+TEST(BuildManifestTest, LoadNonExistingManifest) {
+  BuildManifest manifest = BuildManifest::Load("/non/existing/manifest.json");
+  EXPECT_TRUE(manifest.GetEntries().empty());
+}
+
+TEST(BuildManifestTest, RecordReferences) {
+  MetadataRepo repo;
+  size_t end = 0;
+  repo.RegisterMetadata("123.md", MetadataFactory::ParseMetadata("123.md", R"(
+----------------
+title : vector
+ref_title : vector
+----------------
+)",
+                                                                 end));
+
+  GeneratorContext context(repo, "", false, 0, nullptr);
+
+  GeneratorDependencies dependencies;
+  {
+    ScopedDependencyRecorder recorder(&dependencies);
+    context.FindReference("vector");
+    context.FindReference("list");
+  }
+
+  // Not recorded since the recorder is gone.
+  context.FindReference("map");
+
+  EXPECT_THAT(dependencies.refs,
+              ElementsAre(Pair("list", ""), Pair("vector", "123")));
+}
+
+}  // namespace
+}  // namespace md2
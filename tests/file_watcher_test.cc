@@ -0,0 +1,75 @@
+#include "file_watcher.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+using ::testing::UnorderedElementsAre;
+
+class FileWatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = fs::temp_directory_path() /
+           ("md2_file_watcher_test_" + std::to_string(getpid()));
+    fs::create_directories(dir_ / "sub");
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  void WriteFile(const fs::path& path, const std::string& content) {
+    std::ofstream out(path);
+    out << content;
+  }
+
+  fs::path dir_;
+};
+
+TEST_F(FileWatcherTest, ReportsChangedFilesOnce) {
+  FileWatcher watcher;
+  ASSERT_TRUE(watcher.AddDirectory(dir_));
+
+  WriteFile(dir_ / "a.md", "a");
+  WriteFile(dir_ / "a.md", "aa");
+  WriteFile(dir_ / "sub" / "b.md", "b");
+
+  EXPECT_THAT(watcher.WaitForChanges(/*debounce_ms=*/10),
+              UnorderedElementsAre((dir_ / "a.md").string(),
+                                   (dir_ / "sub" / "b.md").string()));
+}
+
+TEST_F(FileWatcherTest, WatchesNewDirectory) {
+  FileWatcher watcher;
+  ASSERT_TRUE(watcher.AddDirectory(dir_));
+
+  fs::create_directories(dir_ / "new");
+  WriteFile(dir_ / "a.md", "a");
+  EXPECT_THAT(watcher.WaitForChanges(/*debounce_ms=*/10),
+              UnorderedElementsAre((dir_ / "a.md").string()));
+
+  WriteFile(dir_ / "new" / "c.md", "c");
+  EXPECT_THAT(watcher.WaitForChanges(/*debounce_ms=*/10),
+              UnorderedElementsAre((dir_ / "new" / "c.md").string()));
+}
+
+TEST_F(FileWatcherTest, ReportsDeletedFile) {
+  WriteFile(dir_ / "a.md", "a");
+
+  FileWatcher watcher;
+  ASSERT_TRUE(watcher.AddDirectory(dir_));
+
+  fs::remove(dir_ / "a.md");
+  EXPECT_THAT(watcher.WaitForChanges(/*debounce_ms=*/10),
+              UnorderedElementsAre((dir_ / "a.md").string()));
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,221 @@
+#include "flat_parse_tree.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "generators/html_generator.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+constexpr std::string_view kContent =
+    "# header\n"
+    "a **b** *c* `d` [link](url)\n"
+    "\n"
+    "* item\n"
+    "  1. ordered\n"
+    "\n"
+    "![alt caption=cap size=10,20](img.png)\n"
+    "\n"
+    "|a|b|\n"
+    "|-|-|\n"
+    "|c|d|\n"
+    "\n"
+    "\\sidenote{note} $$x$$\n"
+    "\n"
+    "```ref-r\n"
+    "ref box\n"
+    "```\n"
+    "\\ref{r}\n";
+
+std::string GenerateHtml(std::string_view content, const ParseTree& tree) {
+  MetadataRepo repo;
+  GeneratorContext context(repo, "image_path", /*use_clang_server=*/false,
+                           /*clang_server_port=*/0, nullptr,
+                           GeneratorOptions{});
+  HTMLGenerator generator(/*filename=*/"some_file.md", content, context, tree);
+  return std::string(generator.Generate());
+}
+
+// Collects the nodes of the parse tree in the pre-order.
+void CollectNodes(const ParseTreeNode& node,
+                  std::vector<const ParseTreeNode*>* nodes) {
+  nodes->push_back(&node);
+  for (const ParseTreeNode* child : node.GetChildren()) {
+    CollectNodes(*child, nodes);
+  }
+}
+
+TEST(FlatParseTreeTest, PreOrder) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+  FlatParseTree flat(tree);
+
+  std::vector<const ParseTreeNode*> nodes;
+  CollectNodes(*tree.GetRoot(), &nodes);
+
+  ASSERT_EQ(flat.Size(), nodes.size());
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const FlatParseTree::Node& node = flat.GetNode(i);
+    EXPECT_EQ(node.type, nodes[i]->GetNodeType()) << "Error at " << i;
+    EXPECT_EQ(node.start, nodes[i]->Start()) << "Error at " << i;
+    EXPECT_EQ(node.end, nodes[i]->End()) << "Error at " << i;
+
+    std::vector<int> children;
+    flat.ForEachChild(i, [&](int child) { children.push_back(child); });
+    EXPECT_EQ(children.size(), nodes[i]->GetChildren().size())
+        << "Error at " << i;
+  }
+}
+
+TEST(FlatParseTreeTest, NodeData) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+  FlatParseTree flat(tree);
+
+  std::vector<std::string_view> command_names;
+  bool found_image = false;
+  for (size_t i = 0; i < flat.Size(); i++) {
+    const FlatParseTree::Node& node = flat.GetNode(i);
+    if (node.type == ParseTreeNode::COMMAND) {
+      command_names.push_back(flat.GetNodeData(node).command_name);
+    } else if (node.type == ParseTreeNode::IMAGE) {
+      found_image = true;
+      for (int index : flat.GetNodeData(node).keyword_index) {
+        EXPECT_NE(index, FlatParseTree::kNoNode);
+      }
+    } else if (node.type == ParseTreeNode::TABLE) {
+      EXPECT_EQ(flat.GetNodeData(node).col_size, 2);
+    }
+  }
+
+  EXPECT_TRUE(found_image);
+  EXPECT_THAT(command_names, ::testing::ElementsAre("sidenote", "ref"));
+  EXPECT_NE(flat.FindReferenceNode("r"), FlatParseTree::kNoNode);
+  EXPECT_EQ(flat.FindReferenceNode("unknown"), FlatParseTree::kNoNode);
+}
+
+TEST(FlatParseTreeTest, ToParseTreeGeneratesSameHtml) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+  FlatParseTree flat(tree);
+
+  ParseTree rebuilt = flat.ToParseTree(std::make_unique<Arena>());
+  EXPECT_EQ(GenerateHtml(kContent, rebuilt), GenerateHtml(kContent, tree));
+  EXPECT_NE(rebuilt.FindReferenceNode("r"), nullptr);
+}
+
+TEST(FlatParseTreeTest, SerializeRoundTrip) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+  FlatParseTree flat(tree);
+
+  const std::string data = flat.Serialize();
+  std::optional<FlatParseTree> loaded = FlatParseTree::Deserialize(data);
+  ASSERT_TRUE(loaded.has_value());
+  ASSERT_EQ(loaded->Size(), flat.Size());
+
+  // Command names point to the static table rather than the data.
+  for (size_t i = 0; i < loaded->Size(); i++) {
+    const FlatParseTree::Node& node = loaded->GetNode(i);
+    if (node.type == ParseTreeNode::COMMAND) {
+      const std::string_view name = loaded->GetNodeData(node).command_name;
+      EXPECT_EQ(name, flat.GetNodeData(flat.GetNode(i)).command_name);
+      EXPECT_FALSE(name.data() >= data.data() &&
+                   name.data() < data.data() + data.size());
+    }
+  }
+
+  ParseTree rebuilt = loaded->ToParseTree(std::make_unique<Arena>());
+  EXPECT_EQ(GenerateHtml(kContent, rebuilt), GenerateHtml(kContent, tree));
+  EXPECT_NE(rebuilt.FindReferenceNode("r"), nullptr);
+}
+
+TEST(FlatParseTreeTest, DeserializeParseTree) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+  const std::string data = FlatParseTree(tree).Serialize();
+
+  auto arena = std::make_unique<Arena>();
+  std::optional<ParseTree> loaded =
+      FlatParseTree::DeserializeParseTree(data, &arena);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(arena, nullptr);
+  EXPECT_EQ(GenerateHtml(kContent, *loaded), GenerateHtml(kContent, tree));
+  EXPECT_NE(loaded->FindReferenceNode("r"), nullptr);
+  EXPECT_EQ(loaded->GetSyncPoints().size(), tree.GetSyncPoints().size());
+}
+
+TEST(FlatParseTreeTest, DeserializedTreeSupportsApplyEdit) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+  ParseTree loaded = FlatParseTree::Deserialize(FlatParseTree(tree).Serialize())
+                         ->ToParseTree(std::make_unique<Arena>());
+  EXPECT_EQ(loaded.GetSyncPoints().size(), tree.GetSyncPoints().size());
+
+  std::string edited(kContent);
+  const int start = edited.find("**b**");
+  edited.replace(start, 2, "xx");
+  loaded.ApplyEdit(TextEdit{.start = start, .old_end = start + 2,
+                            .new_end = start + 2},
+                   edited, &parser);
+
+  EXPECT_EQ(GenerateHtml(edited, loaded),
+            GenerateHtml(edited, parser.GenerateParseTree(edited)));
+}
+
+TEST(FlatParseTreeTest, DeserializeRejectsInvalidData) {
+  Parser parser;
+  const std::string data =
+      FlatParseTree(parser.GenerateParseTree(kContent)).Serialize();
+
+  EXPECT_FALSE(FlatParseTree::Deserialize("").has_value());
+  EXPECT_FALSE(
+      FlatParseTree::Deserialize(data.substr(0, data.size() - 1)).has_value());
+  EXPECT_FALSE(FlatParseTree::Deserialize(data + "x").has_value());
+
+  // Other version.
+  std::string other_version = data;
+  const uint32_t version = FlatParseTree::kBinaryVersion + 1;
+  std::memcpy(other_version.data() + 4, &version, sizeof(version));
+  EXPECT_FALSE(FlatParseTree::Deserialize(other_version).has_value());
+
+  // Corrupting any byte never crashes; The tree is either rejected or still
+  // well formed.
+  for (size_t i = 0; i < data.size(); i++) {
+    std::string corrupted = data;
+    corrupted[i] ^= 0x5a;
+    if (std::optional<FlatParseTree> tree =
+            FlatParseTree::Deserialize(corrupted)) {
+      tree->ToParseTree(std::make_unique<Arena>());
+    }
+
+    // Same for the direct load; The arena is kept if it is rejected.
+    auto arena = std::make_unique<Arena>();
+    if (!FlatParseTree::DeserializeParseTree(corrupted, &arena)) {
+      EXPECT_NE(arena, nullptr);
+      EXPECT_EQ(arena->BytesUsed(), 0);
+    }
+  }
+}
+
+TEST(FlatParseTreeTest, SmallerThanParseTree) {
+  std::string content;
+  for (int i = 0; i < 100; i++) {
+    content += std::string(kContent);
+  }
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+  FlatParseTree flat(tree);
+
+  const size_t parse_tree_bytes = tree.GetArena()->BytesUsed();
+  EXPECT_LT(flat.MemoryUsage() * 2, parse_tree_bytes);
+}
+
+}  // namespace
+}  // namespace md2
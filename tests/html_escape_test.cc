@@ -0,0 +1,71 @@
+#include "generators/html_escape.h"
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+std::string EscapeHtmlSlow(std::string_view s) {
+  std::string escaped;
+  for (char c : s) {
+    if (c == '<') {
+      escaped.append("&lt;");
+    } else if (c == '>') {
+      escaped.append("&gt;");
+    } else if (c == '&') {
+      escaped.append("&amp;");
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+TEST(HtmlEscapeTest, Escape) {
+  EXPECT_EQ(EscapeHtml(""), "");
+  EXPECT_EQ(EscapeHtml("abc"), "abc");
+  EXPECT_EQ(EscapeHtml("a<b>&c"), "a&lt;b&gt;&amp;c");
+  EXPECT_EQ(EscapeHtml("std::vector<std::pair<int, int>>"),
+            "std::vector&lt;std::pair&lt;int, int&gt;&gt;");
+  EXPECT_EQ(EscapeHtml("가나다 <"), "가나다 &lt;");
+}
+
+TEST(HtmlEscapeTest, AppendsToTarget) {
+  std::string target = "<p>";
+  AppendEscapedHtml("a<b", &target);
+  EXPECT_EQ(target, "<p>a&lt;b");
+}
+
+TEST(HtmlEscapeTest, SpecialCharAtEveryPosition) {
+  // Covers the both sides of the 16 and 32 byte blocks.
+  for (size_t size = 1; size <= 100; size++) {
+    for (size_t pos = 0; pos < size; pos++) {
+      std::string s(size, 'a');
+      s[pos] = '&';
+      EXPECT_EQ(FindHtmlSpecialChar(s), pos) << size << " " << pos;
+      EXPECT_EQ(EscapeHtml(s), EscapeHtmlSlow(s)) << size << " " << pos;
+    }
+    EXPECT_EQ(FindHtmlSpecialChar(std::string(size, 'a')), size);
+  }
+}
+
+TEST(HtmlEscapeTest, RandomStrings) {
+  std::mt19937 rng(3);
+  for (int i = 0; i < 1000; i++) {
+    std::string s(rng() % 200, ' ');
+    for (char& c : s) {
+      // Mostly the plain characters with the bytes of every value.
+      c = rng() % 8 == 0 ? "<>&"[rng() % 3] : static_cast<char>(rng());
+    }
+
+    // Unaligned start.
+    const std::string_view view = std::string_view(s).substr(s.empty() ? 0 : 1);
+    EXPECT_EQ(EscapeHtml(view), EscapeHtmlSlow(view));
+  }
+}
+
+}  // namespace
+}  // namespace md2
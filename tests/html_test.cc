@@ -1,3 +1,6 @@
+#include <string>
+#include <utility>
+
 #include "../src/generators/html_generator.h"
 #include "../src/parser.h"
 #include "gmock/gmock.h"
@@ -94,6 +97,59 @@ TEST(HtmlTest, StrikeThrough2) {
              "class='font-italic'>b</span></span>c</p>");
 }
 
+// Strike through and bold that are nested in turn num_nested times, with a
+// letter after each opening marker. Returns the content and the html of the
+// decorations that are rendered (at most Parser::kMaxNestingDepth).
+std::pair<std::string, std::string> NestedDecorations(int num_nested) {
+  std::string content, content_close;
+  std::string html, html_close, literal_close;
+  for (int i = 0; i < num_nested; i++) {
+    const bool strike = i % 2 == 0;
+    const std::string marker = strike ? "~~" : "**";
+    const char letter = 'a' + i;
+    content += marker + letter;
+    content_close = marker + content_close;
+
+    if (i < Parser::kMaxNestingDepth) {
+      html += strike ? "<span class='font-strike'>"
+                     : "<span class='font-weight-bold'>";
+      html += letter;
+      html_close += "</span>";
+    } else {
+      html += marker + letter;
+      literal_close = marker + literal_close;
+    }
+  }
+
+  return {content + content_close,
+          "<p>" + html + literal_close + html_close + "</p>"};
+}
+
+TEST(HtmlTest, DecorationsUpToMaxNestingDepth) {
+  for (int num_nested : {1, Parser::kMaxNestingDepth - 1,
+                         Parser::kMaxNestingDepth}) {
+    auto [content, html] = NestedDecorations(num_nested);
+    EXPECT_EQ(html.find("~~"), std::string::npos);
+    DoHtmlTest(content, html);
+  }
+}
+
+TEST(HtmlTest, DecorationsBeyondMaxNestingDepthAreText) {
+  // The decorations beyond the limit are left as a text as a whole; None of
+  // their markers closes the decoration that is rendered.
+  for (int num_nested : {Parser::kMaxNestingDepth + 1,
+                         Parser::kMaxNestingDepth + 2,
+                         Parser::kMaxNestingDepth + 5}) {
+    auto [content, html] = NestedDecorations(num_nested);
+    DoHtmlTest(content, html);
+  }
+
+  const std::string html =
+      NestedDecorations(Parser::kMaxNestingDepth + 2).second;
+  EXPECT_NE(html.find("p~~q**r**~~</span>"), std::string::npos) << html;
+
+}
+
 TEST(HtmlTest, Link) {
   DoHtmlTest("[link](http://link)", "<p><a href='http://link'>link</a></p>");
 }
@@ -477,6 +533,11 @@ not quote
              "quotecontinued</blockquote><p>not quote\n</p>");
 }
 
+TEST(HtmlTest, EmptyQuote) {
+  // The quote has an empty text node as a child.
+  DoHtmlTest("> \n", "<blockquote class='quote'></blockquote>");
+}
+
 TEST(HtmlTest, NotQuote) {
   std::string content = R"(
   > this is not quote
@@ -0,0 +1,68 @@
+#include "generators/image_index.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "generators/generator_context.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+using ::testing::Optional;
+
+class ImageIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    image_dir_ = fs::temp_directory_path() /
+                 ("md2_image_index_test_" + std::to_string(getpid()));
+    fs::create_directories(image_dir_ / "img");
+
+    for (const char* file : {"img/a.png", "img/a.webp", "img/b.jpg", "c.gif"}) {
+      std::ofstream out(image_dir_ / file);
+    }
+  }
+
+  void TearDown() override { fs::remove_all(image_dir_); }
+
+  fs::path image_dir_;
+};
+
+TEST_F(ImageIndexTest, Exists) {
+  ImageIndex index(image_dir_.string());
+  EXPECT_EQ(index.Size(), 4);
+
+  EXPECT_THAT(index.Exists("/img/a.png"), Optional(true));
+  EXPECT_THAT(index.Exists("img/a.webp"), Optional(true));
+  EXPECT_THAT(index.Exists("/img/./b.jpg"), Optional(true));
+  EXPECT_THAT(index.Exists("/img/a.jpg"), Optional(false));
+  EXPECT_THAT(index.Exists("/c.gif"), Optional(true));
+  EXPECT_THAT(index.Exists("/img/c.gif"), Optional(false));
+
+  // Not in the image directory.
+  EXPECT_EQ(index.Exists("../a.png"), std::nullopt);
+}
+
+TEST_F(ImageIndexTest, NotADirectory) {
+  ImageIndex index((image_dir_ / "none").string());
+  EXPECT_EQ(index.Exists("/img/a.png"), std::nullopt);
+}
+
+TEST_F(ImageIndexTest, FindImage) {
+  MetadataRepo repo;
+  GeneratorContext context(repo, image_dir_.string(), false, 0, nullptr);
+
+  EXPECT_EQ(context.FindImageForHtml("/img/a"), "/img/a.webp");
+  EXPECT_EQ(context.FindImageForHtml("/img/b.png"), "/img/b.jpg");
+  EXPECT_EQ(context.FindImageForLatex("/img/a"),
+            image_dir_.string() + "/img/a.png");
+  EXPECT_EQ(context.FindImageForHtml("/img/none.png"), "/img/none.png");
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,107 @@
+#include "generators/latex_escape.h"
+
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+constexpr std::string_view kSpecialChars = "~^\\&%$#_{}<>";
+
+std::string EscapeLatexSlow(std::string_view s) {
+  std::string escaped;
+  for (char c : s) {
+    switch (c) {
+      case '~':
+        escaped.append("$\\sim$");
+        break;
+      case '^':
+        escaped.append("$\\hat{}$");
+        break;
+      case '\\':
+        escaped.append("\\textbackslash ");
+        break;
+      case '<':
+        escaped.append("$<$");
+        break;
+      case '>':
+        escaped.append("$>$");
+        break;
+      case '&':
+      case '%':
+      case '$':
+      case '#':
+      case '_':
+      case '{':
+      case '}':
+        escaped.push_back('\\');
+        escaped.push_back(c);
+        break;
+      default:
+        escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+TEST(LatexEscapeTest, Escape) {
+  EXPECT_EQ(EscapeLatex(""), "");
+  EXPECT_EQ(EscapeLatex("abc"), "abc");
+  EXPECT_EQ(EscapeLatex("a_b^c"), "a\\_b$\\hat{}$c");
+  EXPECT_EQ(EscapeLatex("50% of $x"), "50\\% of \\$x");
+  EXPECT_EQ(EscapeLatex("\\{~}"), "\\textbackslash \\{$\\sim$\\}");
+  EXPECT_EQ(EscapeLatex("vector<int>"), "vector$<$int$>$");
+  EXPECT_EQ(EscapeLatex("가나다 #"), "가나다 \\#");
+}
+
+TEST(LatexEscapeTest, AppendsToTarget) {
+  std::string target = "\\textbf{";
+  AppendEscapedLatex("a&b", &target);
+  EXPECT_EQ(target, "\\textbf{a\\&b");
+}
+
+TEST(LatexEscapeTest, EveryByte) {
+  // Near the special characters in the nibble tables, e.g. '"', '\'', '=', '?'
+  // and '|', and the bytes with the high bit.
+  for (int b = 0; b < 256; b++) {
+    const std::string s(40, static_cast<char>(b));
+    const bool special =
+        kSpecialChars.find(static_cast<char>(b)) != std::string_view::npos;
+    EXPECT_EQ(FindLatexSpecialChar(s), special ? 0 : s.size()) << b;
+    EXPECT_EQ(EscapeLatex(s), EscapeLatexSlow(s)) << b;
+  }
+}
+
+TEST(LatexEscapeTest, SpecialCharAtEveryPosition) {
+  // Covers the both sides of the 16 and 32 byte blocks.
+  for (char special : kSpecialChars) {
+    for (size_t size = 1; size <= 100; size++) {
+      for (size_t pos = 0; pos < size; pos++) {
+        std::string s(size, 'a');
+        s[pos] = special;
+        EXPECT_EQ(FindLatexSpecialChar(s), pos) << special << " " << pos;
+        EXPECT_EQ(EscapeLatex(s), EscapeLatexSlow(s)) << special << " " << pos;
+      }
+    }
+  }
+}
+
+TEST(LatexEscapeTest, RandomStrings) {
+  std::mt19937 rng(3);
+  for (int i = 0; i < 1000; i++) {
+    std::string s(rng() % 200, ' ');
+    for (char& c : s) {
+      c = rng() % 8 == 0 ? kSpecialChars[rng() % kSpecialChars.size()]
+                         : static_cast<char>(rng());
+    }
+
+    // Unaligned start.
+    const std::string_view view = std::string_view(s).substr(s.empty() ? 0 : 1);
+    EXPECT_EQ(EscapeLatex(view), EscapeLatexSlow(view));
+  }
+}
+
+}  // namespace
+}  // namespace md2
@@ -287,6 +287,11 @@ not quote
               "quotecontinued\n\\end{displayquote}\n\nnot quote\n\n");
 }
 
+TEST(LatexTest, EmptyQuote) {
+  // The quote has an empty text node as a child.
+  DoLatexTest("> \n", "\n\\begin{displayquote}\n\n\\end{displayquote}\n");
+}
+
 TEST(LatexTest, NotQuote) {
   std::string content = R"(
   > this is not quote
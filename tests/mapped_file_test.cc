@@ -0,0 +1,70 @@
+#include "mapped_file.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+class MappedFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = fs::temp_directory_path() /
+           ("md2_mapped_file_test_" + std::to_string(getpid()));
+    fs::create_directories(dir_);
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  std::string WriteFile(std::string_view name, std::string_view content) {
+    const std::string path = dir_ / name;
+    std::ofstream(path) << content;
+    return path;
+  }
+
+  fs::path dir_;
+};
+
+TEST_F(MappedFileTest, Open) {
+  auto file = MappedFile::Open(WriteFile("a.md", "abc\n"));
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(file->Content(), "abc\n");
+}
+
+TEST_F(MappedFileTest, OpenEmptyFile) {
+  auto file = MappedFile::Open(WriteFile("empty.md", ""));
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(file->Content().empty());
+  EXPECT_NE(file->Content().data(), nullptr);
+}
+
+TEST_F(MappedFileTest, OpenMissingFile) {
+  EXPECT_EQ(MappedFile::Open(dir_ / "missing.md"), nullptr);
+  EXPECT_EQ(MappedFile::Read(dir_ / "missing.md"), nullptr);
+}
+
+TEST_F(MappedFileTest, ReadIsNotChangedByRewrite) {
+  const std::string path = WriteFile("a.md", std::string(100000, 'a'));
+  auto file = MappedFile::Read(path);
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(file->Content(), std::string(100000, 'a'));
+
+  // Truncated and rewritten in place, as some editors do.
+  WriteFile("a.md", "b");
+  EXPECT_EQ(file->Content(), std::string(100000, 'a'));
+}
+
+TEST_F(MappedFileTest, ReadEmptyFile) {
+  auto file = MappedFile::Read(WriteFile("empty.md", ""));
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(file->Content().empty());
+}
+
+}  // namespace
+}  // namespace md2
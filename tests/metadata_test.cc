@@ -71,6 +71,18 @@ ref_title : string, std::string, std::string_view,  string_view
   EXPECT_EQ(end, content.size());
 }
 
+TEST(MetadataTest, EmptyOrWhitespaceOnly) {
+  // Contents are not null terminated (e.g the memory mapped file).
+  EXPECT_THAT(ConstructMetadata(std::string_view()), IsNull());
+  EXPECT_THAT(ConstructMetadata(""), IsNull());
+
+  constexpr std::string_view kWhitespaces = " \n\t \n---\ntitle : a\n---\n";
+  EXPECT_THAT(ConstructMetadata(kWhitespaces.substr(0, 5)), IsNull());
+
+  // Ends right after the start of the metadata.
+  EXPECT_THAT(ConstructMetadata(kWhitespaces.substr(0, 8)), IsNull());
+}
+
 TEST(MetadataRepoTest, ConstructRepo) {
   std::string_view content = R"(
 ----------------
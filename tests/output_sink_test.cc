@@ -0,0 +1,115 @@
+#include "output_sink.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "generators/html_generator.h"
+#include "generators/latex_generator.h"
+#include "gtest/gtest.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+OutputSink MakeSink(std::initializer_list<std::string> chunks) {
+  OutputSink sink;
+  for (const std::string& chunk : chunks) {
+    sink.Append(chunk);
+  }
+  return sink;
+}
+
+TEST(OutputSinkTest, Append) {
+  OutputSink sink = MakeSink({"abc", "", "de"});
+
+  EXPECT_EQ(sink.Size(), 5);
+  EXPECT_EQ(sink.Chunks().size(), 2);
+  EXPECT_TRUE(sink.Equals("abcde"));
+  EXPECT_FALSE(sink.Equals("abcdf"));
+  EXPECT_FALSE(sink.Equals("abcd"));
+  EXPECT_EQ(std::move(sink).ToString(), "abcde");
+}
+
+TEST(OutputSinkTest, SingleChunkIsNotCopied) {
+  std::string chunk(1000, 'a');
+  const char* data = chunk.data();
+
+  OutputSink sink;
+  sink.Append(std::move(chunk));
+  EXPECT_EQ(std::move(sink).ToString().data(), data);
+}
+
+TEST(OutputSinkTest, WriteTo) {
+  const fs::path path = fs::temp_directory_path() /
+                        ("md2_output_sink_test_" + std::to_string(getpid()));
+
+  // More chunks than IOV_MAX.
+  OutputSink sink;
+  std::string expected;
+  for (int i = 0; i < 3000; i++) {
+    sink.Append(std::to_string(i));
+    expected.append(std::to_string(i));
+  }
+
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  EXPECT_TRUE(sink.WriteTo(fd));
+  close(fd);
+
+  std::ifstream in(path);
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  EXPECT_EQ(buffer.str(), expected);
+
+  fs::remove(path);
+}
+
+class GenerateToSinkTest : public ::testing::Test {
+ protected:
+  GenerateToSinkTest()
+      : context_(repo_, "image_path", /*use_clang_server=*/false,
+                 /*clang_server_port=*/0, nullptr) {
+    for (int i = 0; i < 3000; i++) {
+      content_.append("some **text** with `code` & [link](url) $x_1$\n\n");
+    }
+    tree_ = Parser().GenerateParseTree(content_);
+  }
+
+  template <typename Generator>
+  void ExpectSameOutput() {
+    Generator expected_generator("a.md", content_, context_, *tree_);
+    const std::string expected(expected_generator.Generate());
+
+    Generator generator("a.md", content_, context_, *tree_);
+    OutputSink sink;
+    generator.Generate(&sink);
+
+    // Handed over in the chunks while it is generated.
+    const std::vector<std::string>& chunks = sink.Chunks();
+    ASSERT_GT(chunks.size(), 1);
+    for (size_t i = 0; i + 1 < chunks.size(); i++) {
+      EXPECT_GE(chunks[i].size(), OutputSink::kChunkSize);
+    }
+    EXPECT_TRUE(sink.Equals(expected));
+  }
+
+  std::string content_;
+  std::optional<ParseTree> tree_;
+  MetadataRepo repo_;
+  GeneratorContext context_;
+};
+
+TEST_F(GenerateToSinkTest, Html) { ExpectSameOutput<HTMLGenerator>(); }
+
+TEST_F(GenerateToSinkTest, Latex) { ExpectSameOutput<LatexGenerator>(); }
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,127 @@
+#include "output_writer.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+class OutputWriterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = fs::temp_directory_path() /
+           ("md2_output_writer_test_" + std::to_string(getpid()));
+    fs::create_directories(dir_);
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  std::string ReadFile(const fs::path& path) {
+    std::ifstream in(path);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+  }
+
+  fs::path dir_;
+};
+
+TEST_F(OutputWriterTest, WriteFileIfChanged) {
+  const std::string path = dir_ / "a.html";
+
+  EXPECT_EQ(OutputWriter::WriteFileIfChanged(path, "abc"),
+            OutputWriter::WRITTEN);
+  EXPECT_EQ(ReadFile(path), "abc");
+
+  EXPECT_EQ(OutputWriter::WriteFileIfChanged(path, "abc"),
+            OutputWriter::UNCHANGED);
+
+  EXPECT_EQ(OutputWriter::WriteFileIfChanged(path, "abd"),
+            OutputWriter::WRITTEN);
+  EXPECT_EQ(ReadFile(path), "abd");
+
+  EXPECT_EQ(OutputWriter::WriteFileIfChanged(path, ""), OutputWriter::WRITTEN);
+  EXPECT_EQ(ReadFile(path), "");
+
+  // No temporary file is left.
+  EXPECT_EQ(std::distance(fs::directory_iterator(dir_),
+                          fs::directory_iterator()),
+            1);
+}
+
+TEST_F(OutputWriterTest, TemporaryFileIsUnique) {
+  const std::string path = dir_ / "a.html";
+
+  // Files that look like the temporary file are not touched.
+  std::ofstream(path + ".md2tmp") << "other";
+  std::ofstream(path + ".XXXXXX") << "other";
+
+  EXPECT_EQ(OutputWriter::WriteFileIfChanged(path, "abc"),
+            OutputWriter::WRITTEN);
+  EXPECT_EQ(ReadFile(path), "abc");
+  EXPECT_EQ(ReadFile(path + ".md2tmp"), "other");
+  EXPECT_EQ(ReadFile(path + ".XXXXXX"), "other");
+  EXPECT_EQ(fs::status(path).permissions() & fs::perms::all,
+            fs::perms::owner_read | fs::perms::owner_write |
+                fs::perms::group_read | fs::perms::others_read);
+  EXPECT_EQ(std::distance(fs::directory_iterator(dir_),
+                          fs::directory_iterator()),
+            3);
+}
+
+TEST_F(OutputWriterTest, ConcurrentWritesToSamePath) {
+  const std::string path = dir_ / "a.tree";
+
+  std::vector<std::string> contents;
+  for (char c : {'a', 'b', 'c', 'd'}) {
+    contents.push_back(std::string(100000, c));
+  }
+
+  std::vector<std::thread> threads;
+  for (const std::string& content : contents) {
+    threads.emplace_back([&path, &content]() {
+      for (int i = 0; i < 20; i++) {
+        EXPECT_NE(OutputWriter::WriteFileIfChanged(path, content),
+                  OutputWriter::FAILED);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // The file is one of the contents as a whole.
+  EXPECT_THAT(contents, ::testing::Contains(ReadFile(path)));
+  EXPECT_EQ(std::distance(fs::directory_iterator(dir_),
+                          fs::directory_iterator()),
+            1);
+}
+
+TEST_F(OutputWriterTest, WriteInBackground) {
+  OutputWriter::WriteFileIfChanged(dir_ / "0.html", "0");
+
+  OutputWriter writer(/*max_pending=*/2);
+  for (int i = 0; i < 10; i++) {
+    writer.Write(dir_ / (std::to_string(i) + ".html"), std::to_string(i));
+  }
+  writer.Write(dir_ / "none" / "a.html", "a");
+  writer.Finish();
+
+  EXPECT_EQ(writer.NumWritten(), 9);
+  EXPECT_EQ(writer.NumUnchanged(), 1);
+  EXPECT_EQ(writer.NumFailed(), 1);
+  EXPECT_EQ(ReadFile(dir_ / "7.html"), "7");
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,163 @@
+#include "parallel_parser.h"
+
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Not;
+
+constexpr std::string_view kBlocks[] = {
+    "some paragraph with **bold** and `code`\n",
+    "# header\n",
+    "* item\n* item **2**\n  1. nested\n",
+    "$$\nx = y\n\nz\n$$\n",
+    "```cpp\nint a;\n\nint b;\n```\n",
+    "```note\ninner paragraph\n\n[link](url)\n```\n",
+    "```ref-r\nref box\n```\n",
+    "\\ref{r} and \\sidenote{side\n\nnote}\n",
+    "|a|b|\n|-|-|\n|c|d|\n",
+    "> quote\n",
+    "unclosed $$ math\n",
+    "unclosed `code\n",
+    "![alt caption=cap](img.png)\n",
+    "1. first\n2. second\n",
+};
+
+void ExpectSameNode(const ParseTreeNode& actual,
+                    const ParseTreeNode& expected) {
+  ASSERT_EQ(actual.GetNodeType(), expected.GetNodeType());
+  EXPECT_EQ(actual.Start(), expected.Start());
+  EXPECT_EQ(actual.End(), expected.End());
+  ASSERT_EQ(actual.GetChildren().size(), expected.GetChildren().size());
+  for (size_t i = 0; i < actual.GetChildren().size(); i++) {
+    EXPECT_EQ(actual.GetChildren()[i]->GetParent() == &actual,
+              expected.GetChildren()[i]->GetParent() == &expected);
+    ExpectSameNode(*actual.GetChildren()[i], *expected.GetChildren()[i]);
+  }
+}
+
+// Parses the content in parallel and checks that the tree is the same as the
+// one that is parsed sequentially.
+void CheckParallelParse(std::string_view content, size_t min_chunk_size) {
+  ThreadPool pool(4);
+  ParseTree tree = ParallelParser(&pool, min_chunk_size)
+                       .GenerateParseTree(content, std::make_unique<Arena>());
+
+  Parser parser;
+  ParseTree expected = parser.GenerateParseTree(content);
+  ExpectSameNode(*tree.GetRoot(), *expected.GetRoot());
+
+  ASSERT_EQ(tree.GetReferences().size(), expected.GetReferences().size());
+  for (const auto& [name, node] : expected.GetReferences()) {
+    EXPECT_EQ(tree.FindReferenceNode(name)->Start(), node->Start());
+  }
+}
+
+std::string RandomDocument(std::mt19937& rng, int num_blocks) {
+  std::string content;
+  for (int i = 0; i < num_blocks; i++) {
+    content += kBlocks[rng() % std::size(kBlocks)];
+    content += "\n";
+  }
+  return content;
+}
+
+TEST(ParallelParserTest, FindSplitPoints) {
+  std::string content =
+      "aaaa\n"
+      "\n"
+      "```note\n"
+      "b\n"
+      "\n"
+      "c\n"
+      "```\n"
+      "\n"
+      "$$\n"
+      "d\n"
+      "\n"
+      "e\n"
+      "$$\n"
+      "\n"
+      "* f\n"
+      "\n"
+      "g\n"
+      "\n"
+      "h\n";
+
+  // Blank lines inside of the box and the math, and after the list item are
+  // skipped.
+  EXPECT_THAT(ParallelParser::FindSplitPoints(content, 1),
+              ElementsAre(content.find("```note"), content.find("$$"),
+                          content.find("h\n")));
+  EXPECT_THAT(ParallelParser::FindSplitPoints(content, content.size()),
+              IsEmpty());
+}
+
+TEST(ParallelParserTest, SplitPointsAreApart) {
+  std::string content;
+  for (int i = 0; i < 100; i++) {
+    content += "paragraph\n\n";
+  }
+
+  std::vector<size_t> split_points =
+      ParallelParser::FindSplitPoints(content, 100);
+  ASSERT_THAT(split_points, Not(IsEmpty()));
+  for (size_t i = 1; i < split_points.size(); i++) {
+    EXPECT_GE(split_points[i] - split_points[i - 1], 100);
+  }
+}
+
+TEST(ParallelParserTest, SameAsSequentialParse) {
+  std::string content;
+  for (int i = 0; i < 20; i++) {
+    for (std::string_view block : kBlocks) {
+      content += block;
+      content += "\nplain paragraph\n\n";
+    }
+  }
+
+  CheckParallelParse(content, /*min_chunk_size=*/100);
+  CheckParallelParse(content, /*min_chunk_size=*/1000);
+}
+
+TEST(ParallelParserTest, RandomDocuments) {
+  std::mt19937 rng(42);
+  for (int i = 0; i < 50; i++) {
+    std::string content = RandomDocument(rng, 100);
+    SCOPED_TRACE(content);
+    CheckParallelParse(content, /*min_chunk_size=*/50);
+  }
+}
+
+TEST(ParallelParserTest, ApplyEditToParallelParsedTree) {
+  std::mt19937 rng(7);
+  std::string content = RandomDocument(rng, 100);
+
+  ThreadPool pool(4);
+  ParseTree tree = ParallelParser(&pool, /*min_chunk_size=*/50)
+                       .GenerateParseTree(content, std::make_unique<Arena>());
+
+  const size_t start = content.size() / 2;
+  content.insert(start, "$$");
+
+  Parser parser;
+  tree.ApplyEdit(TextEdit{.start = static_cast<int>(start),
+                          .old_end = static_cast<int>(start),
+                          .new_end = static_cast<int>(start + 2)},
+                 content, &parser);
+
+  ParseTree expected = parser.GenerateParseTree(content);
+  ExpectSameNode(*tree.GetRoot(), *expected.GetRoot());
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,73 @@
+#include "parse_tree_cache.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+namespace fs = std::filesystem;
+
+class ParseTreeCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = fs::temp_directory_path() /
+           ("md2_parse_tree_cache_test_" + std::to_string(getpid()));
+    fs::remove_all(dir_);
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  fs::path dir_;
+};
+
+TEST_F(ParseTreeCacheTest, StoreAndLoad) {
+  // Creates the directory.
+  ParseTreeCache cache(dir_.string());
+  EXPECT_TRUE(fs::is_directory(dir_));
+
+  const std::string content = "# title\n\nsome **bold** text \\sidenote{a}\n";
+  const std::string key = ParseTreeCache::Key(content);
+  EXPECT_EQ(key.size(), 64);
+  EXPECT_NE(key, ParseTreeCache::Key(content + " "));
+
+  auto arena = std::make_unique<Arena>();
+  EXPECT_FALSE(cache.Load(key, &arena).has_value());
+  EXPECT_NE(arena, nullptr);
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+  ASSERT_TRUE(cache.Store(key, tree));
+
+  std::optional<ParseTree> loaded = cache.Load(key, &arena);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(arena, nullptr);
+  EXPECT_EQ(FlatParseTree(*loaded).Serialize(),
+            FlatParseTree(tree).Serialize());
+}
+
+TEST_F(ParseTreeCacheTest, IgnoresCorruptedTree) {
+  ParseTreeCache cache(dir_.string());
+
+  const std::string content = "paragraph\n";
+  const std::string key = ParseTreeCache::Key(content);
+  std::ofstream(dir_ / (key + ".tree")) << "not a tree";
+
+  auto arena = std::make_unique<Arena>();
+  EXPECT_FALSE(cache.Load(key, &arena).has_value());
+  EXPECT_NE(arena, nullptr);
+
+  // Storing the tree again fixes it.
+  Parser parser;
+  ASSERT_TRUE(cache.Store(key, parser.GenerateParseTree(content)));
+  EXPECT_TRUE(cache.Load(key, &arena).has_value());
+}
+
+}  // namespace
+}  // namespace md2
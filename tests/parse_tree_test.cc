@@ -0,0 +1,277 @@
+#include "parse_tree.h"
+
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "parser.h"
+
+namespace md2 {
+namespace {
+
+constexpr std::string_view kContent =
+    "# header\n"
+    "a **b** *c* `d` [link](url)\n"
+    "\n"
+    "* item\n"
+    "  1. ordered\n"
+    "\n"
+    "![alt caption=cap size=10,20](img.png)\n"
+    "\n"
+    "|a|b|\n"
+    "|-|-|\n"
+    "|c|d|\n"
+    "\n"
+    "\\sidenote{note\n\nin the sidenote} $$x$$\n"
+    "\n"
+    "```note\n"
+    "box\n"
+    "\n"
+    "```\n"
+    "\n"
+    "```ref-r\n"
+    "ref box\n"
+    "```\n"
+    "\\ref{r}\n"
+    "\n"
+    "> quote\n"
+    "\n"
+    "last paragraph\n";
+
+void ExpectSameNode(const ParseTreeNode& actual,
+                    const ParseTreeNode& expected) {
+  ASSERT_EQ(actual.GetNodeType(), expected.GetNodeType());
+  EXPECT_EQ(actual.Start(), expected.Start());
+  EXPECT_EQ(actual.End(), expected.End());
+  ASSERT_EQ(actual.GetChildren().size(), expected.GetChildren().size());
+  for (size_t i = 0; i < actual.GetChildren().size(); i++) {
+    ExpectSameNode(*actual.GetChildren()[i], *expected.GetChildren()[i]);
+  }
+}
+
+// Applies the edit to the tree of the content and checks that the tree is
+// the same as the one that is parsed from scratch.
+void CheckEdit(std::string_view content, size_t start, size_t removed,
+               std::string_view inserted) {
+  std::string edited(content);
+  edited.replace(start, removed, inserted);
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+  tree.ApplyEdit(TextEdit{.start = static_cast<int>(start),
+                          .old_end = static_cast<int>(start + removed),
+                          .new_end = static_cast<int>(start + inserted.size())},
+                 edited, &parser);
+
+  ParseTree expected = parser.GenerateParseTree(edited);
+  SCOPED_TRACE(edited);
+  ExpectSameNode(*tree.GetRoot(), *expected.GetRoot());
+
+  ASSERT_EQ(tree.GetReferences().size(), expected.GetReferences().size());
+  for (const auto& [name, node] : expected.GetReferences()) {
+    ParseTreeNode* ref = tree.FindReferenceNode(name);
+    ASSERT_NE(ref, nullptr);
+    EXPECT_EQ(ref->Start(), node->Start());
+  }
+}
+
+TEST(ParseTreeTest, ApplyEditInsideParagraph) {
+  CheckEdit(kContent, kContent.find("**b**"), 2, "xx");
+}
+
+TEST(ParseTreeTest, ApplyEditJoinsParagraphs) {
+  CheckEdit(kContent, kContent.find("\n\n> quote"), 2, "");
+}
+
+TEST(ParseTreeTest, ApplyEditSplitsParagraph) {
+  CheckEdit(kContent, kContent.find("[link]"), 0, "\n\n");
+}
+
+TEST(ParseTreeTest, ApplyEditClosesMathInLaterBlock) {
+  // "$$" in the first block now matches the one in the last block.
+  std::string content = "a $$b\n\nc\n\nd\n\ne\n";
+  CheckEdit(content, content.size(), 0, "$$");
+}
+
+TEST(ParseTreeTest, ApplyEditBreaksClosingMath) {
+  // Changes the last character of the closing "$$".
+  std::string content = "a $$b$$\n\nc\n\nd\n";
+  CheckEdit(content, content.find("$\n"), 1, "x");
+}
+
+TEST(ParseTreeTest, ApplyEditOpensBox) {
+  CheckEdit(kContent, kContent.find("> quote"), 0, "```note\n");
+}
+
+TEST(ParseTreeTest, ApplyEditRemovesReference) {
+  CheckEdit(kContent, kContent.find("ref-r"), 5, "note");
+}
+
+TEST(ParseTreeTest, ApplyEditRemovesDuplicatedReference) {
+  constexpr std::string_view kDuplicated =
+      "```ref-x\nA\n```\n\npara\n\n```ref-x\nB\n```\n\nend";
+
+  // The first definition is used again once the second one is removed.
+  const size_t second = kDuplicated.rfind("```ref-x");
+  CheckEdit(kDuplicated, second, kDuplicated.find("end") - second, "");
+  CheckEdit(kDuplicated, second + 3, 5, "note");
+
+  // And the other way around.
+  CheckEdit(kDuplicated, 0, kDuplicated.find("para"), "");
+  CheckEdit(kDuplicated, kDuplicated.find("para"), 0, "```ref-x\nC\n```\n\n");
+}
+
+TEST(ParseTreeTest, ApplyEditAtTheEnd) {
+  CheckEdit(kContent, kContent.size(), 0, "\n\nmore *text*");
+  CheckEdit(kContent, kContent.size() - 5, 5, "");
+}
+
+constexpr std::string_view kSnippets[] = {
+    "a", "\n", "\n\n", "**", "*", "`", "```note\n", "\n```\n", "$$", "[",
+    "](", ")", "|", "* ", "# ", "> ", "\\sidenote{", "}"};
+
+// Brute force versions of NodeAt and NodesInRange.
+void FindDeepestNodeAt(const ParseTreeNode& node, int offset,
+                       const ParseTreeNode** found) {
+  if (node.Start() <= offset && offset < node.End()) {
+    *found = &node;
+    for (const ParseTreeNode* child : node.GetChildren()) {
+      FindDeepestNodeAt(*child, offset, found);
+    }
+  }
+}
+
+void CollectNodesInRange(const ParseTreeNode& node, int begin, int end,
+                         std::vector<const ParseTreeNode*>* nodes) {
+  if (begin < end && node.Start() < end && begin < node.End()) {
+    nodes->push_back(&node);
+    for (const ParseTreeNode* child : node.GetChildren()) {
+      CollectNodesInRange(*child, begin, end, nodes);
+    }
+  }
+}
+
+TEST(ParseTreeTest, NodeAt) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+
+  const ParseTreeNode* bold = tree.NodeAt(kContent.find("**b**") + 2);
+  ASSERT_NE(bold, nullptr);
+  EXPECT_EQ(bold->GetNodeType(), ParseTreeNode::BOLD);
+
+  const ParseTreeNode* paragraph = tree.NodeAt(kContent.find("ordered"));
+  ASSERT_NE(paragraph, nullptr);
+  EXPECT_EQ(paragraph->GetNodeType(), ParseTreeNode::PARAGRAPH);
+  EXPECT_EQ(paragraph->GetParent()->GetNodeType(),
+            ParseTreeNode::ORDERED_LIST_ITEM);
+
+  EXPECT_EQ(tree.NodeAt(-1), nullptr);
+  EXPECT_EQ(tree.NodeAt(kContent.size()), nullptr);
+}
+
+TEST(ParseTreeTest, NodesInRange) {
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(kContent);
+
+  const int begin = kContent.find("*c*");
+  std::vector<ParseTreeNode::NodeType> types;
+  for (const ParseTreeNode* node : tree.NodesInRange(begin, begin + 7)) {
+    types.push_back(node->GetNodeType());
+  }
+  EXPECT_THAT(types, ::testing::ElementsAre(
+                         ParseTreeNode::NODE, ParseTreeNode::PARAGRAPH,
+                         ParseTreeNode::ITALIC, ParseTreeNode::VERBATIM));
+
+  EXPECT_TRUE(tree.NodesInRange(begin, begin).empty());
+}
+
+TEST(ParseTreeTest, NodeLookupsOnRandomDocuments) {
+  std::mt19937 rng(7);
+  Parser parser;
+  for (int i = 0; i < 200; i++) {
+    std::string content;
+    const int num_snippets = rng() % 100;
+    for (int j = 0; j < num_snippets; j++) {
+      content += kSnippets[rng() % std::size(kSnippets)];
+    }
+    ParseTree tree = parser.GenerateParseTree(content);
+    SCOPED_TRACE(content);
+
+    for (int offset = -1; offset <= static_cast<int>(content.size());
+         offset++) {
+      const ParseTreeNode* expected = nullptr;
+      FindDeepestNodeAt(*tree.GetRoot(), offset, &expected);
+      EXPECT_EQ(tree.NodeAt(offset), expected) << offset;
+    }
+
+    const int begin = rng() % (content.size() + 1);
+    const int end = begin + rng() % 20;
+    std::vector<const ParseTreeNode*> expected;
+    CollectNodesInRange(*tree.GetRoot(), begin, end, &expected);
+    EXPECT_EQ(tree.NodesInRange(begin, end), expected);
+  }
+}
+
+TEST(ParseTreeTest, ApplyRandomEdits) {
+  std::mt19937 rng(42);
+  for (int i = 0; i < 500; i++) {
+    const size_t start = rng() % (kContent.size() + 1);
+    const size_t removed = std::min<size_t>(rng() % 4, kContent.size() - start);
+    CheckEdit(kContent, start, removed,
+              kSnippets[rng() % std::size(kSnippets)]);
+  }
+}
+
+TEST(ParseTreeTest, ApplyRandomEditsToSameTree) {
+  std::string content(kContent);
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+
+  std::mt19937 rng(30);
+  for (int i = 0; i < 300; i++) {
+    const size_t start = rng() % (content.size() + 1);
+    const size_t removed = std::min<size_t>(rng() % 4, content.size() - start);
+    const std::string_view inserted = kSnippets[rng() % std::size(kSnippets)];
+
+    content.replace(start, removed, inserted);
+    tree.ApplyEdit(
+        TextEdit{.start = static_cast<int>(start),
+                 .old_end = static_cast<int>(start + removed),
+                 .new_end = static_cast<int>(start + inserted.size())},
+        content, &parser);
+
+    ParseTree expected = parser.GenerateParseTree(content);
+    SCOPED_TRACE(content);
+    ExpectSameNode(*tree.GetRoot(), *expected.GetRoot());
+  }
+}
+
+TEST(ParseTreeTest, ApplyEditReusesUntouchedBlocks) {
+  std::string content;
+  for (int i = 0; i < 100; i++) {
+    content += "paragraph **" + std::to_string(i) + "**\n\n";
+  }
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+  const ParseTreeNode* first = tree.GetRoot()->GetChildren()[0];
+  const ParseTreeNode* last = tree.GetRoot()->GetChildren()[99];
+
+  const size_t start = content.find("50");
+  content.replace(start, 2, "fifty");
+  tree.ApplyEdit(TextEdit{.start = static_cast<int>(start),
+                          .old_end = static_cast<int>(start + 2),
+                          .new_end = static_cast<int>(start + 5)},
+                 content, &parser);
+
+  ASSERT_EQ(tree.GetRoot()->GetChildren().size(), 100);
+  EXPECT_EQ(tree.GetRoot()->GetChildren()[0], first);
+  EXPECT_EQ(tree.GetRoot()->GetChildren()[99], last);
+  EXPECT_EQ(last->End(), static_cast<int>(content.size()) - 2);
+}
+
+}  // namespace
+}  // namespace md2
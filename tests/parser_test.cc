@@ -877,5 +877,76 @@ TEST(ParserTest, NewlineMath) {
       .Compare(tree);
 }
 
+TEST(ParserTest, UnclosedMath) {
+  DoParserTest(R"(\[a $$b \[c)", ParseTreeComparer({
+                                    {ParseTreeNode::NODE, 0, 11, 0},
+                                    {ParseTreeNode::PARAGRAPH, 0, 11, 1},
+                                }));
+}
+
+TEST(ParserTest, LinkAfterBrokenLink) {
+  DoParserTest("[a](b\n[c](d)",
+               ParseTreeComparer({{ParseTreeNode::NODE, 0, 12, 0},
+                                  {ParseTreeNode::PARAGRAPH, 0, 12, 1},
+                                  {ParseTreeNode::LINK, 6, 12, 2},
+                                  {ParseTreeNode::NODE, 6, 9, 3},
+                                  {ParseTreeNode::TEXT, 7, 8, 4},
+                                  {ParseTreeNode::NODE, 9, 12, 3},
+                                  {ParseTreeNode::TEXT, 10, 11, 4}}));
+}
+
+TEST(ParserTest, UnclosedCodeBoxAtTheEnd) {
+  DoParserTest("```cpp", ParseTreeComparer({
+                             {ParseTreeNode::NODE, 0, 6, 0},
+                             {ParseTreeNode::PARAGRAPH, 0, 6, 1},
+                             {ParseTreeNode::VERBATIM, 1, 3, 2},
+                         }));
+}
+
+TEST(ParserTest, ImageDescriptionWithoutKeyword) {
+  for (std::string content : {"![a=b](x)", "![=](x)"}) {
+    Parser parser;
+    ParseTree tree = parser.GenerateParseTree(content);
+
+    const ParseTreeNode* paragraph = tree.GetRoot()->GetChildren()[0];
+    ASSERT_EQ(paragraph->GetChildren().size(), 1);
+    EXPECT_EQ(paragraph->GetChildren()[0]->GetNodeType(),
+              ParseTreeNode::IMAGE);
+  }
+}
+
+TEST(ParserTest, DecorationsBeyondMaxNestingDepthEndAtParagraph) {
+  // Opening markers that are never closed; The ones beyond the limit are a
+  // text.
+  std::string content;
+  for (int i = 0; i <= Parser::kMaxNestingDepth; i++) {
+    content += i % 2 == 0 ? "~~a" : "**a";
+  }
+  content += "\n\n**b**";
+
+  Parser parser;
+  ParseTree tree = parser.GenerateParseTree(content);
+  ASSERT_EQ(tree.GetRoot()->GetChildren().size(), 2);
+
+  const ParseTreeNode* second = tree.GetRoot()->GetChildren()[1];
+  ASSERT_EQ(second->GetChildren().size(), 1);
+  EXPECT_EQ(second->GetChildren()[0]->GetNodeType(), ParseTreeNode::BOLD);
+}
+
+TEST(ParserTest, DeeplyNestedSyntax) {
+  for (std::string_view unit : {"![", "[", "\\sidenote{", "```note\n",
+                                "**a *b ~~c "}) {
+    std::string content;
+    while (content.size() < 100000) {
+      content.append(unit);
+    }
+
+    // Should neither overflow the stack nor take forever.
+    Parser parser;
+    ParseTree tree = parser.GenerateParseTree(content);
+    EXPECT_FALSE(tree.GetRoot()->GetChildren().empty());
+  }
+}
+
 }  // namespace
 }  // namespace md2
@@ -10,16 +10,30 @@ namespace {
 
 using json = nlohmann::json;
 
-ConvertMarkdownToHtmlResponse Convert(const zmq::message_t& msg) {
-  json js = json::parse(msg.to_string_view());
+struct Response {
+  std::string html;
 
-  ConvertMarkdownToHtmlResponse resp;
+  bool is_ok;
+  std::string error_msg;
+};
+
+Response Convert(const std::vector<zmq::message_t>& frames) {
+  json js = json::parse(frames.at(0).to_string_view());
+
+  Response resp;
   resp.is_ok = js["result"].get<bool>();
 
-  if (resp.is_ok) {
+  if (!resp.is_ok) {
+    resp.error_msg = js["reason"].get<std::string>();
+  } else if (js.count("payload")) {
+    EXPECT_EQ(frames.size(), 1);
     resp.html = js["payload"].get<std::string>();
   } else {
-    resp.error_msg = js["reason"].get<std::string>();
+    // Multipart; The html is the concatenation of the rest of the frames.
+    for (size_t i = 1; i < frames.size(); i++) {
+      resp.html.append(frames[i].to_string_view());
+    }
+    EXPECT_EQ(resp.html.size(), js["payload_size"].get<size_t>());
   }
 
   return resp;
@@ -41,6 +55,73 @@ TEST(ServerTest, GetResponse) {
             "class='font-italic'>world!</span></p>");
 }
 
+TEST(ServerTest, Multipart) {
+  std::string markdown;
+  for (int i = 0; i < 10000; i++) {
+    markdown += "some **text** <a> & [link](url)\n\n";
+  }
+
+  json request = {{"request_name", "ConvertMarkdownToHtml"},
+                  {"markdown", markdown}};
+  MarkdownServer server;
+  const std::vector<zmq::message_t> single = server.HandleRequest(request);
+
+  request["multipart"] = true;
+  const std::vector<zmq::message_t> multipart = server.HandleRequest(request);
+
+  // The html is larger than a chunk.
+  EXPECT_GT(multipart.size(), 2);
+  EXPECT_TRUE(Convert(multipart).is_ok);
+  EXPECT_EQ(Convert(multipart).html, Convert(single).html);
+}
+
+TEST(ServerTest, ApplyEdit) {
+  json request = R"({
+    "request_name" : "ConvertMarkdownToHtml",
+    "markdown" : "**hello**\n\n*world*\n\nlast"
+  }
+  )"_json;
+
+  MarkdownServer server;
+  EXPECT_TRUE(Convert(server.HandleRequest(request)).is_ok);
+
+  // "*world*" -> "**world**".
+  request["markdown"] = "**hello**\n\n**world**\n\nlast";
+  request["edit"] = {{"start", 11}, {"old_end", 18}, {"new_end", 20}};
+  auto response = Convert(server.HandleRequest(request));
+
+  request.erase("edit");
+  MarkdownServer fresh_server;
+  auto expected = Convert(fresh_server.HandleRequest(request));
+
+  EXPECT_TRUE(response.is_ok);
+  EXPECT_EQ(response.html, expected.html);
+}
+
+TEST(ServerTest, MismatchedEditIsParsedFromScratch) {
+  json request = R"({
+    "request_name" : "ConvertMarkdownToHtml",
+    "markdown" : "**hello**\n\n*world*\n\nlast"
+  }
+  )"_json;
+
+  MarkdownServer server;
+  EXPECT_TRUE(Convert(server.HandleRequest(request)).is_ok);
+
+  // The range is valid but the text before the edit is changed as well
+  // ("hello" -> "bye").
+  request["markdown"] = "**bye**\n\n*world*\n\nlast!!";
+  request["edit"] = {{"start", 20}, {"old_end", 24}, {"new_end", 24}};
+  auto response = Convert(server.HandleRequest(request));
+
+  request.erase("edit");
+  MarkdownServer fresh_server;
+  auto expected = Convert(fresh_server.HandleRequest(request));
+
+  EXPECT_TRUE(response.is_ok);
+  EXPECT_EQ(response.html, expected.html);
+}
+
 TEST(ServerTest, FailOnInvalidRequest) {
   json request = R"({
     "request_name" : "ConvertMarkdownToHtml"
@@ -0,0 +1,53 @@
+#include "sharded_map.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+using ::testing::IsNull;
+using ::testing::Pointee;
+
+TEST(ShardedMapTest, FindOrInsert) {
+  ShardedMap<std::string, int> map;
+  EXPECT_THAT(map.Find("a"), IsNull());
+
+  int num_computed = 0;
+  auto compute = [&num_computed]() { return ++num_computed; };
+
+  EXPECT_EQ(map.FindOrInsert("a", compute), 1);
+  EXPECT_EQ(map.FindOrInsert("b", compute), 2);
+  EXPECT_EQ(map.FindOrInsert("a", compute), 1);
+  EXPECT_EQ(num_computed, 2);
+
+  EXPECT_THAT(map.Find("b"), Pointee(2));
+}
+
+TEST(ShardedMapTest, ConcurrentInsert) {
+  ShardedMap<int, int> map;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&map]() {
+      for (int i = 0; i < 1000; i++) {
+        map.FindOrInsert(i, [i]() { return i * 2; });
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_THAT(map.Find(i), Pointee(i * 2));
+  }
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,41 @@
+#include "generators/special_char_scan.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+// 16 characters over 8 high nibbles (including the bytes with the high bit).
+constexpr std::string_view kFullChars = "\x01\t !09[_apz~\x80\x8f\xf0\xff";
+constexpr SpecialCharSet kFullSet(kFullChars);
+
+constexpr SpecialCharSet kEmptySet("");
+
+TEST(SpecialCharScanTest, Contains) {
+  for (int b = 0; b < 256; b++) {
+    const char c = static_cast<char>(b);
+    EXPECT_EQ(kFullSet.Contains(c),
+              kFullChars.find(c) != std::string_view::npos)
+        << b;
+    EXPECT_FALSE(kEmptySet.Contains(c)) << b;
+  }
+}
+
+TEST(SpecialCharScanTest, EveryByteAtEveryPosition) {
+  // Covers the both sides of the 16 and 32 byte blocks.
+  for (int b = 0; b < 256; b++) {
+    for (size_t pos : {0, 5, 15, 16, 31, 32, 40, 63, 64, 70}) {
+      std::string s(72, 'b');
+      s[pos] = static_cast<char>(b);
+      const bool special = kFullSet.Contains(static_cast<char>(b));
+      EXPECT_EQ(FindSpecialChar(s, kFullSet), special ? pos : s.size())
+          << b << " " << pos;
+      EXPECT_EQ(FindSpecialChar(s, kEmptySet), s.size()) << b << " " << pos;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,73 @@
+#include "static_set.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+constexpr CharSet kChars("*`\\|{}");
+
+constexpr auto kKeywords = MakeStaticStringSet(
+    {"class", "const", "constexpr", "int", "long", "if", "else", "while"});
+
+constexpr auto kNumbers =
+    MakeStaticStringMap<int>({{"one", 1}, {"two", 2}, {"three", 3}});
+
+// Lookups are usable at compile time.
+static_assert(kChars.Contains('|'));
+static_assert(!kChars.Contains('a'));
+static_assert(kKeywords.Contains("constexpr"));
+static_assert(!kKeywords.Contains("cons"));
+static_assert(kNumbers.Find("two")->second == 2);
+static_assert(kNumbers.MaxKeySize() == 5);
+
+TEST(StaticSetTest, CharSet) {
+  for (int c = 0; c < 256; c++) {
+    EXPECT_EQ(kChars.Contains(static_cast<char>(c)),
+              std::string_view("*`\\|{}").find(static_cast<char>(c)) !=
+                  std::string_view::npos);
+  }
+}
+
+TEST(StaticSetTest, StringSet) {
+  for (std::string_view key :
+       {"class", "const", "constexpr", "int", "long", "if", "else", "while"}) {
+    EXPECT_TRUE(kKeywords.Contains(key)) << key;
+
+    // Not a key even though it may land on the same slot.
+    EXPECT_FALSE(kKeywords.Contains(std::string(key) + "x")) << key;
+    EXPECT_FALSE(kKeywords.Contains(key.substr(1))) << key;
+  }
+  EXPECT_FALSE(kKeywords.Contains(""));
+}
+
+TEST(StaticSetTest, ManyKeys) {
+  static constexpr auto kSet = MakeStaticStringSet(
+      {"a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "a8", "a9", "b0", "b1",
+       "b2", "b3", "b4", "b5", "b6", "b7", "b8", "b9", "c0", "c1", "c2", "c3",
+       "c4", "c5", "c6", "c7", "c8", "c9", "d0", "d1", "d2", "d3", "d4", "d5",
+       "d6", "d7", "d8", "d9", "e0", "e1", "e2", "e3", "e4", "e5", "e6", "e7"});
+
+  for (char c = 'a'; c <= 'z'; c++) {
+    for (char d = '0'; d <= '9'; d++) {
+      const std::string key = {c, d};
+      EXPECT_EQ(kSet.Contains(key), c < 'e' || (c == 'e' && d <= '7')) << key;
+    }
+  }
+}
+
+TEST(StaticSetTest, StringMap) {
+  EXPECT_EQ(kNumbers.Find("one")->second, 1);
+  EXPECT_EQ(kNumbers.Find("three")->second, 3);
+  EXPECT_EQ(kNumbers.Find("four"), nullptr);
+
+  // The key points to the string of the map rather than the argument.
+  const std::string key = "two";
+  EXPECT_NE(kNumbers.Find(key)->first.data(), key.data());
+  EXPECT_EQ(kNumbers.Find(key)->first, "two");
+}
+
+}  // namespace
+}  // namespace md2
@@ -0,0 +1,104 @@
+#include "structural_index.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+// Returns every structural position by following NextStructural.
+std::vector<size_t> CollectStructural(std::string_view content) {
+  StructuralIndex index(content);
+
+  std::vector<size_t> positions;
+  for (size_t pos = index.NextStructural(0); pos < content.size();
+       pos = index.NextStructural(pos + 1)) {
+    positions.push_back(pos);
+  }
+  return positions;
+}
+
+// Reference implementation.
+std::vector<size_t> CollectStructuralByteByByte(std::string_view content) {
+  std::vector<size_t> positions;
+  for (size_t pos = 0; pos < content.size(); pos++) {
+    if (StructuralIndex::IsStructuralChar(content[pos])) {
+      positions.push_back(pos);
+    }
+  }
+  return positions;
+}
+
+TEST(StructuralIndexTest, Simple) {
+  EXPECT_THAT(CollectStructural("ab *c* d"), ::testing::ElementsAre(3, 5));
+  EXPECT_THAT(CollectStructural("1. a\n"), ::testing::ElementsAre(0, 4));
+  EXPECT_THAT(CollectStructural("abc"), ::testing::ElementsAre());
+  EXPECT_THAT(CollectStructural(""), ::testing::ElementsAre());
+}
+
+TEST(StructuralIndexTest, KoreanText) {
+  std::string content = "안녕하세요 **반갑습니다** [링크](a.com)";
+  EXPECT_EQ(CollectStructural(content), CollectStructuralByteByByte(content));
+}
+
+TEST(StructuralIndexTest, AcrossWordBoundary) {
+  // Long enough to span multiple 64 bit words and have an unaligned tail.
+  std::string content;
+  for (int i = 0; i < 50; i++) {
+    content += "가나다 `code` ~~s~~ $$x$$ \\[y\\] > #|{}! 0123456789\n";
+  }
+  content += "tail*";
+
+  EXPECT_EQ(CollectStructural(content), CollectStructuralByteByByte(content));
+}
+
+TEST(StructuralIndexTest, Window) {
+  std::string content(300, 'a');
+  content[10] = '*';
+  content[120] = '*';
+  content[250] = '\n';
+
+  // Only [100, 200) is indexed; Outside of it, every position is structural.
+  const StructuralIndex index(content, 100, 200);
+  EXPECT_EQ(index.NextStructural(5), 5);
+  EXPECT_EQ(index.NextStructural(100), 120);
+  EXPECT_EQ(index.NextStructural(121), 200);
+  EXPECT_EQ(index.NextStructural(220), 220);
+  EXPECT_EQ(index.NextStructural(300), 300);
+  EXPECT_TRUE(index.IsStructural(50));
+  EXPECT_TRUE(index.IsStructural(120));
+  EXPECT_FALSE(index.IsStructural(121));
+  EXPECT_TRUE(index.IsStructural(210));
+
+  // Window that ends past the content.
+  const StructuralIndex tail(content, 240, 1000);
+  EXPECT_EQ(tail.NextStructural(240), 250);
+  EXPECT_EQ(tail.NextStructural(251), 300);
+}
+
+TEST(StructuralIndexTest, NextStructural) {
+  std::string content(200, 'a');
+  content[70] = '*';
+  content[199] = '\n';
+
+  StructuralIndex index(content);
+  EXPECT_EQ(index.NextStructural(0), 70);
+  EXPECT_EQ(index.NextStructural(70), 70);
+  EXPECT_EQ(index.NextStructural(71), 199);
+  EXPECT_EQ(index.NextStructural(200), 200);
+  EXPECT_TRUE(index.IsStructural(70));
+  EXPECT_FALSE(index.IsStructural(71));
+}
+
+TEST(StructuralIndexTest, IsIndexOf) {
+  std::string content = "abc";
+  StructuralIndex index(content);
+
+  EXPECT_TRUE(index.IsIndexOf(content));
+  EXPECT_FALSE(index.IsIndexOf(std::string_view(content).substr(1)));
+}
+
+}  // namespace
+}  // namespace md2
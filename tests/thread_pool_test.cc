@@ -0,0 +1,153 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::IsEmpty;
+
+TEST(ThreadPoolTest, RunAllTasks) {
+  ThreadPool pool(4);
+
+  std::atomic<int> sum = 0;
+  for (int i = 1; i <= 1000; i++) {
+    pool.Submit([&sum, i]() { sum += i; });
+  }
+
+  EXPECT_THAT(pool.WaitAll(), IsEmpty());
+  EXPECT_EQ(sum, 500500);
+}
+
+TEST(ThreadPoolTest, NestedSubmit) {
+  ThreadPool pool(2);
+
+  std::atomic<int> count = 0;
+  for (int i = 0; i < 10; i++) {
+    pool.Submit([&pool, &count]() {
+      for (int j = 0; j < 10; j++) {
+        pool.Submit([&count]() { count++; });
+      }
+    });
+  }
+
+  EXPECT_THAT(pool.WaitAll(), IsEmpty());
+  EXPECT_EQ(count, 100);
+}
+
+TEST(ThreadPoolTest, WaitInsideOfTask) {
+  // Every worker waits for its own subtasks; With a single worker, the
+  // subtasks only run if the waiting task runs them.
+  ThreadPool pool(1);
+
+  std::atomic<int> count = 0;
+  pool.Submit([&pool, &count]() {
+    TaskGroup group;
+    for (int i = 0; i < 10; i++) {
+      pool.Submit([&count]() { count++; }, &group);
+    }
+    pool.Wait(group);
+    EXPECT_EQ(count, 10);
+  });
+
+  EXPECT_THAT(pool.WaitAll(), IsEmpty());
+  EXPECT_EQ(count, 10);
+}
+
+TEST(ThreadPoolTest, WaitDoesNotRunOtherTasks) {
+  ThreadPool pool(1);
+
+  std::atomic<bool> other_done = false;
+  pool.Submit([&pool, &other_done]() {
+    TaskGroup group;
+    std::vector<int> order;
+    for (int i = 0; i < 3; i++) {
+      pool.Submit([&order, i]() { order.push_back(i); }, &group);
+    }
+    pool.Wait(group);
+
+    // The latest task runs first, and the task that is queued before this
+    // one is not run while waiting.
+    EXPECT_THAT(order, ElementsAre(2, 1, 0));
+    EXPECT_FALSE(other_done);
+  });
+  pool.Submit([&other_done]() { other_done = true; });
+
+  EXPECT_THAT(pool.WaitAll(), IsEmpty());
+  EXPECT_TRUE(other_done);
+}
+
+TEST(ThreadPoolTest, WaitOutsideOfPool) {
+  ThreadPool pool(4);
+
+  TaskGroup group;
+  std::atomic<int> count = 0;
+  for (int i = 0; i < 100; i++) {
+    pool.Submit([&count]() { count++; }, &group);
+  }
+  size_t failed =
+      pool.Submit([]() { throw std::runtime_error("oops"); }, &group);
+
+  // The failed task is still counted as finished.
+  pool.Wait(group);
+  EXPECT_EQ(count, 100);
+  EXPECT_THAT(pool.WaitAll(), ElementsAre(Field(&TaskError::task_id, failed)));
+}
+
+TEST(ThreadPoolTest, ReportErrors) {
+  ThreadPool pool(3);
+
+  pool.Submit([]() {});
+  size_t failed = pool.Submit([]() { throw std::runtime_error("oops"); });
+  pool.Submit([]() {});
+
+  EXPECT_THAT(pool.WaitAll(),
+              ElementsAre(AllOf(Field(&TaskError::task_id, failed),
+                                Field(&TaskError::message, "oops"))));
+
+  // Errors are cleared after WaitAll.
+  EXPECT_THAT(pool.WaitAll(), IsEmpty());
+}
+
+TEST(ThreadPoolTest, SubmitByCost) {
+  // With a single worker, the tasks run in the order of the cost.
+  ThreadPool pool(1);
+
+  std::vector<int> costs = {3, 10, 1, 7, 7};
+  std::vector<int> order;
+  std::vector<size_t> ids = pool.SubmitByCost(
+      costs, [&order](int cost) { order.push_back(cost); },
+      [](int cost) { return cost; });
+
+  EXPECT_THAT(pool.WaitAll(), IsEmpty());
+  EXPECT_THAT(order, ElementsAre(10, 7, 7, 3, 1));
+  EXPECT_EQ(ids.size(), 5);
+}
+
+TEST(TaskTest, LargeAndMoveOnlyCapture) {
+  auto value = std::make_unique<int>(3);
+  std::array<char, 256> large{};
+  large[0] = 2;
+
+  int result = 0;
+  Task task([&result, value = std::move(value), large]() {
+    result = *value + large[0];
+  });
+
+  Task moved = std::move(task);
+  EXPECT_FALSE(task);
+  ASSERT_TRUE(moved);
+
+  moved();
+  EXPECT_EQ(result, 5);
+}
+
+}  // namespace
+}  // namespace md2
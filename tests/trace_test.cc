@@ -0,0 +1,103 @@
+#include "trace.h"
+
+#include <nlohmann/json.hpp>
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace md2 {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+std::vector<Tracer::Span> GetSpansOf(std::string_view file) {
+  std::vector<Tracer::Span> spans;
+  for (auto& span : Tracer::GetTracer().GetSpans()) {
+    if (span.file == file) {
+      spans.push_back(std::move(span));
+    }
+  }
+  return spans;
+}
+
+TEST(TraceTest, NestedSpanInheritsFile) {
+  Tracer::GetTracer().Enable();
+
+  {
+    TRACE_SCOPE("parse", "trace_test_1.md");
+    TRACE_SCOPE("highlight");
+  }
+
+  std::vector<Tracer::Span> spans = GetSpansOf("trace_test_1.md");
+  ASSERT_EQ(spans.size(), 2);
+
+  // Inner span ends first.
+  EXPECT_STREQ(spans[0].name, "highlight");
+  EXPECT_EQ(spans[0].depth, 1);
+  EXPECT_STREQ(spans[1].name, "parse");
+  EXPECT_EQ(spans[1].depth, 0);
+  EXPECT_LE(spans[1].start, spans[0].start);
+  EXPECT_GE(spans[1].end, spans[0].end);
+}
+
+TEST(TraceTest, SpansFromMultipleThreads) {
+  Tracer::GetTracer().Enable();
+
+  std::thread t1([]() { TRACE_SCOPE("html", "trace_test_2.md"); });
+  std::thread t2([]() { TRACE_SCOPE("latex", "trace_test_2.md"); });
+  t1.join();
+  t2.join();
+
+  std::vector<Tracer::Span> spans = GetSpansOf("trace_test_2.md");
+  ASSERT_EQ(spans.size(), 2);
+  EXPECT_NE(spans[0].thread_index, spans[1].thread_index);
+}
+
+TEST(TraceTest, DumpAsChromeTrace) {
+  Tracer::GetTracer().Enable();
+
+  { TRACE_SCOPE("write", "/out/trace_test_3.html"); }
+
+  auto trace = nlohmann::json::parse(Tracer::GetTracer().DumpAsChromeTrace());
+  bool found = false;
+  for (const auto& event : trace["traceEvents"]) {
+    if (event.contains("args") &&
+        event["args"]["file"] == "/out/trace_test_3.html") {
+      EXPECT_EQ(event["name"], "write");
+      EXPECT_EQ(event["ph"], "X");
+      EXPECT_GE(event["dur"].get<int64_t>(), 0);
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(TraceTest, SlowestFilesAreGroupedByStem) {
+  Tracer& tracer = Tracer::GetTracer();
+  tracer.Enable();
+
+  auto now = Tracer::Clock::now();
+  auto add_span = [&](const char* name, std::string file, int ms) {
+    tracer.AddSpan(Tracer::Span{.name = name,
+                                .file = std::move(file),
+                                .start = now,
+                                .end = now + std::chrono::hours(ms),
+                                .thread_index = 0,
+                                .depth = 0});
+  };
+
+  // Use hours so that the spans from the other tests do not matter.
+  add_span("parse", "trace_test_slow.md", 2);
+  add_span("write", "/out/trace_test_slow.html", 1);
+  add_span("parse", "trace_test_fast.md", 2);
+
+  EXPECT_THAT(
+      tracer.GetSlowestFiles(2),
+      ElementsAre(Pair("trace_test_slow", std::chrono::hours(3)),
+                  Pair("trace_test_fast", std::chrono::hours(2))));
+}
+
+}  // namespace
+}  // namespace md2